@@ -30,6 +30,7 @@
 #include "util.hpp"
 #include <3ds.h>
 #include <string>
+#include <utility>
 
 class KeyboardManager {
 public:
@@ -44,8 +45,10 @@ public:
 
     std::u16string keyboard(const std::string& suggestion);
     int numericPad(void);
+    std::pair<bool, std::string> search(const std::string& query);
 
     static const size_t CUSTOM_PATH_LEN = 20;
+    static const size_t SEARCH_LEN      = 32;
 
 private:
     KeyboardManager(void);
@@ -30,6 +30,7 @@
 #include "CheatManagerOverlay.hpp"
 #include "ErrorOverlay.hpp"
 #include "InfoOverlay.hpp"
+#include "KeyboardManager.hpp"
 #include "Screen.hpp"
 #include "YesNoOverlay.hpp"
 #include "clickable.hpp"
@@ -61,12 +62,15 @@ private:
     Hid<HidDirection::HORIZONTAL, HidDirection::VERTICAL> hid;
     std::unique_ptr<Clickable> buttonBackup, buttonRestore, buttonCheats, buttonPlayCoins;
     std::unique_ptr<Scrollable> directoryList;
+    // what the backup list was last built from
+    mutable std::tuple<u64, Mode_t, u32> directoryListKey;
+    mutable size_t directoryListIndex;
     char ver[10];
 
     C2D_Text ins1, ins2, ins3, ins4, c2dId, c2dMediatype;
     C2D_Text checkpoint, version;
     // instructions text
-    C2D_Text top_move, top_a, top_y, top_my, top_b, bot_ts, bot_x, coins;
+    C2D_Text top_move, top_a, top_y, top_my, top_b, top_search, bot_ts, bot_x, coins;
     C2D_TextBuf dynamicBuf, staticBuf;
 
     const float scaleInst = 0.7f;
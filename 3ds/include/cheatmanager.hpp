@@ -27,11 +27,11 @@
 #ifndef CHEATMANAGER_HPP
 #define CHEATMANAGER_HPP
 
+#include "cheatdatabase.hpp"
 #include "io.hpp"
-#include "json.hpp"
 #include "main.hpp"
 #include <3ds.h>
-#include <bzlib.h>
+#include <atomic>
 #include <stdio.h>
 #include <sys/stat.h>
 
@@ -46,10 +46,11 @@ public:
     }
 
     bool areCheatsAvailable(const std::string& key);
+    std::shared_ptr<CheatBlock> cheats(const std::string& key);
+    void load(void);
+    bool loaded(void) { return mLoaded; }
     void save(const std::string& key, const std::vector<std::string>& s);
 
-    std::shared_ptr<nlohmann::json> cheats(void) { return mCheats; }
-
 private:
     CheatManager(void);
     ~CheatManager(void){};
@@ -57,7 +58,12 @@ private:
     CheatManager(CheatManager const&) = delete;
     void operator=(CheatManager const&) = delete;
 
-    std::shared_ptr<nlohmann::json> mCheats;
+    CheatDatabase mDatabase;
+    // set by the loader thread once the index is usable
+    std::atomic<bool> mLoaded;
+    // last decompressed title, reused by save
+    std::string mBlockKey;
+    std::shared_ptr<CheatBlock> mBlock;
 };
 
 #endif
\ No newline at end of file
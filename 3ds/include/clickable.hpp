@@ -39,7 +39,9 @@ public:
     Clickable(int x, int y, u16 w, u16 h, u32 colorBg, u32 colorText, std::string message, bool centered)
         : IClickable(x, y, w, h, colorBg, colorText, message, centered)
     {
-        mTextBuf = C2D_TextBufNew(64);
+        // a glyph takes at least one byte, so the buffer never needs more glyphs than the text has bytes
+        mGlyphs  = message.size() > 64 ? message.size() : 64;
+        mTextBuf = C2D_TextBufNew(mGlyphs);
         C2D_TextParse(&mC2dText, mTextBuf, message.c_str());
         C2D_TextOptimize(&mC2dText);
     }
@@ -50,11 +52,13 @@ public:
     void drawOutline(u32 color) override;
     bool held(void) override;
     bool released(void) override;
-    void c2dText(const std::string& text);
+    using IClickable::text;
+    void text(const std::string& v) override;
 
 protected:
     C2D_Text mC2dText;
     C2D_TextBuf mTextBuf;
+    size_t mGlyphs;
 };
 
 #endif
\ No newline at end of file
@@ -29,9 +29,8 @@
 
 #include "io.hpp"
 #include "json.hpp"
+#include "snapshot.hpp"
 #include "util.hpp"
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #define CONFIG_VERSION 3
@@ -48,24 +47,31 @@ public:
     bool favorite(u64 id);
     bool nandSaves(void);
     bool shouldScanCard(void);
-    std::vector<std::u16string> additionalSaveFolders(u64 id);
-    std::vector<std::u16string> additionalExtdataFolders(u64 id);
+    // valid until the application exits
+    Span<std::u16string> additionalSaveFolders(u64 id);
+    Span<std::u16string> additionalExtdataFolders(u64 id);
 
 private:
     Configuration(void);
     ~Configuration(void){};
 
     void store(void);
+    void parse(void);
     nlohmann::json loadJson(const std::string& path);
     void storeJson(nlohmann::json& json, const std::string& path);
 
     Configuration(Configuration const&) = delete;
     void operator=(Configuration const&) = delete;
 
+    // everything read after startup, compiled from the json
+    struct Snapshot {
+        IdSet filterIds, favoriteIds;
+        FolderTable<std::u16string> additionalSaveFolders, additionalExtdataFolders;
+        bool nandSaves, scanCard;
+    };
+
     nlohmann::json mJson;
-    std::unordered_set<u64> mFilterIds, mFavoriteIds;
-    std::unordered_map<u64, std::vector<std::u16string>> mAdditionalSaveFolders, mAdditionalExtdataFolders;
-    bool mNandSaves, mScanCard;
+    SnapshotHolder<Snapshot> mSnapshot;
     std::string BASEPATH = "/3ds/Checkpoint/config.json";
 };
 
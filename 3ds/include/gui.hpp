@@ -44,6 +44,13 @@ namespace Gui {
     void exit(void);
     void frameEnd(void);
 
+    // The static part of each screen is drawn into a texture only when something changed. Pulsing outlines drawn while the
+    // cache is filled are recorded and replayed over it every frame, so that they keep animating
+    bool hasCache(void);
+    void beginCache(gfxScreen_t screen);
+    void dropAnimations(void);
+    void drawCache(gfxScreen_t screen);
+
     void drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color);
     void drawOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color);
 
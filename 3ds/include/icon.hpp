@@ -0,0 +1,46 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef ICON_HPP
+#define ICON_HPP
+
+#include <3ds.h>
+#include <citro2d.h>
+
+namespace Icon {
+    // start of a DS banner, Image::decodeDS turns the icon into a texture
+    struct DSBanner {
+        u16 version;
+        u16 crc;
+        u8 reserved[28];
+        u8 data[512];
+        u16 palette[16];
+    };
+
+    // the 48x48 SMDH icon is already RGB565 in GPU tile order, it only needs to be copied into a 64x64 texture
+    C2D_Image fromSMDH(const void* bigIconData);
+}
+
+#endif
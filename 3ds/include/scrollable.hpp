@@ -44,11 +44,12 @@ public:
     void c2dText(size_t i, const std::string& v);
     void draw(bool condition = false) override;
     void setIndex(size_t i);
-    void push_back(u32 color, u32 colorMessage, const std::string& message, bool selected) override;
     void resetIndex(void) override;
     void updateSelection(void) override;
 
 protected:
+    IClickable<u32>* newCell(size_t i) override;
+
     Hid<HidDirection::VERTICAL, HidDirection::HORIZONTAL> mHid;
 };
 
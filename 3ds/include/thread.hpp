@@ -27,13 +27,16 @@
 #ifndef THREAD_HPP
 #define THREAD_HPP
 
+#include "cheatmanager.hpp"
 #include "title.hpp"
 #include <3ds.h>
 #include <vector>
 
 namespace Threads {
+    void cheats(void);
     void create(ThreadFunc entrypoint);
     void destroy(void);
+    void logger(void);
     void titles(void);
 }
 
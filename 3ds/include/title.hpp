@@ -37,49 +37,46 @@
 #include "spi.hpp"
 #include "util.hpp"
 #include <algorithm>
+#include <atomic>
 #include <citro2d.h>
 #include <string>
 #include <vector>
 
-extern "C" {
-#include "sha256.h"
-}
-
 #define TID_PKSM 0x000400000EC10000
 
 class Title {
 public:
     ~Title(void);
 
-    bool accessibleSave(void);
-    bool accessibleExtdata(void);
-    FS_CardType cardType(void);
-    std::vector<std::u16string> extdata(void);
-    u32 extdataId(void);
-    std::u16string extdataPath(void);
-    std::u16string fullExtdataPath(size_t index);
-    u32 highId(void);
-    C2D_Image icon(void);
-    u64 id(void);
-    bool isActivityLog(void);
+    bool accessibleSave(void) const;
+    bool accessibleExtdata(void) const;
+    FS_CardType cardType(void) const;
+    std::vector<std::u16string> extdata(void) const;
+    u32 extdataId(void) const;
+    std::u16string extdataPath(void) const;
+    std::u16string fullExtdataPath(size_t index) const;
+    u32 highId(void) const;
+    C2D_Image icon(void) const;
+    u64 id(void) const;
+    bool isActivityLog(void) const;
     void load(void);
     bool load(u64 id, FS_MediaType mediaType, FS_CardType cardType);
     void load(u64 id, u8* productCode, bool accessibleSave, bool accessibleExtdata, std::u16string shortDescription, std::u16string longDescription,
         std::u16string savePath, std::u16string extdataPath, FS_MediaType media, FS_CardType cardType, CardType card);
-    std::string longDescription(void);
-    std::u16string getLongDescription(void);
-    u32 lowId(void);
-    FS_MediaType mediaType(void);
-    std::string mediaTypeString(void);
+    std::string longDescription(void) const;
+    std::u16string getLongDescription(void) const;
+    u32 lowId(void) const;
+    FS_MediaType mediaType(void) const;
+    std::string mediaTypeString(void) const;
     void refreshDirectories(void);
-    std::u16string savePath(void);
-    std::u16string fullSavePath(size_t index);
-    std::vector<std::u16string> saves(void);
+    std::u16string savePath(void) const;
+    std::u16string fullSavePath(size_t index) const;
+    std::vector<std::u16string> saves(void) const;
     void setIcon(C2D_Image icon);
-    std::string shortDescription(void);
-    std::u16string getShortDescription(void);
-    CardType SPICardType(void);
-    u32 uniqueId(void);
+    std::string shortDescription(void) const;
+    std::u16string getShortDescription(void) const;
+    CardType SPICardType(void) const;
+    u32 uniqueId(void) const;
 
     char productCode[16];
 
@@ -103,13 +100,22 @@ private:
 };
 
 void getTitle(Title& dst, int i);
+// the title shown at i without copying it, valid until the title list changes
+const Title* titleAt(int i);
 int getTitleCount(void);
 C2D_Image icon(int i);
 bool favorite(int i);
+// narrows the titles seen through getTitle and the other accessors, an empty query shows all of them
+void setTitleFilter(const std::string& query);
+// main thread only, matches the filter against the lists indexed by the last load. True when the views changed
+bool refreshTitleFilter(void);
+std::string getTitleFilter(void);
 
 void loadFilter(void);
 void loadTitles(bool forceRefresh);
 void refreshDirectories(u64 id);
 void updateCard(void);
+// changes every time the backup list of a title is refreshed
+u32 getDirectoriesGeneration(void);
 
 #endif
\ No newline at end of file
@@ -47,14 +47,16 @@ CheatManagerOverlay::CheatManagerOverlay(Screen& screen, const std::string& mkey
     size_t i     = 0;
     currentIndex = i;
     scrollable   = std::make_unique<Scrollable>(2, 2, 396, 220, 11);
-    auto cheats  = *CheatManager::getInstance().cheats().get();
-    for (auto it = cheats[key].begin(); it != cheats[key].end(); ++it) {
-        std::string value = it.key();
-        if (existingCheat.find(value) != std::string::npos) {
-            value = SELECTED_MAGIC + value;
+    auto cheats  = CheatManager::getInstance().cheats(key);
+    if (cheats != nullptr && cheats->builds() > 0) {
+        for (u32 j = 0; j < cheats->cheats(0); j++) {
+            std::string value = cheats->cheatName(0, j);
+            if (existingCheat.find(value) != std::string::npos) {
+                value = SELECTED_MAGIC + value;
+            }
+            scrollable->push_back(COLOR_GREY_DARKER, COLOR_WHITE, value, i == 0);
+            i++;
         }
-        scrollable->push_back(COLOR_GREY_DARKER, COLOR_WHITE, value, i == 0);
-        i++;
     }
 
     staticBuf  = C2D_TextBufNew(48);
@@ -21,6 +21,18 @@ int KeyboardManager::numericPad(void)
     return button == SWKBD_BUTTON_CONFIRM ? atoi(buf) : -1;
 }
 
+std::pair<bool, std::string> KeyboardManager::search(const std::string& query)
+{
+    static SwkbdState swkbd;
+    swkbdInit(&swkbd, SWKBD_TYPE_NORMAL, 2, SEARCH_LEN - 1);
+    swkbdSetHintText(&swkbd, "Search by name or title ID.");
+    swkbdSetInitialText(&swkbd, query.c_str());
+    char buf[SEARCH_LEN] = {0};
+    SwkbdButton button   = swkbdInputText(&swkbd, buf, SEARCH_LEN);
+    buf[SEARCH_LEN - 1]  = '\0';
+    return std::make_pair(button == SWKBD_BUTTON_CONFIRM, std::string(buf));
+}
+
 KeyboardManager::KeyboardManager(void)
 {
     swkbdInit(&mSwkbd, SWKBD_TYPE_NORMAL, 2, CUSTOM_PATH_LEN - 1);
@@ -46,6 +46,10 @@ MainScreen::MainScreen(void) : hid(rowlen * collen, collen)
     buttonCheats->canChangeColorWhenSelected(true);
     buttonPlayCoins->canChangeColorWhenSelected(true);
 
+    // generations start at 0 and are bumped by the first refresh, so this never matches a loaded title
+    directoryListKey   = std::make_tuple(0, MODE_SAVE, 0);
+    directoryListIndex = 0;
+
     sprintf(ver, "v%d.%d.%d", VERSION_MAJOR, VERSION_MINOR, VERSION_MICRO);
 
     C2D_TextParse(&ins1, staticBuf, "Hold SELECT to see commands. Press \uE002 for ");
@@ -62,6 +66,7 @@ MainScreen::MainScreen(void) : hid(rowlen * collen, collen)
     C2D_TextParse(&top_y, staticBuf, "\uE003 to multiselect a title");
     C2D_TextParse(&top_my, staticBuf, "\uE003 hold to multiselect all titles");
     C2D_TextParse(&top_b, staticBuf, "\uE001 to exit target or deselect all titles");
+    C2D_TextParse(&top_search, staticBuf, "SELECT + \uE003 to search titles");
     C2D_TextParse(&bot_ts, staticBuf, "\uE01D \uE006 to move\nbetween backups");
     C2D_TextParse(&bot_x, staticBuf, "\uE002 to delete backups");
     C2D_TextParse(&coins, staticBuf, "\uE075");
@@ -80,6 +85,7 @@ MainScreen::MainScreen(void) : hid(rowlen * collen, collen)
     C2D_TextOptimize(&top_y);
     C2D_TextOptimize(&top_my);
     C2D_TextOptimize(&top_b);
+    C2D_TextOptimize(&top_search);
     C2D_TextOptimize(&bot_ts);
     C2D_TextOptimize(&bot_x);
     C2D_TextOptimize(&coins);
@@ -99,10 +105,6 @@ void MainScreen::drawTop(void) const
     const size_t entries = hid.maxVisibleEntries();
     const size_t max     = hid.maxEntries(getTitleCount()) + 1;
 
-    C2D_TargetClear(g_top, COLOR_BG);
-    C2D_TargetClear(g_bottom, COLOR_BG);
-
-    C2D_SceneBegin(g_top);
     C2D_DrawRectSolid(0, 0, 0.5f, 400, 19, COLOR_GREY_DARK);
     C2D_DrawRectSolid(0, 221, 0.5f, 400, 19, COLOR_GREY_DARK);
 
@@ -139,11 +141,20 @@ void MainScreen::drawTop(void) const
         }
     }
 
-    static const float border = ceilf((400 - (ins1.width + ins2.width + ins3.width) * 0.47f) / 2);
-    C2D_DrawText(&ins1, C2D_WithColor, border, 223, 0.5f, 0.47f, 0.47f, COLOR_WHITE);
-    C2D_DrawText(
-        &ins2, C2D_WithColor, border + ceilf(ins1.width * 0.47f), 223, 0.5f, 0.47f, 0.47f, Archive::mode() == MODE_SAVE ? COLOR_WHITE : COLOR_RED);
-    C2D_DrawText(&ins3, C2D_WithColor, border + ceilf((ins1.width + ins2.width) * 0.47f), 223, 0.5f, 0.47f, 0.47f, COLOR_WHITE);
+    const std::string filter = getTitleFilter();
+    if (filter.empty()) {
+        static const float border = ceilf((400 - (ins1.width + ins2.width + ins3.width) * 0.47f) / 2);
+        C2D_DrawText(&ins1, C2D_WithColor, border, 223, 0.5f, 0.47f, 0.47f, COLOR_WHITE);
+        C2D_DrawText(&ins2, C2D_WithColor, border + ceilf(ins1.width * 0.47f), 223, 0.5f, 0.47f, 0.47f,
+            Archive::mode() == MODE_SAVE ? COLOR_WHITE : COLOR_RED);
+        C2D_DrawText(&ins3, C2D_WithColor, border + ceilf((ins1.width + ins2.width) * 0.47f), 223, 0.5f, 0.47f, 0.47f, COLOR_WHITE);
+    }
+    else {
+        C2D_Text searchText;
+        C2D_TextParse(&searchText, dynamicBuf, ("Search: " + filter + ". SELECT + \uE003 to change it.").c_str());
+        C2D_TextOptimize(&searchText);
+        C2D_DrawText(&searchText, C2D_WithColor, ceilf((400 - StringUtils::textWidth(searchText, 0.47f)) / 2), 223, 0.5f, 0.47f, 0.47f, COLOR_GOLD);
+    }
 
     if (hidKeysHeld() & KEY_SELECT) {
         const u32 inst_lh = scaleInst * fontGetInfo(NULL)->lineFeed;
@@ -159,6 +170,8 @@ void MainScreen::drawTop(void) const
             scaleInst, COLOR_WHITE);
         C2D_DrawText(&top_my, C2D_WithColor, ceilf((400 - StringUtils::textWidth(top_my, scaleInst)) / 2), inst_h + inst_lh * 4, 0.9f, scaleInst,
             scaleInst, COLOR_WHITE);
+        C2D_DrawText(&top_search, C2D_WithColor, ceilf((400 - StringUtils::textWidth(top_search, scaleInst)) / 2), inst_h + inst_lh * 5, 0.9f,
+            scaleInst, scaleInst, COLOR_WHITE);
     }
 
     C2D_DrawText(&version, C2D_WithColor, 400 - 4 - ceilf(0.45f * version.width), 3.0f, 0.5f, 0.45f, 0.45f, COLOR_GREY_LIGHT);
@@ -185,27 +198,41 @@ void MainScreen::drawBottom(void) const
 
     C2D_DrawRectSolid(0, 0, 0.5f, 320, 19, COLOR_GREY_DARK);
     C2D_DrawRectSolid(0, 221, 0.5f, 320, 19, COLOR_GREY_DARK);
-    if (getTitleCount() > 0) {
-        Title title;
-        getTitle(title, hid.fullIndex());
-
-        directoryList->flush();
-        std::vector<std::u16string> dirs = mode == MODE_SAVE ? title.saves() : title.extdata();
-        static std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
-
-        for (size_t i = 0; i < dirs.size(); i++) {
-            directoryList->push_back(COLOR_GREY_DARKER, COLOR_WHITE, convert.to_bytes(dirs.at(i)), i == directoryList->index());
+    const Title* title = titleAt(hid.fullIndex());
+    if (title != nullptr) {
+
+        // the list is only rebuilt when the title, the mode or the backups change, otherwise only the selection moves
+        const auto listKey = std::make_tuple(title->id(), mode, getDirectoriesGeneration());
+        if (listKey != directoryListKey) {
+            directoryListKey = listKey;
+            directoryList->flush();
+            std::vector<std::u16string> dirs = mode == MODE_SAVE ? title->saves() : title->extdata();
+            static std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
+
+            for (size_t i = 0; i < dirs.size(); i++) {
+                directoryList->push_back(COLOR_GREY_DARKER, COLOR_WHITE, convert.to_bytes(dirs.at(i)), i == directoryList->index());
+            }
+            directoryListIndex = directoryList->index();
+        }
+        else if (directoryListIndex != directoryList->index()) {
+            if (directoryListIndex < directoryList->size()) {
+                directoryList->selectRow(directoryListIndex, false);
+            }
+            if (directoryList->index() < directoryList->size()) {
+                directoryList->selectRow(directoryList->index(), true);
+            }
+            directoryListIndex = directoryList->index();
         }
 
         C2D_Text shortDesc, longDesc, id, prodCode, media;
 
         char lowid[18];
-        snprintf(lowid, 9, "%08X", (int)title.lowId());
+        snprintf(lowid, 9, "%08X", (int)title->lowId());
 
-        C2D_TextParse(&shortDesc, dynamicBuf, title.shortDescription().c_str());
-        C2D_TextParse(&longDesc, dynamicBuf, title.longDescription().c_str());
+        C2D_TextParse(&shortDesc, dynamicBuf, title->shortDescription().c_str());
+        C2D_TextParse(&longDesc, dynamicBuf, title->longDescription().c_str());
         C2D_TextParse(&id, dynamicBuf, lowid);
-        C2D_TextParse(&media, dynamicBuf, title.mediaTypeString().c_str());
+        C2D_TextParse(&media, dynamicBuf, title->mediaTypeString().c_str());
 
         C2D_TextOptimize(&shortDesc);
         C2D_TextOptimize(&longDesc);
@@ -222,7 +249,7 @@ void MainScreen::drawBottom(void) const
         C2D_DrawText(&c2dId, C2D_WithColor, 4, 31 + longDescHeight, 0.5f, 0.5f, 0.5f, COLOR_GREY_LIGHT);
         C2D_DrawText(&id, C2D_WithColor, 25, 31 + longDescHeight, 0.5f, 0.5f, 0.5f, COLOR_WHITE);
 
-        snprintf(lowid, 18, "(%s)", title.productCode);
+        snprintf(lowid, 18, "(%s)", title->productCode);
         C2D_TextParse(&prodCode, dynamicBuf, lowid);
         C2D_TextOptimize(&prodCode);
         C2D_DrawText(&prodCode, C2D_WithColor, 30 + lowidWidth, 32 + longDescHeight, 0.5f, 0.42f, 0.42f, COLOR_GREY_LIGHT);
@@ -230,21 +257,21 @@ void MainScreen::drawBottom(void) const
         C2D_DrawText(&media, C2D_WithColor, 75, 47 + longDescHeight, 0.5f, 0.5f, 0.5f, COLOR_WHITE);
 
         C2D_DrawRectSolid(260, 27, 0.5f, 52, 52, COLOR_BLACK);
-        if (title.icon().subtex->width == 48) {
-            C2D_DrawImageAt(title.icon(), 262, 29, 0.5f, NULL, 1.0f, 1.0f);
+        if (title->icon().subtex->width == 48) {
+            C2D_DrawImageAt(title->icon(), 262, 29, 0.5f, NULL, 1.0f, 1.0f);
         }
         else {
-            C2D_DrawImageAt(title.icon(), 262 + 8, 29 + 8, 0.5f, NULL, 1.0f, 1.0f);
+            C2D_DrawImageAt(title->icon(), 262 + 8, 29 + 8, 0.5f, NULL, 1.0f, 1.0f);
         }
 
         C2D_DrawRectSolid(4, 100, 0.5f, 312, 114, COLOR_GREY_DARK);
         directoryList->draw(g_bottomScrollEnabled);
         buttonBackup->draw(0.7, 0);
         buttonRestore->draw(0.7, 0);
-        if (title.isActivityLog()) {
+        if (title->isActivityLog()) {
             buttonPlayCoins->draw(0.7, 0);
         }
-        else {
+        else if (CheatManager::getInstance().loaded()) {
             buttonCheats->draw(0.7, 0);
         }
     }
@@ -288,6 +315,26 @@ void MainScreen::handleEvents(touchPosition* touch)
 {
     u32 kDown = hidKeysDown();
     u32 kHeld = hidKeysHeld();
+    // the search starts from the title grid, positions and selections refer to the filtered list
+    // the indexes are rebuilt while titles load, the search waits for them
+    if ((kHeld & KEY_SELECT) && (kDown & KEY_Y) && !g_bottomScrollEnabled && !g_isLoadingTitles) {
+        const std::string previous = getTitleFilter();
+        auto result                = KeyboardManager::get().search(previous);
+        if (result.first && result.second != previous) {
+            setTitleFilter(result.second);
+            if (getTitleCount() == 0) {
+                setTitleFilter(previous);
+                std::shared_ptr<Overlay> info = std::make_shared<InfoOverlay>(*this, "No titles match \"" + result.second + "\".");
+                setOverlay(info);
+            }
+            hid.reset();
+            MS::clearSelectedEntries();
+            directoryList->resetIndex();
+            updateButtons();
+        }
+        return;
+    }
+
     // Handle pressing A
     // Backup list active:   Backup/Restore
     // Backup list inactive: Activate backup list only if multiple
@@ -328,7 +375,7 @@ void MainScreen::handleEvents(touchPosition* touch)
         }
         else {
             // Activate backup list only if multiple selections are not enabled
-            if (!MS::multipleSelectionEnabled()) {
+            if (!MS::multipleSelectionEnabled() && getTitleCount() > 0) {
                 g_bottomScrollEnabled = true;
                 updateButtons();
             }
@@ -472,7 +519,7 @@ void MainScreen::handleEvents(touchPosition* touch)
             }
         }
         else {
-            if (buttonCheats->released() && CheatManager::getInstance().cheats() != nullptr) {
+            if (buttonCheats->released() && CheatManager::getInstance().loaded()) {
                 if (MS::multipleSelectionEnabled()) {
                     MS::clearSelectedEntries();
                     updateButtons();
@@ -503,20 +550,12 @@ int MainScreen::selectorY(size_t i) const
 
 void MainScreen::drawSelector(void) const
 {
-    static const int w         = 2;
-    const int x                = selectorX(hid.index());
-    const int y                = selectorY(hid.index());
-    float highlight_multiplier = fmax(0.0, fabs(fmod(g_timer, 1.0) - 0.5) / 0.5);
-    u8 r                       = COLOR_SELECTOR & 0xFF;
-    u8 g                       = (COLOR_SELECTOR >> 8) & 0xFF;
-    u8 b                       = (COLOR_SELECTOR >> 16) & 0xFF;
-    u32 color = C2D_Color32(r + (255 - r) * highlight_multiplier, g + (255 - g) * highlight_multiplier, b + (255 - b) * highlight_multiplier, 255);
+    static const int w = 2;
+    const int x        = selectorX(hid.index());
+    const int y        = selectorY(hid.index());
 
     C2D_DrawRectSolid(x, y, 0.5f, 50, 50, COLOR_WHITEMASK);
-    C2D_DrawRectSolid(x, y, 0.5f, 50, w, color);                      // top
-    C2D_DrawRectSolid(x, y + w, 0.5f, w, 50 - 2 * w, color);          // left
-    C2D_DrawRectSolid(x + 50 - w, y + w, 0.5f, w, 50 - 2 * w, color); // right
-    C2D_DrawRectSolid(x, y + 50 - w, 0.5f, 50, w, color);             // bottom
+    Gui::drawPulsingOutline(x + w, y + w, 50 - 2 * w, 50 - 2 * w, w, COLOR_SELECTOR);
 }
 
 void MainScreen::updateButtons(void)
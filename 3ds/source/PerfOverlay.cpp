@@ -0,0 +1,58 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "PerfOverlay.hpp"
+
+PerfOverlay::PerfOverlay(Screen& screen) : Overlay(screen)
+{
+    textBuf = C2D_TextBufNew(256);
+}
+
+PerfOverlay::~PerfOverlay(void)
+{
+    C2D_TextBufDelete(textBuf);
+}
+
+void PerfOverlay::drawTop(void) const
+{
+    const Stats::Sample& sample = Stats::sample();
+    std::string str             = StringUtils::format("%.1f ms (max %.1f ms)\nGPU %.0f%%, %.1f ms\nHeap %.2f MB\nIO %.2f MB/s, %.0f files/s\nJobs %d",
+        sample.frameTime, sample.maxFrameTime, sample.gpuUsage * 100, sample.gpuTime, sample.heapUsed / (1024.0f * 1024.0f), sample.ioRate,
+        sample.fileRate, sample.jobs);
+
+    C2D_Text text;
+    C2D_TextBufClear(textBuf);
+    C2D_TextParse(&text, textBuf, str.c_str());
+    C2D_TextOptimize(&text);
+    const float width  = ceilf(StringUtils::textWidth(text, size));
+    const float height = ceilf(StringUtils::textHeight(str, size));
+    C2D_DrawRectSolid(396 - width - 8, 22, 0.9f, width + 8, height + 4, COLOR_OVERLAY);
+    C2D_DrawText(&text, C2D_WithColor, 396 - width - 4, 24, 0.9f, size, size, COLOR_WHITE);
+}
+
+void PerfOverlay::drawBottom(void) const {}
+
+void PerfOverlay::update(touchPosition* touch) {}
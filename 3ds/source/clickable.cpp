@@ -26,10 +26,18 @@
 
 #include "clickable.hpp"
 
-void Clickable::c2dText(const std::string& v)
+void Clickable::text(const std::string& v)
 {
-    text(v);
-    mTextBuf = C2D_TextBufNew(64);
+    // the same buffer is parsed into again, and only when the text actually changed
+    if (v == mText) {
+        return;
+    }
+    IClickable::text(v);
+    if (v.size() > mGlyphs) {
+        mGlyphs  = v.size();
+        mTextBuf = C2D_TextBufResize(mTextBuf, mGlyphs);
+    }
+    C2D_TextBufClear(mTextBuf);
     C2D_TextParse(&mC2dText, mTextBuf, v.c_str());
     C2D_TextOptimize(&mC2dText);
 }
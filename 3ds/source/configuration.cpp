@@ -110,21 +110,26 @@ Configuration::Configuration(void)
         storeJson(mJson, BASEPATH);
     }
 
+    parse();
+}
+
+void Configuration::parse(void)
+{
+    std::vector<u64> filterIds, favoriteIds;
+    std::vector<std::pair<u64, std::vector<std::u16string>>> additionalSaveFolders, additionalExtdataFolders;
+
     // parse filters
     std::vector<std::string> filter = mJson["filter"];
     for (auto& id : filter) {
-        mFilterIds.emplace(strtoull(id.c_str(), NULL, 16));
+        filterIds.push_back(strtoull(id.c_str(), NULL, 16));
     }
 
     // parse favorites
     std::vector<std::string> favorites = mJson["favorites"];
     for (auto& id : favorites) {
-        mFavoriteIds.emplace(strtoull(id.c_str(), NULL, 16));
+        favoriteIds.push_back(strtoull(id.c_str(), NULL, 16));
     }
 
-    mNandSaves = mJson["nand_saves"];
-    mScanCard  = mJson["scan_cart"];
-
     // parse additional save folders
     auto js = mJson["additional_save_folders"];
     for (auto it = js.begin(); it != js.end(); ++it) {
@@ -133,7 +138,7 @@ Configuration::Configuration(void)
         for (auto& folder : folders) {
             u16folders.push_back(StringUtils::UTF8toUTF16(folder.c_str()));
         }
-        mAdditionalSaveFolders.emplace(strtoull(it.key().c_str(), NULL, 16), u16folders);
+        additionalSaveFolders.emplace_back(strtoull(it.key().c_str(), NULL, 16), std::move(u16folders));
     }
 
     // parse additional extdata folders
@@ -144,8 +149,12 @@ Configuration::Configuration(void)
         for (auto& folder : folders) {
             u16folders.push_back(StringUtils::UTF8toUTF16(folder.c_str()));
         }
-        mAdditionalExtdataFolders.emplace(strtoull(it.key().c_str(), NULL, 16), u16folders);
+        additionalExtdataFolders.emplace_back(strtoull(it.key().c_str(), NULL, 16), std::move(u16folders));
     }
+
+    mSnapshot.publish(std::make_unique<const Snapshot>(Snapshot{IdSet(std::move(filterIds)), IdSet(std::move(favoriteIds)),
+        FolderTable<std::u16string>(std::move(additionalSaveFolders)), FolderTable<std::u16string>(std::move(additionalExtdataFolders)),
+        mJson["nand_saves"], mJson["scan_cart"]}));
 }
 
 nlohmann::json Configuration::loadJson(const std::string& path)
@@ -180,34 +189,30 @@ void Configuration::store(void)
 
 bool Configuration::filter(u64 id)
 {
-    return mFilterIds.find(id) != mFilterIds.end();
+    return mSnapshot.get().filterIds.contains(id);
 }
 
 bool Configuration::favorite(u64 id)
 {
-    return mFavoriteIds.find(id) != mFavoriteIds.end();
+    return mSnapshot.get().favoriteIds.contains(id);
 }
 
 bool Configuration::nandSaves(void)
 {
-    return mNandSaves;
+    return mSnapshot.get().nandSaves;
 }
 
-std::vector<std::u16string> Configuration::additionalSaveFolders(u64 id)
+Span<std::u16string> Configuration::additionalSaveFolders(u64 id)
 {
-    std::vector<std::u16string> emptyvec;
-    auto folders = mAdditionalSaveFolders.find(id);
-    return folders == mAdditionalSaveFolders.end() ? emptyvec : folders->second;
+    return mSnapshot.get().additionalSaveFolders.find(id);
 }
 
-std::vector<std::u16string> Configuration::additionalExtdataFolders(u64 id)
+Span<std::u16string> Configuration::additionalExtdataFolders(u64 id)
 {
-    std::vector<std::u16string> emptyvec;
-    auto folders = mAdditionalExtdataFolders.find(id);
-    return folders == mAdditionalExtdataFolders.end() ? emptyvec : folders->second;
+    return mSnapshot.get().additionalExtdataFolders.find(id);
 }
 
 bool Configuration::shouldScanCard(void)
 {
-    return mScanCard;
+    return mSnapshot.get().scanCard;
 }
@@ -25,6 +25,51 @@
  */
 
 #include "gui.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include <vector>
+
+namespace {
+    struct Animation {
+        u32 x, y;
+        u16 w, h;
+        u8 size;
+        u32 color;
+    };
+
+    struct Cache {
+        C3D_Tex tex;
+        C3D_RenderTarget* target;
+        Tex3DS_SubTexture subtex;
+        std::vector<Animation> animations;
+    };
+
+    Cache caches[2];
+    bool cacheAvailable               = false;
+    std::vector<Animation>* capturing = nullptr;
+
+    bool initCache(Cache& cache, u16 width)
+    {
+        // render targets are the size of the texture, only the top left corner is shown
+        if (!C3D_TexInitVRAM(&cache.tex, 512, 256, GPU_RGBA8)) {
+            return false;
+        }
+        C3D_TexSetFilter(&cache.tex, GPU_NEAREST, GPU_NEAREST);
+        cache.target = C3D_RenderTargetCreateFromTex(&cache.tex, GPU_TEXFACE_2D, 0, GPU_RB_DEPTH16);
+        cache.subtex = {width, 240, 0.0f, 1.0f, width / 512.0f, 1.0f - 240 / 256.0f};
+        cache.animations.reserve(16);
+        return cache.target != NULL;
+    }
+
+    void freeCache(Cache& cache)
+    {
+        if (cache.target != NULL) {
+            C3D_RenderTargetDelete(cache.target);
+            cache.target = NULL;
+        }
+        C3D_TexDelete(&cache.tex);
+    }
+}
 
 C2D_Image Gui::noIcon(void)
 {
@@ -40,6 +85,12 @@ void Gui::init(void)
 
     g_top    = C2D_CreateScreenTarget(GFX_TOP, GFX_LEFT);
     g_bottom = C2D_CreateScreenTarget(GFX_BOTTOM, GFX_LEFT);
+    // without the caches, every frame is drawn from scratch
+    cacheAvailable = initCache(caches[GFX_TOP], 400) && initCache(caches[GFX_BOTTOM], 320);
+    if (!cacheAvailable) {
+        freeCache(caches[GFX_TOP]);
+        freeCache(caches[GFX_BOTTOM]);
+    }
 
     spritesheet = C2D_SpriteSheetLoad("romfs:/gfx/sprites.t3x");
     flag        = C2D_SpriteSheetGetImage(spritesheet, sprites_checkpoint_idx);
@@ -51,6 +102,10 @@ void Gui::init(void)
 
 void Gui::exit(void)
 {
+    if (cacheAvailable) {
+        freeCache(caches[GFX_TOP]);
+        freeCache(caches[GFX_BOTTOM]);
+    }
     C2D_SpriteSheetFree(spritesheet);
     C2D_Fini();
     C3D_Fini();
@@ -59,12 +114,64 @@ void Gui::exit(void)
 
 void Gui::frameEnd(void)
 {
+    TRACE_SCOPE("Gui::frameEnd");
+    Stats::frameEnd();
     C3D_FrameEnd(0);
     g_timer += 0.025f;
 }
 
+bool Gui::hasCache(void)
+{
+    return cacheAvailable;
+}
+
+void Gui::beginCache(gfxScreen_t screen)
+{
+    if (cacheAvailable) {
+        Cache& cache = caches[screen];
+        cache.animations.clear();
+        capturing = &cache.animations;
+        C2D_TargetClear(cache.target, COLOR_BG);
+        C2D_SceneBegin(cache.target);
+    }
+    else {
+        C2D_TargetClear(screen == GFX_TOP ? g_top : g_bottom, COLOR_BG);
+        C2D_SceneBegin(screen == GFX_TOP ? g_top : g_bottom);
+    }
+}
+
+void Gui::dropAnimations(void)
+{
+    if (capturing != nullptr) {
+        capturing->clear();
+    }
+}
+
+void Gui::drawCache(gfxScreen_t screen)
+{
+    capturing = nullptr;
+    if (cacheAvailable) {
+        Cache& cache = caches[screen];
+        C2D_TargetClear(screen == GFX_TOP ? g_top : g_bottom, COLOR_BG);
+        C2D_SceneBegin(screen == GFX_TOP ? g_top : g_bottom);
+        // the cache already holds blended pixels, blending them again would darken translucent areas: copy it as is, then restore
+        // the blend mode citro2d sets up in C2D_Prepare for the outlines
+        C2D_Flush();
+        C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_ONE, GPU_ZERO, GPU_ONE, GPU_ZERO);
+        C2D_DrawImageAt({&cache.tex, &cache.subtex}, 0.0f, 0.0f, 0.0f, NULL, 1.0f, 1.0f);
+        C2D_Flush();
+        C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+        for (const auto& animation : cache.animations) {
+            drawPulsingOutline(animation.x, animation.y, animation.w, animation.h, animation.size, animation.color);
+        }
+    }
+}
+
 void Gui::drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color)
 {
+    if (capturing != nullptr) {
+        capturing->push_back({x, y, w, h, size, color});
+    }
     u8 r                       = color & 0xFF;
     u8 g                       = (color >> 8) & 0xFF;
     u8 b                       = (color >> 16) & 0xFF;
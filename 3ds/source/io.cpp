@@ -25,6 +25,8 @@
  */
 
 #include "io.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
 bool io::fileExists(const std::string& path)
 {
@@ -40,65 +42,79 @@ bool io::fileExists(FS_Archive archive, const std::u16string& path)
     return exist;
 }
 
-void io::copyFile(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath)
+Result io::copyFile(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath)
 {
-    g_isTransferringFile = true;
-
-    u32 size = 0;
+    TRACE_SCOPE("io::copyFile");
     FSStream input(srcArch, srcPath, FS_OPEN_READ);
-    if (input.good()) {
-        size = input.size() > BUFFER_SIZE ? BUFFER_SIZE : input.size();
-    }
-    else {
-        Logger::getInstance().log(Logger::ERROR,
-            "Failed to open source file " + StringUtils::UTF16toUTF8(srcPath) + " during copy with result 0x%08lX. Skipping...", input.result());
-        return;
+    if (!input.good()) {
+        Logger::getInstance().log(
+            Logger::ERROR, "Failed to open source file " + StringUtils::UTF16toUTF8(srcPath) + " during copy with result 0x%08lX.", input.result());
+        return input.result();
     }
 
     FSStream output(dstArch, dstPath, FS_OPEN_WRITE, input.size());
-    if (output.good()) {
-        size_t slashpos = srcPath.rfind(StringUtils::UTF8toUTF16("/"));
-        g_currentFile   = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
-
-        u32 rd;
-        u8* buf = new u8[size];
-        do {
-            rd = input.read(buf, size);
-            output.write(buf, rd);
-
-            // avoid freezing the UI
-            // this will be made less horrible next time...
-            C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-            g_screen->drawTop();
-            C2D_SceneBegin(g_bottom);
-            g_screen->drawBottom();
-            Gui::frameEnd();
-        } while (!input.eof());
-        delete[] buf;
-    }
-    else {
+    if (!output.good()) {
         Logger::getInstance().log(Logger::ERROR,
-            "Failed to open destination file " + StringUtils::UTF16toUTF8(dstPath) + " during copy with result 0x%08lX. Skipping...",
-            output.result());
+            "Failed to open destination file " + StringUtils::UTF16toUTF8(dstPath) + " during copy with result 0x%08lX.", output.result());
+        input.close();
+        return output.result();
     }
 
+    g_isTransferringFile = true;
+
+    size_t slashpos = srcPath.rfind(StringUtils::UTF8toUTF16("/"));
+    g_currentFile   = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
+
+    u32 size   = input.size() > BUFFER_SIZE ? BUFFER_SIZE : input.size();
+    u8* buf    = new u8[size];
+    Result res = 0;
+    do {
+        u32 rd = input.read(buf, size);
+        res    = input.result();
+        if (R_SUCCEEDED(res)) {
+            output.write(buf, rd);
+            res = output.result();
+        }
+        if (R_FAILED(res)) {
+            Logger::getInstance().log(Logger::ERROR,
+                "Failed to copy " + StringUtils::UTF16toUTF8(srcPath) + " to " + StringUtils::UTF16toUTF8(dstPath) + " with result 0x%08lX.", res);
+            break;
+        }
+        Stats::io(rd);
+
+        // avoid freezing the UI
+        // this will be made less horrible next time...
+        C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+        C2D_TargetClear(g_top, COLOR_BG);
+        C2D_SceneBegin(g_top);
+        g_screen->drawTop();
+        g_screen->drawHud();
+        C2D_TargetClear(g_bottom, COLOR_BG);
+        C2D_SceneBegin(g_bottom);
+        g_screen->drawBottom();
+        Gui::frameEnd();
+    } while (!input.eof());
+    delete[] buf;
+    Stats::fileDone();
+
     input.close();
     output.close();
 
     g_isTransferringFile = false;
+    return res;
 }
 
 Result io::copyDirectory(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath)
 {
+    TRACE_SCOPE("io::copyDirectory");
     Result res = 0;
-    bool quit  = false;
     Directory items(srcArch, srcPath);
 
     if (!items.good()) {
         return items.error();
     }
 
-    for (size_t i = 0, sz = items.size(); i < sz && !quit; i++) {
+    for (size_t i = 0, sz = items.size(); i < sz && R_SUCCEEDED(res); i++) {
         std::u16string newsrc = srcPath + items.entry(i);
         std::u16string newdst = dstPath + items.entry(i);
 
@@ -109,12 +125,9 @@ Result io::copyDirectory(FS_Archive srcArch, FS_Archive dstArch, const std::u16s
                 newdst += StringUtils::UTF8toUTF16("/");
                 res = io::copyDirectory(srcArch, dstArch, newsrc, newdst);
             }
-            else {
-                quit = true;
-            }
         }
         else {
-            io::copyFile(srcArch, dstArch, newsrc, newdst);
+            res = io::copyFile(srcArch, dstArch, newsrc, newdst);
         }
     }
 
@@ -165,12 +178,93 @@ Result io::deleteFolderRecursively(FS_Archive arch, const std::u16string& path)
     return 0;
 }
 
+// next to the backups, so that moving it into place is a rename on the same archive
+static const std::u16string& stagingPath(void)
+{
+    static const std::u16string path = StringUtils::UTF8toUTF16("/3ds/Checkpoint/staging");
+    return path;
+}
+
+static Result createStaging(void)
+{
+    FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, stagingPath().data()));
+    return io::createDirectory(Archive::sdmc(), stagingPath());
+}
+
+static void deleteStaging(void)
+{
+    FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, stagingPath().data()));
+}
+
+// an extdata restore copies the current extdata here before overwriting it. The copy only outlives the restore when rolling
+// back failed, it is then the only one left: it is kept apart from the staging folder, which every backup and restore
+// wipes, and nothing runs until the user has moved it away
+static const std::u16string& recoveryPath(void)
+{
+    static const std::u16string path = StringUtils::UTF8toUTF16("/3ds/Checkpoint/recovery");
+    return path;
+}
+
+static void deleteRecovery(void)
+{
+    FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, recoveryPath().data()));
+}
+
+static bool pendingRecovery(void)
+{
+    if (io::directoryExists(Archive::sdmc(), recoveryPath())) {
+        Logger::getInstance().log(Logger::ERROR, "The extdata of a failed restore is still in /3ds/Checkpoint/recovery.");
+        return true;
+    }
+    return false;
+}
+
+static const char* RECOVERY_MESSAGE = "Extdata from a failed restore is in /3ds/Checkpoint/recovery. Move it before going on.";
+
+// swaps the staging folder in for dstPath. An existing backup is only deleted once the new one has taken its place, a
+// crash in between leaves it as dstPath.old
+static Result commitStaging(const std::u16string& dstPath)
+{
+    const std::u16string oldPath = dstPath + StringUtils::UTF8toUTF16(".old");
+    const bool replacing         = io::directoryExists(Archive::sdmc(), dstPath);
+    Result res                   = 0;
+    if (replacing) {
+        FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, oldPath.data()));
+        res = FSUSER_RenameDirectory(
+            Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()), Archive::sdmc(), fsMakePath(PATH_UTF16, oldPath.data()));
+        if (R_FAILED(res)) {
+            Logger::getInstance().log(Logger::ERROR, "Failed to move the existing backup out of the way with result 0x%08lX.", res);
+            return res;
+        }
+    }
+
+    res = FSUSER_RenameDirectory(
+        Archive::sdmc(), fsMakePath(PATH_UTF16, stagingPath().data()), Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
+    if (R_FAILED(res)) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to move the staged backup into place with result 0x%08lX.", res);
+        if (replacing) {
+            FSUSER_RenameDirectory(Archive::sdmc(), fsMakePath(PATH_UTF16, oldPath.data()), Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
+        }
+        return res;
+    }
+
+    if (replacing) {
+        FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, oldPath.data()));
+    }
+    return 0;
+}
+
 std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
 {
+    TRACE_SCOPE("io::backup");
     const Mode_t mode      = Archive::mode();
     const bool isNewFolder = cellIndex == 0;
     Result res             = 0;
 
+    if (pendingRecovery()) {
+        return std::make_tuple(false, -1, RECOVERY_MESSAGE);
+    }
+
     Title title;
     getTitle(title, index);
 
@@ -206,33 +300,30 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
                 dstPath += StringUtils::UTF8toUTF16("/") + customPath;
             }
 
-            if (!isNewFolder || io::directoryExists(Archive::sdmc(), dstPath)) {
-                res = FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
-                if (R_FAILED(res)) {
-                    FSUSER_CloseArchive(archive);
-                    Logger::getInstance().log(Logger::ERROR, "Failed to delete the existing backup directory recursively with result 0x%08lX.", res);
-                    return std::make_tuple(false, res, "Failed to delete the existing backup\ndirectory recursively.");
-                }
-            }
-
-            res = io::createDirectory(Archive::sdmc(), dstPath);
+            // the archive is copied into a staging folder first and only replaces the destination once it is complete
+            res = createStaging();
             if (R_FAILED(res)) {
                 FSUSER_CloseArchive(archive);
-                Logger::getInstance().log(Logger::ERROR, "Failed to create destination directory.");
+                Logger::getInstance().log(Logger::ERROR, "Failed to create the staging directory with result 0x%08lX.", res);
                 return std::make_tuple(false, res, "Failed to create destination directory.");
             }
 
-            std::u16string copyPath = dstPath + StringUtils::UTF8toUTF16("/");
-
-            res = io::copyDirectory(archive, Archive::sdmc(), StringUtils::UTF8toUTF16("/"), copyPath);
+            res = io::copyDirectory(archive, Archive::sdmc(), StringUtils::UTF8toUTF16("/"), stagingPath() + StringUtils::UTF8toUTF16("/"));
             if (R_FAILED(res)) {
                 std::string message = mode == MODE_SAVE ? "Failed to backup save." : "Failed to backup extdata.";
                 FSUSER_CloseArchive(archive);
-                FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
+                deleteStaging();
                 Logger::getInstance().log(Logger::ERROR, message + " Result 0x%08lX.", res);
                 return std::make_tuple(false, res, message);
             }
 
+            res = commitStaging(dstPath);
+            if (R_FAILED(res)) {
+                FSUSER_CloseArchive(archive);
+                deleteStaging();
+                return std::make_tuple(false, res, "Failed to replace the existing backup.");
+            }
+
             refreshDirectories(title.id());
         }
         else {
@@ -267,22 +358,14 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
             dstPath += StringUtils::UTF8toUTF16("/") + customPath;
         }
 
-        if (!isNewFolder || io::directoryExists(Archive::sdmc(), dstPath)) {
-            res = FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
-            if (R_FAILED(res)) {
-                Logger::getInstance().log(Logger::ERROR, "Failed to delete the existing backup directory recursively with result 0x%08lX.", res);
-                return std::make_tuple(false, res, "Failed to delete the existing\nbackup directory recursively.");
-            }
-        }
-
-        res = io::createDirectory(Archive::sdmc(), dstPath);
+        res = createStaging();
         if (R_FAILED(res)) {
-            Logger::getInstance().log(Logger::ERROR, "Failed to create destination directory with result 0x%08lX.", res);
+            Logger::getInstance().log(Logger::ERROR, "Failed to create the staging directory with result 0x%08lX.", res);
             return std::make_tuple(false, res, "Failed to create destination directory.");
         }
 
-        std::u16string copyPath =
-            dstPath + StringUtils::UTF8toUTF16("/") + StringUtils::UTF8toUTF16(title.shortDescription().c_str()) + StringUtils::UTF8toUTF16(".sav");
+        std::u16string copyPath = stagingPath() + StringUtils::UTF8toUTF16("/") + StringUtils::UTF8toUTF16(title.shortDescription().c_str()) +
+                                  StringUtils::UTF8toUTF16(".sav");
 
         u8* saveFile = new u8[saveSize];
         for (u32 i = 0; i < saveSize / sectorSize; ++i) {
@@ -294,9 +377,8 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
 
         if (R_FAILED(res)) {
             delete[] saveFile;
-            FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
-            Logger::getInstance().log(
-                Logger::ERROR, "Failed to delete directory recursively after failing to write save to the sd card with result 0x%08lX.", res);
+            deleteStaging();
+            Logger::getInstance().log(Logger::ERROR, "Failed to read the save from the card with result 0x%08lX.", res);
             return std::make_tuple(false, res, "Failed to backup save.");
         }
 
@@ -304,17 +386,19 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
         if (stream.good()) {
             stream.write(saveFile, saveSize);
         }
-        else {
-            delete[] saveFile;
-            stream.close();
-            FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
-            Logger::getInstance().log(
-                Logger::ERROR, "Failed to delete directory recursively after failing to write save to the sd card with result 0x%08lX.", res);
+        res = stream.result();
+        delete[] saveFile;
+        stream.close();
+
+        if (R_SUCCEEDED(res)) {
+            res = commitStaging(dstPath);
+        }
+        if (R_FAILED(res)) {
+            deleteStaging();
+            Logger::getInstance().log(Logger::ERROR, "Failed to write the save to the sd card with result 0x%08lX.", res);
             return std::make_tuple(false, res, "Failed to backup save.");
         }
 
-        delete[] saveFile;
-        stream.close();
         refreshDirectories(title.id());
     }
 
@@ -324,9 +408,14 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
 
 std::tuple<bool, Result, std::string> io::restore(size_t index, size_t cellIndex, const std::string& nameFromCell)
 {
+    TRACE_SCOPE("io::restore");
     const Mode_t mode = Archive::mode();
     Result res        = 0;
 
+    if (pendingRecovery()) {
+        return std::make_tuple(false, -1, RECOVERY_MESSAGE);
+    }
+
     Title title;
     getTitle(title, index);
 
@@ -346,6 +435,29 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, size_t cellIndex
             srcPath += StringUtils::UTF8toUTF16("/");
             std::u16string dstPath = StringUtils::UTF8toUTF16("/");
 
+            // save archives keep nothing until they are committed once at the end, a failure before that leaves the original
+            // save intact. Extdata has no such journal, so its current contents are staged first and copied back on failure
+            Directory backupItems(Archive::sdmc(), srcPath);
+            if (!backupItems.good()) {
+                FSUSER_CloseArchive(archive);
+                Logger::getInstance().log(Logger::ERROR, "Failed to open the backup with result 0x%08lX.", backupItems.error());
+                return std::make_tuple(false, backupItems.error(), "Failed to open the backup.");
+            }
+
+            const std::u16string rollbackPath = recoveryPath() + StringUtils::UTF8toUTF16("/");
+            if (mode == MODE_EXTDATA) {
+                res = io::createDirectory(Archive::sdmc(), recoveryPath());
+                if (R_SUCCEEDED(res)) {
+                    res = io::copyDirectory(archive, Archive::sdmc(), dstPath, rollbackPath);
+                }
+                if (R_FAILED(res)) {
+                    FSUSER_CloseArchive(archive);
+                    deleteRecovery();
+                    Logger::getInstance().log(Logger::ERROR, "Failed to keep a copy of the extdata to roll back to with result 0x%08lX.", res);
+                    return std::make_tuple(false, res, "Failed to restore extdata.");
+                }
+            }
+
             if (mode != MODE_EXTDATA) {
                 FSUSER_DeleteDirectoryRecursively(archive, fsMakePath(PATH_UTF16, dstPath.data()));
             }
@@ -356,11 +468,28 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, size_t cellIndex
             res = io::copyDirectory(Archive::sdmc(), archive, srcPath, dstPath);
             if (R_FAILED(res)) {
                 std::string message = mode == MODE_SAVE ? "Failed to restore save." : "Failed to restore extdata.";
-                FSUSER_CloseArchive(archive);
                 Logger::getInstance().log(Logger::ERROR, message + ". Result 0x%08lX.", res);
+                if (mode == MODE_EXTDATA) {
+                    deleteFolderRecursively(archive, dstPath);
+                    Result rollback = io::copyDirectory(Archive::sdmc(), archive, rollbackPath, dstPath);
+                    if (R_FAILED(rollback)) {
+                        // keep the copy around, it is the only one left
+                        Logger::getInstance().log(Logger::ERROR,
+                            "Failed to roll the extdata back with result 0x%08lX, it is kept in /3ds/Checkpoint/recovery.", rollback);
+                        message = "Failed to restore extdata. A copy of it is kept in /3ds/Checkpoint/recovery.";
+                    }
+                    else {
+                        deleteRecovery();
+                    }
+                }
+                FSUSER_CloseArchive(archive);
                 return std::make_tuple(false, res, message);
             }
 
+            if (mode == MODE_EXTDATA) {
+                deleteRecovery();
+            }
+
             if (mode == MODE_SAVE) {
                 res = FSUSER_ControlArchive(archive, ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
                 if (R_FAILED(res)) {
@@ -27,6 +27,7 @@
 #include "main.hpp"
 #include "MainScreen.hpp"
 #include "thread.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
 int main()
@@ -38,16 +39,22 @@ int main()
 
     g_screen = std::make_unique<MainScreen>();
 
+    Threads::create((ThreadFunc)Threads::logger);
     Threads::create((ThreadFunc)Threads::titles);
+    Threads::create((ThreadFunc)Threads::cheats);
     ATEXIT(Threads::destroy);
 
+    time_t shownTime = time(NULL);
     while (aptMainLoop()) {
         touchPosition touch;
         hidScanInput();
         hidTouchRead(&touch);
 
         if (hidKeysDown() & KEY_START) {
-            if (!g_isLoadingTitles) {
+            if (hidKeysHeld() & KEY_SELECT) {
+                g_screen->toggleHud();
+            }
+            else if (!g_isLoadingTitles) {
                 break;
             }
         }
@@ -56,14 +63,23 @@ int main()
         //     updateCard();
         // }
 
+        if (!g_isLoadingTitles && refreshTitleFilter()) {
+            g_screen->markDirty();
+        }
+        // the clock on the top screen shows seconds
+        if (shownTime != time(NULL)) {
+            shownTime = time(NULL);
+            g_screen->markDirty();
+        }
+
         C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
         g_screen->doDrawTop();
-        C2D_SceneBegin(g_bottom);
         g_screen->doDrawBottom();
         Gui::frameEnd();
         g_screen->doUpdate(&touch);
     }
 
+    Trace::dump();
     Logger::getInstance().flush();
 
     exit(0);
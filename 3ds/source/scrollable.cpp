@@ -28,7 +28,7 @@
 
 void Scrollable::c2dText(size_t i, const std::string& v)
 {
-    ((Clickable*)mCells.at(i))->c2dText(v);
+    cellName(i, v);
 }
 
 void Scrollable::setIndex(size_t i)
@@ -43,12 +43,10 @@ void Scrollable::resetIndex(void)
     setIndex(0);
 }
 
-void Scrollable::push_back(u32 color, u32 colorMessage, const std::string& message, bool selected)
+IClickable<u32>* Scrollable::newCell(size_t i)
 {
     const float spacing = mh / mVisibleEntries;
-    Clickable* cell     = new Clickable(mx, my + (size() % mVisibleEntries) * spacing, mw, spacing, color, colorMessage, message, false);
-    cell->selected(selected);
-    mCells.push_back(cell);
+    return new Clickable(mx, my + i * spacing, mw, spacing, COLOR_GREY_DARKER, COLOR_WHITE, "", false);
 }
 
 void Scrollable::updateSelection(void)
@@ -69,10 +67,9 @@ void Scrollable::updateSelection(void)
 
 void Scrollable::draw(bool condition)
 {
-    const size_t baseIndex = mVisibleEntries * mPage;
-    const size_t sz        = size() - baseIndex > mVisibleEntries ? mVisibleEntries : size() - baseIndex;
-    for (size_t i = baseIndex; i < baseIndex + sz; i++) {
-        mCells.at(i)->draw(0.5f, 0);
+    const size_t sz = bind();
+    for (size_t i = 0; i < sz; i++) {
+        mCells[i]->draw(0.5f, 0);
     }
 
     size_t blankRows = mVisibleEntries - sz;
@@ -80,9 +77,9 @@ void Scrollable::draw(bool condition)
     C2D_DrawRectSolid(mx, my + sz * rowHeight, 0.5f, mw, rowHeight * blankRows, COLOR_GREY_DARKER);
 
     // draw selector
-    for (size_t i = baseIndex; i < baseIndex + sz; i++) {
-        if (mCells.at(i)->selected()) {
-            mCells.at(i)->drawOutline(condition ? COLOR_BLUE : COLOR_GREY_LIGHT);
+    for (size_t i = 0; i < sz; i++) {
+        if (mCells[i]->selected()) {
+            mCells[i]->drawOutline(condition ? COLOR_BLUE : COLOR_GREY_LIGHT);
             break;
         }
     }
@@ -43,6 +43,7 @@
  */
 
 #include "spi.hpp"
+#include "trace.hpp"
 
 static std::vector<u32> knownJEDECs = {0x204012, 0x621600, 0x204013, 0x621100, 0x204014, 0x202017, 0x204017, 0x208013};
 
@@ -148,6 +149,7 @@ u32 SPIGetCapacity(CardType type)
 
 Result SPIWriteSaveData(CardType type, u32 offset, void* data, u32 size)
 {
+    TRACE_SCOPE("SPIWriteSaveData");
     u8 cmd[4]   = {0};
     u32 cmdSize = 4;
 
@@ -259,6 +261,7 @@ Result _SPIReadSaveData_512B_impl(u32 pos, void* data, u32 size)
 
 Result SPIReadSaveData(CardType type, u32 offset, void* data, u32 size)
 {
+    TRACE_SCOPE("SPIReadSaveData");
     u8 cmd[4]   = {SPI_CMD_READ};
     u32 cmdSize = 4;
     if (size == 0)
@@ -310,6 +313,7 @@ Result SPIReadSaveData(CardType type, u32 offset, void* data, u32 size)
 
 Result SPIEraseSector(CardType type, u32 offset)
 {
+    TRACE_SCOPE("SPIEraseSector");
     u8 cmd[4] = {SPI_FLASH_CMD_SE, (u8)(offset >> 16), (u8)(offset >> 8), (u8)offset};
     if (type == NO_CHIP || type == FLASH_8MB)
         return 0xC8E13404;
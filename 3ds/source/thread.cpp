@@ -25,6 +25,8 @@
  */
 
 #include "thread.hpp"
+#include "main.hpp"
+#include "stats.hpp"
 
 static std::vector<Thread> threads;
 
@@ -46,6 +48,11 @@ void Threads::destroy(void)
     }
 }
 
+void Threads::logger(void)
+{
+    Logger::getInstance().run();
+}
+
 void Threads::titles(void)
 {
     // don't load titles while they're loading
@@ -53,8 +60,19 @@ void Threads::titles(void)
         return;
     }
 
+    Stats::jobQueued();
     g_isLoadingTitles = true;
     loadTitles(forceRefresh);
     forceRefresh      = true;
     g_isLoadingTitles = false;
-}
\ No newline at end of file
+    g_screen->markDirty();
+    Stats::jobDone();
+}
+
+void Threads::cheats(void)
+{
+    Stats::jobQueued();
+    CheatManager::getInstance().load();
+    g_screen->markDirty();
+    Stats::jobDone();
+}
@@ -24,58 +24,42 @@
  *         reasonable ways as different from the original version.
  */
 
+#include "icon.hpp"
+#include "image.hpp"
 #include "title.hpp"
+#include "titleindex.hpp"
+#include "titlesort.hpp"
+#include "trace.hpp"
 
 static bool validId(u64 id);
 static C2D_Image loadTextureIcon(smdh_s* smdh);
 
 static std::vector<Title> titleSaves;
 static std::vector<Title> titleExtdatas;
+static std::atomic<u32> directoriesGeneration(0);
+// with a filter set, the titles are seen through views listing the matching ones
+static TitleIndex saveIndex, extdataIndex;
+static std::vector<u32> saveView, extdataView;
+static std::string filter;
+// the indexes are rebuilt by the loading thread, the views only ever change on the main thread
+static std::atomic<bool> viewsStale(false);
 
 static void exportTitleListCache(std::vector<Title>& list, const std::u16string& path);
 static void importTitleListCache(void);
+static void indexTitles(void);
 
 static constexpr Tex3DS_SubTexture dsIconSubt3x = {32, 32, 0.0f, 1.0f, 1.0f, 0.0f};
 static C2D_Image dsIcon                         = {nullptr, &dsIconSubt3x};
 
 static void loadDSIcon(u8* banner)
 {
-    static constexpr int WIDTH_POW2  = 32;
-    static constexpr int HEIGHT_POW2 = 32;
     if (!dsIcon.tex) {
         dsIcon.tex = new C3D_Tex;
-        C3D_TexInit(dsIcon.tex, WIDTH_POW2, HEIGHT_POW2, GPU_RGB565);
+        C3D_TexInit(dsIcon.tex, 32, 32, GPU_RGB565);
     }
 
-    struct bannerData {
-        u16 version;
-        u16 crc;
-        u8 reserved[28];
-        u8 data[512];
-        u16 palette[16];
-    };
-    bannerData* iconData = (bannerData*)banner;
-
-    u16* output = (u16*)dsIcon.tex->data;
-    for (size_t x = 0; x < 32; x++) {
-        for (size_t y = 0; y < 32; y++) {
-            u32 srcOff   = (((y >> 3) * 4 + (x >> 3)) * 8 + (y & 7)) * 4 + ((x & 7) >> 1);
-            u32 srcShift = (x & 1) * 4;
-
-            u16 pIndex = (iconData->data[srcOff] >> srcShift) & 0xF;
-            u16 color  = 0xFFFF;
-            if (pIndex != 0) {
-                u16 r = iconData->palette[pIndex] & 0x1F;
-                u16 g = (iconData->palette[pIndex] >> 5) & 0x1F;
-                u16 b = (iconData->palette[pIndex] >> 10) & 0x1F;
-                color = (r << 11) | (g << 6) | (g >> 4) | (b);
-            }
-
-            u32 dst     = ((((y >> 3) * (32 >> 3) + (x >> 3)) << 6) +
-                       ((x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3)));
-            output[dst] = color;
-        }
-    }
+    const Icon::DSBanner* iconData = (const Icon::DSBanner*)banner;
+    Image::decodeDS((u16*)dsIcon.tex->data, iconData->data, iconData->palette);
 }
 
 void Title::load(void)
@@ -113,6 +97,7 @@ void Title::load(u64 id, u8* _productCode, bool accessibleSave, bool accessibleE
 
 bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
 {
+    TRACE_SCOPE("Title::load");
     bool loadTitle = false;
     mId            = _id;
     mMedia         = _media;
@@ -227,17 +212,17 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
 
 Title::~Title(void) {}
 
-bool Title::accessibleSave(void)
+bool Title::accessibleSave(void) const
 {
     return mAccessibleSave;
 }
 
-bool Title::accessibleExtdata(void)
+bool Title::accessibleExtdata(void) const
 {
     return mAccessibleExtdata;
 }
 
-std::string Title::mediaTypeString(void)
+std::string Title::mediaTypeString(void) const
 {
     switch (mMedia) {
         case MEDIATYPE_SD:
@@ -253,52 +238,52 @@ std::string Title::mediaTypeString(void)
     return " ";
 }
 
-std::string Title::shortDescription(void)
+std::string Title::shortDescription(void) const
 {
     return StringUtils::UTF16toUTF8(mShortDescription);
 }
 
-std::u16string Title::getShortDescription(void)
+std::u16string Title::getShortDescription(void) const
 {
     return mShortDescription;
 }
 
-std::string Title::longDescription(void)
+std::string Title::longDescription(void) const
 {
     return StringUtils::UTF16toUTF8(mLongDescription);
 }
 
-std::u16string Title::getLongDescription(void)
+std::u16string Title::getLongDescription(void) const
 {
     return mLongDescription;
 }
 
-std::u16string Title::savePath(void)
+std::u16string Title::savePath(void) const
 {
     return mSavePath;
 }
 
-std::u16string Title::extdataPath(void)
+std::u16string Title::extdataPath(void) const
 {
     return mExtdataPath;
 }
 
-std::u16string Title::fullSavePath(size_t index)
+std::u16string Title::fullSavePath(size_t index) const
 {
     return mFullSavePaths.at(index);
 }
 
-std::u16string Title::fullExtdataPath(size_t index)
+std::u16string Title::fullExtdataPath(size_t index) const
 {
     return mFullExtdataPaths.at(index);
 }
 
-std::vector<std::u16string> Title::saves(void)
+std::vector<std::u16string> Title::saves(void) const
 {
     return mSaves;
 }
 
-std::vector<std::u16string> Title::extdata(void)
+std::vector<std::u16string> Title::extdata(void) const
 {
     return mExtdata;
 }
@@ -331,8 +316,8 @@ void Title::refreshDirectories(void)
         }
 
         // save backups from configuration
-        std::vector<std::u16string> additionalFolders = Configuration::getInstance().additionalSaveFolders(mId);
-        for (std::vector<std::u16string>::const_iterator it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
+        Span<std::u16string> additionalFolders = Configuration::getInstance().additionalSaveFolders(mId);
+        for (const std::u16string* it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
             // we have other folders to parse
             Directory list(Archive::sdmc(), *it);
             if (list.good()) {
@@ -367,8 +352,8 @@ void Title::refreshDirectories(void)
         }
 
         // extdata backups from configuration
-        std::vector<std::u16string> additionalFolders = Configuration::getInstance().additionalExtdataFolders(mId);
-        for (std::vector<std::u16string>::const_iterator it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
+        Span<std::u16string> additionalFolders = Configuration::getInstance().additionalExtdataFolders(mId);
+        for (const std::u16string* it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
             // we have other folders to parse
             Directory list(Archive::sdmc(), *it);
             if (list.good()) {
@@ -381,29 +366,30 @@ void Title::refreshDirectories(void)
             }
         }
     }
+    directoriesGeneration++;
 }
 
-u32 Title::highId(void)
+u32 Title::highId(void) const
 {
     return (u32)(mId >> 32);
 }
 
-u32 Title::lowId(void)
+u32 Title::lowId(void) const
 {
     return (u32)mId;
 }
 
-u32 Title::uniqueId(void)
+u32 Title::uniqueId(void) const
 {
     return (lowId() >> 8);
 }
 
-u64 Title::id(void)
+u64 Title::id(void) const
 {
     return mId;
 }
 
-u32 Title::extdataId(void)
+u32 Title::extdataId(void) const
 {
     u32 low = lowId();
     switch (low) {
@@ -433,22 +419,22 @@ u32 Title::extdataId(void)
     return low >> 8;
 }
 
-FS_MediaType Title::mediaType(void)
+FS_MediaType Title::mediaType(void) const
 {
     return mMedia;
 }
 
-FS_CardType Title::cardType(void)
+FS_CardType Title::cardType(void) const
 {
     return mCard;
 }
 
-CardType Title::SPICardType(void)
+CardType Title::SPICardType(void) const
 {
     return mCardType;
 }
 
-C2D_Image Title::icon(void)
+C2D_Image Title::icon(void) const
 {
     return mIcon;
 }
@@ -489,8 +475,26 @@ static bool validId(u64 id)
     return !Configuration::getInstance().filter(id);
 }
 
+// favorites first, then alphabetical. Titles are moved once into their final place
+static void sortTitleList(std::vector<Title>& list)
+{
+    std::vector<TitleSort::Item> items;
+    items.reserve(list.size());
+    for (auto& title : list) {
+        items.push_back({title.shortDescription(), Configuration::getInstance().favorite(title.id()), 0, 0});
+    }
+
+    std::vector<Title> sorted;
+    sorted.reserve(list.size());
+    for (u32 index : TitleSort::alphabetical(items)) {
+        sorted.push_back(std::move(list[index]));
+    }
+    list.swap(sorted);
+}
+
 void loadTitles(bool forceRefresh)
 {
+    TRACE_SCOPE("loadTitles");
     static const std::u16string savecachePath    = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullsavecache");
     static const std::u16string extdatacachePath = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullextdatacache");
 
@@ -500,33 +504,33 @@ void loadTitles(bool forceRefresh)
 
     bool optimizedLoad = false;
 
-    u8 hash[SHA256_BLOCK_SIZE];
+    u8 hash[Hash::SHA256_SIZE];
     calculateTitleDBHash(hash);
 
     std::u16string titlesHashPath = StringUtils::UTF8toUTF16("/3ds/Checkpoint/titles.sha");
     if (!io::fileExists(Archive::sdmc(), titlesHashPath) || !io::fileExists(Archive::sdmc(), savecachePath) ||
         !io::fileExists(Archive::sdmc(), extdatacachePath)) {
         // create title list sha256 hash file if it doesn't exist in the working directory
-        FSStream output(Archive::sdmc(), titlesHashPath, FS_OPEN_WRITE, SHA256_BLOCK_SIZE);
-        output.write(hash, SHA256_BLOCK_SIZE);
+        FSStream output(Archive::sdmc(), titlesHashPath, FS_OPEN_WRITE, Hash::SHA256_SIZE);
+        output.write(hash, Hash::SHA256_SIZE);
         output.close();
     }
     else {
         // compare current hash with the previous hash
         FSStream input(Archive::sdmc(), titlesHashPath, FS_OPEN_READ);
-        if (input.good() && input.size() == SHA256_BLOCK_SIZE) {
+        if (input.good() && input.size() == Hash::SHA256_SIZE) {
             u8* buf = new u8[input.size()];
             input.read(buf, input.size());
             input.close();
 
-            if (memcmp(hash, buf, SHA256_BLOCK_SIZE) == 0) {
+            if (memcmp(hash, buf, Hash::SHA256_SIZE) == 0) {
                 // hash matches
                 optimizedLoad = true;
             }
             else {
                 FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, titlesHashPath.data()));
-                FSStream output(Archive::sdmc(), titlesHashPath, FS_OPEN_WRITE, SHA256_BLOCK_SIZE);
-                output.write(hash, SHA256_BLOCK_SIZE);
+                FSStream output(Archive::sdmc(), titlesHashPath, FS_OPEN_WRITE, Hash::SHA256_SIZE);
+                output.write(hash, Hash::SHA256_SIZE);
                 output.close();
             }
 
@@ -603,23 +607,8 @@ void loadTitles(bool forceRefresh)
         }
     }
 
-    std::sort(titleSaves.begin(), titleSaves.end(), [](Title& l, Title& r) {
-        if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-            return Configuration::getInstance().favorite(l.id());
-        }
-        else {
-            return l.shortDescription() < r.shortDescription();
-        }
-    });
-
-    std::sort(titleExtdatas.begin(), titleExtdatas.end(), [](Title& l, Title& r) {
-        if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-            return Configuration::getInstance().favorite(l.id());
-        }
-        else {
-            return l.shortDescription() < r.shortDescription();
-        }
-    });
+    sortTitleList(titleSaves);
+    sortTitleList(titleExtdatas);
 
     // serialize data
     exportTitleListCache(titleSaves, savecachePath);
@@ -655,19 +644,86 @@ void loadTitles(bool forceRefresh)
             }
         }
     }
+
+    indexTitles();
+}
+
+static void updateView(const TitleIndex& index, std::vector<u32>& view)
+{
+    std::vector<bool> matches;
+    index.search(filter, matches);
+    view.clear();
+    for (size_t i = 0; i < matches.size(); i++) {
+        if (matches[i]) {
+            view.push_back(i);
+        }
+    }
+}
+
+// the lists change on every load and whenever a game card comes and goes, refreshTitleFilter applies the new indexes
+static void indexTitles(void)
+{
+    saveIndex.clear();
+    for (auto& title : titleSaves) {
+        saveIndex.add(title.shortDescription(), title.longDescription(), title.id());
+    }
+    extdataIndex.clear();
+    for (auto& title : titleExtdatas) {
+        extdataIndex.add(title.shortDescription(), title.longDescription(), title.id());
+    }
+    viewsStale = true;
+}
+
+void setTitleFilter(const std::string& query)
+{
+    TRACE_SCOPE("setTitleFilter");
+    filter = query;
+    updateView(saveIndex, saveView);
+    updateView(extdataIndex, extdataView);
+}
+
+bool refreshTitleFilter(void)
+{
+    if (!viewsStale.exchange(false)) {
+        return false;
+    }
+    setTitleFilter(filter);
+    return true;
+}
+
+std::string getTitleFilter(void)
+{
+    return filter;
+}
+
+const Title* titleAt(int i)
+{
+    const bool isSaveMode    = Archive::mode() == MODE_SAVE;
+    std::vector<Title>& list = isSaveMode ? titleSaves : titleExtdatas;
+    if (i < 0) {
+        return nullptr;
+    }
+    if (!filter.empty()) {
+        const std::vector<u32>& view = isSaveMode ? saveView : extdataView;
+        return (size_t)i < view.size() && view[i] < list.size() ? &list[view[i]] : nullptr;
+    }
+    return (size_t)i < list.size() ? &list[i] : nullptr;
 }
 
 void getTitle(Title& dst, int i)
 {
-    const Mode_t mode = Archive::mode();
-    if (i < getTitleCount()) {
-        dst = mode == MODE_SAVE ? titleSaves.at(i) : titleExtdatas.at(i);
+    const Title* title = titleAt(i);
+    if (title != nullptr) {
+        dst = *title;
     }
 }
 
 int getTitleCount(void)
 {
     const Mode_t mode = Archive::mode();
+    if (!filter.empty()) {
+        return mode == MODE_SAVE ? saveView.size() : extdataView.size();
+    }
     return mode == MODE_SAVE ? titleSaves.size() : titleExtdatas.size();
 }
 
@@ -678,38 +734,19 @@ void Title::setIcon(C2D_Image icon)
 
 C2D_Image icon(int i)
 {
-    const Mode_t mode = Archive::mode();
-    return mode == MODE_SAVE ? titleSaves.at(i).icon() : titleExtdatas.at(i).icon();
+    const Title* title = titleAt(i);
+    return title != nullptr ? title->icon() : (C2D_Image){nullptr, nullptr};
 }
 
 bool favorite(int i)
 {
-    const Mode_t mode = Archive::mode();
-    u64 id            = mode == MODE_SAVE ? titleSaves.at(i).id() : titleExtdatas.at(i).id();
-    return Configuration::getInstance().favorite(id);
-}
-
-static C2D_Image loadTextureFromBytes(u16* bigIconData)
-{
-    C3D_Tex* tex                          = (C3D_Tex*)malloc(sizeof(C3D_Tex));
-    static const Tex3DS_SubTexture subt3x = {48, 48, 0.0f, 48 / 64.0f, 48 / 64.0f, 0.0f};
-    C2D_Image image                       = (C2D_Image){tex, &subt3x};
-    C3D_TexInit(image.tex, 64, 64, GPU_RGB565);
-
-    u16* dest = (u16*)image.tex->data + (64 - 48) * 64;
-    u16* src  = bigIconData;
-    for (int j = 0; j < 48; j += 8) {
-        memcpy(dest, src, 48 * 8 * sizeof(u16));
-        src += 48 * 8;
-        dest += 64 * 8;
-    }
-
-    return image;
+    const Title* title = titleAt(i);
+    return title != nullptr ? Configuration::getInstance().favorite(title->id()) : false;
 }
 
 static C2D_Image loadTextureIcon(smdh_s* smdh)
 {
-    return loadTextureFromBytes(smdh->bigIconData);
+    return Icon::fromSMDH(smdh->bigIconData);
 }
 
 void refreshDirectories(u64 id)
@@ -731,6 +768,11 @@ void refreshDirectories(u64 id)
     }
 }
 
+u32 getDirectoriesGeneration(void)
+{
+    return directoriesGeneration;
+}
+
 static const size_t ENTRYSIZE = 5341;
 
 /**
@@ -853,9 +895,7 @@ static void importTitleListCache(void)
             card);
 
         if (cardType == CARD_CTR) {
-            u16 bigIconData[0x900];
-            memcpy(bigIconData, cachesaves + i * ENTRYSIZE + 733, 0x900 * 2);
-            C2D_Image smallIcon = loadTextureFromBytes(bigIconData);
+            C2D_Image smallIcon = Icon::fromSMDH(cachesaves + i * ENTRYSIZE + 733);
             title.setIcon(smallIcon);
         }
         else {
@@ -900,9 +940,7 @@ static void importTitleListCache(void)
                 card);
 
             if (cardType == CARD_CTR) {
-                u16 bigIconData[0x900];
-                memcpy(bigIconData, cacheextdatas + i * ENTRYSIZE + 733, 0x900 * 2);
-                C2D_Image smallIcon = loadTextureFromBytes(bigIconData);
+                C2D_Image smallIcon = Icon::fromSMDH(cacheextdatas + i * ENTRYSIZE + 733);
                 title.setIcon(smallIcon);
             }
             else {
@@ -979,6 +1017,9 @@ static bool scanCard(void)
             }
         }
     }
+    if (ret) {
+        indexTitles();
+    }
     isScanning = false;
     return ret;
 }
@@ -1011,12 +1052,13 @@ void updateCard(void)
             if (titleExtdatas.at(0).mediaType() == MEDIATYPE_GAME_CARD) {
                 titleExtdatas.erase(titleExtdatas.begin());
             }
+            indexTitles();
             oldCardIn = false;
         }
     }
 }
 
-bool Title::isActivityLog(void)
+bool Title::isActivityLog(void) const
 {
     bool activityId = false;
     switch (lowId()) {
@@ -18,6 +18,11 @@
 #include <sys/statvfs.h>
 #include <time.h>
 #include <unistd.h>
+/* sendfile() is only there on linux hosts, FTP_NO_SENDFILE builds the buffered path the consoles use */
+#if defined(__linux__) && !defined(FTP_NO_SENDFILE)
+#define FTP_SENDFILE
+#include <sys/sendfile.h>
+#endif
 
 #include "ftp.h"
 
@@ -27,7 +32,12 @@
 #define POLL_UNKNOWN    (~(POLLIN|POLLPRI|POLLOUT))
 #define XFER_BUFFERSIZE 65536
 #define SOCK_BUFFERSIZE 65536
-#define FILE_BUFFERSIZE 1048576
+#define XFER_POOL_SIZE  4 /* idle transfer buffers kept for reuse */
+#if defined(__SWITCH__)
+#define STOR_BUFFERSIZE 0x100000 /* uploads are written to the sd card in large batches */
+#else
+#define STOR_BUFFERSIZE XFER_BUFFERSIZE
+#endif
 #define CMD_BUFFERSIZE  4096
 #define LISTEN_PORT     50000
 #define DATA_PORT       0 /* ephemeral port */
@@ -130,15 +140,15 @@ struct ftp_session_t {
   ftp_session_t        *prev;      /*!< link to prev session */
 
   loop_status_t (*transfer)(ftp_session_t*);  /*! data transfer callback */
-  char     buffer[XFER_BUFFERSIZE];      /*! persistent data between callbacks */
-  char     file_buffer[FILE_BUFFERSIZE]; /*! stdio file buffer */
+  char     *buffer;                      /*! persistent data between callbacks, borrowed from the pool while in use */
+  size_t   buffercap;                    /*! size of buffer */
   char     cmd_buffer[CMD_BUFFERSIZE];   /*! command buffer */
   size_t   bufferpos;                    /*! persistent buffer position between callbacks */
   size_t   buffersize;                   /*! persistent buffer size between callbacks */
   size_t   cmd_buffersize;
   uint64_t filepos;                      /*! persistent file position between callbacks */
   uint64_t filesize;                     /*! persistent file size between callbacks */
-  FILE     *fp;                          /*! persistent open file pointer between callbacks */
+  int      fd;                           /*! persistent open file descriptor between callbacks */
   DIR      *dp;                          /*! persistent open directory pointer between callbacks */
 };
 
@@ -225,6 +235,14 @@ static ftp_session_t      *sessions = NULL;
 static int                sock_buffersize = SOCK_BUFFERSIZE;
 /*! server start time */
 static time_t             start_time = 0;
+/*! idle transfer buffers */
+static char               *xfer_pool[XFER_POOL_SIZE];
+/*! number of idle transfer buffers */
+static size_t             xfer_pool_count = 0;
+#if defined(FTP_SENDFILE)
+/*! whether sendfile() failed for a reason other than a full socket */
+static bool               sendfile_unsupported = false;
+#endif
 
 /*! Allocate a new data port
  *
@@ -363,18 +381,64 @@ static void ftp_session_close_data(ftp_session_t *session) {
   session->flags &= ~(SESSION_RECV|SESSION_SEND);
 }
 
-/*! close open file for ftp session
+static loop_status_t store_transfer(ftp_session_t *session);
+
+/*! get a transfer buffer
+ *
+ *  @param[in] size buffer size, only XFER_BUFFERSIZE buffers are pooled
+ *
+ *  @returns buffer or NULL
+ */
+static char* xfer_buffer_get(size_t size) {
+  if(size == XFER_BUFFERSIZE && xfer_pool_count > 0)
+    return xfer_pool[--xfer_pool_count];
+
+  return (char*)malloc(size);
+}
+
+/*! return a transfer buffer to the pool
+ *
+ *  @param[in] buffer buffer to return
+ *  @param[in] size   buffer size
+ */
+static void xfer_buffer_put(char *buffer, size_t size) {
+  if(buffer == NULL)
+    return;
+
+  if(size == XFER_BUFFERSIZE && xfer_pool_count < XFER_POOL_SIZE)
+    xfer_pool[xfer_pool_count++] = buffer;
+  else
+    free(buffer);
+}
+
+/*! make sure the session holds a buffer of at least @p size bytes
  *
  *  @param[in] session ftp session
+ *  @param[in] size    minimum size
+ *
+ *  @returns -1 for error
+ *
+ *  @note a smaller buffer is replaced, its contents are lost
  */
-static void ftp_session_close_file(ftp_session_t *session) {
-  if(session->fp != NULL)
-  {
-    fclose(session->fp);
-  }
+static int ftp_session_get_buffer(ftp_session_t *session, size_t size) {
+  if(session->buffer != NULL && session->buffercap >= size)
+    return 0;
 
-  session->fp      = NULL;
-  session->filepos = 0;
+  xfer_buffer_put(session->buffer, session->buffercap);
+  session->buffer    = xfer_buffer_get(size);
+  session->buffercap = session->buffer != NULL ? size : 0;
+
+  return session->buffer != NULL ? 0 : -1;
+}
+
+/*! give the session buffer back to the pool
+ *
+ *  @param[in] session ftp session
+ */
+static void ftp_session_put_buffer(ftp_session_t *session) {
+  xfer_buffer_put(session->buffer, session->buffercap);
+  session->buffer    = NULL;
+  session->buffercap = 0;
 }
 
 /*! open file for reading for ftp session
@@ -388,18 +452,14 @@ static int ftp_session_open_file_read(ftp_session_t *session) {
   struct stat st;
 
   /* open file in read mode */
-  session->fp = fopen(session->buffer, "rb");
-  if(session->fp == NULL)
+  session->fd = open(session->buffer, O_RDONLY);
+  if(session->fd < 0)
   {
     return -1;
   }
 
-  /* it's okay if this fails */
-  errno = 0;
-  setvbuf(session->fp, session->file_buffer, _IOFBF, FILE_BUFFERSIZE);
-
   /* get the file size */
-  rc = fstat(fileno(session->fp), &st);
+  rc = fstat(session->fd, &st);
   if(rc != 0)
   {
     return -1;
@@ -408,8 +468,7 @@ static int ftp_session_open_file_read(ftp_session_t *session) {
 
   if(session->filepos != 0)
   {
-    rc = fseek(session->fp, session->filepos, SEEK_SET);
-    if(rc != 0)
+    if(lseek(session->fd, session->filepos, SEEK_SET) < 0)
     {
       return -1;
     }
@@ -427,8 +486,8 @@ static int ftp_session_open_file_read(ftp_session_t *session) {
 static ssize_t ftp_session_read_file(ftp_session_t *session) {
   ssize_t rc;
 
-  /* read file at current position */
-  rc = fread(session->buffer, 1, sizeof(session->buffer), session->fp);
+  /* read file at current position straight into the buffer that gets sent */
+  rc = read(session->fd, session->buffer, XFER_BUFFERSIZE);
   if(rc < 0)
   {
     return -1;
@@ -450,31 +509,25 @@ static ssize_t ftp_session_read_file(ftp_session_t *session) {
  *  @note truncates file
  */
 static int ftp_session_open_file_write(ftp_session_t *session, bool append) {
-  int        rc;
-  const char *mode = "wb";
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
 
   if(append)
-    mode = "ab";
+    flags = O_WRONLY | O_CREAT | O_APPEND;
   else if(session->filepos != 0)
-    mode = "r+b";
+    flags = O_WRONLY;
 
   /* open file in write mode */
-  session->fp = fopen(session->buffer, mode);
-  if(session->fp == NULL)
+  session->fd = open(session->buffer, flags, 0644);
+  if(session->fd < 0)
   {
     return -1;
   }
 
-  /* it's okay if this fails */
-  errno = 0;
-  rc = setvbuf(session->fp, session->file_buffer, _IOFBF, FILE_BUFFERSIZE);
-
   /* check if this had REST but not APPE */
   if(session->filepos != 0 && !append)
   {
     /* seek to the REST offset */
-    rc = fseek(session->fp, session->filepos, SEEK_SET);
-    if(rc != 0)
+    if(lseek(session->fd, session->filepos, SEEK_SET) < 0)
     {
       return -1;
     }
@@ -483,28 +536,53 @@ static int ftp_session_open_file_write(ftp_session_t *session, bool append) {
   return 0;
 }
 
-/*! write to an open file for ftp session
+/*! write the buffered data to an open file for ftp session
  *
  *  @param[in] session ftp session
  *
- *  @returns bytes written
+ *  @returns -1 for error
  */
-static ssize_t ftp_session_write_file(ftp_session_t *session) {
+static int ftp_session_write_file(ftp_session_t *session) {
   ssize_t rc;
 
   /* write to file at current position */
-  rc = fwrite(session->buffer + session->bufferpos,
-              1, session->buffersize - session->bufferpos,
-              session->fp);
-  if(rc < 0)
+  while(session->bufferpos < session->buffersize)
   {
-    return -1;
+    rc = write(session->fd, session->buffer + session->bufferpos,
+               session->buffersize - session->bufferpos);
+    if(rc < 0)
+    {
+      if(errno == EINTR)
+        continue;
+      return -1;
+    }
+
+    /* adjust file position */
+    session->bufferpos += rc;
+    session->filepos   += rc;
   }
 
-  /* adjust file position */
-  session->filepos += rc;
+  session->bufferpos  = 0;
+  session->buffersize = 0;
 
-  return rc;
+  return 0;
+}
+
+/*! close open file for ftp session
+ *
+ *  @param[in] session ftp session
+ */
+static void ftp_session_close_file(ftp_session_t *session) {
+  /* an aborted upload still stores what it received, like the stdio buffer used to */
+  if(session->fd >= 0 && session->buffer != NULL && session->transfer == store_transfer)
+    ftp_session_write_file(session);
+
+  if(session->fd >= 0)
+  {
+    close(session->fd);
+  }
+  session->fd      = -1;
+  session->filepos = 0;
 }
 
 /*! close current working directory for ftp session
@@ -615,7 +693,7 @@ ftp_session_fill_dirent_type(ftp_session_t *session, const struct stat *st,
 
       session->buffersize +=
         strftime(session->buffer + session->buffersize,
-                 sizeof(session->buffer) - session->buffersize,
+                 XFER_BUFFERSIZE - session->buffersize,
                  "Modify=%Y%m%d%H%M%S;", tm);
       if(session->buffersize == 0)
         return EOVERFLOW;
@@ -717,7 +795,7 @@ ftp_session_fill_dirent_type(ftp_session_t *session, const struct stat *st,
 
       session->buffersize +=
         strftime(session->buffer + session->buffersize,
-                 sizeof(session->buffer) - session->buffersize,
+                 XFER_BUFFERSIZE - session->buffersize,
                  fmt, tm);
     }
     else
@@ -727,7 +805,7 @@ ftp_session_fill_dirent_type(ftp_session_t *session, const struct stat *st,
     }
   }
 
-  if(session->buffersize + len + 2 > sizeof(session->buffer))
+  if(session->buffersize + len + 2 > XFER_BUFFERSIZE)
   {
     /* buffer will overflow */
     return EOVERFLOW;
@@ -965,6 +1043,7 @@ static ftp_session_t* ftp_session_destroy(ftp_session_t *session) {
   ftp_session_close_data(session);
   ftp_session_close_file(session);
   ftp_session_close_cwd(session);
+  ftp_session_put_buffer(session);
 
   /* unlink from sessions list */
   if(session->next)
@@ -1016,6 +1095,7 @@ static void ftp_session_new(int listen_fd) {
   session->cmd_fd     = new_fd;
   session->pasv_fd    = -1;
   session->data_fd    = -1;
+  session->fd         = -1;
   session->mlst_flags = SESSION_MLST_TYPE
                       | SESSION_MLST_SIZE
                       | SESSION_MLST_MODIFY
@@ -1486,6 +1566,10 @@ static ftp_session_t* ftp_session_poll(ftp_session_t *session) {
     }
   }
 
+  /* idle sessions do not hold on to transfer memory, RNFR keeps its path for RNTO */
+  if(session->state == COMMAND_STATE && !(session->flags & SESSION_RENAME))
+    ftp_session_put_buffer(session);
+
   /* still connected to peer; return next session */
   if(session->cmd_fd >= 0)
     return session->next;
@@ -1552,6 +1636,65 @@ void ftp_exit(void) {
   /* stop listening for new clients */
   if(listenfd >= 0)
     ftp_closesocket(listenfd, false);
+
+  /* release idle transfer buffers */
+  while(xfer_pool_count > 0)
+    free(xfer_pool[--xfer_pool_count]);
+}
+
+/*! collect the sockets ftp is waiting on
+ *
+ *  Mirrors the events ftp_loop() and ftp_session_poll() check, so a caller
+ *  can sleep in a single poll() and only run ftp_loop() once one is ready.
+ *
+ *  @param[out] fds pollfd array to fill
+ *  @param[in]  max size of @p fds
+ *
+ *  @returns number of sockets, only the first @p max are written
+ */
+int ftp_pollfds(struct pollfd *fds, int max) {
+  int           n = 0;
+  ftp_session_t *session;
+
+#define FTP_POLLFD(sock, ev) \
+  do { \
+    if(n < max) \
+    { \
+      fds[n].fd      = (sock); \
+      fds[n].events  = (ev); \
+      fds[n].revents = 0; \
+    } \
+    ++n; \
+  } while(0)
+
+  if(listenfd >= 0)
+    FTP_POLLFD(listenfd, POLLIN);
+
+  for(session = sessions; session != NULL; session = session->next)
+  {
+    FTP_POLLFD(session->cmd_fd, POLLIN | POLLPRI);
+
+    switch(session->state)
+    {
+      case COMMAND_STATE:
+        break;
+
+      case DATA_CONNECT_STATE:
+        if(session->flags & SESSION_PASV)
+          FTP_POLLFD(session->pasv_fd, POLLIN);
+        else
+          FTP_POLLFD(session->data_fd, POLLOUT);
+        break;
+
+      case DATA_TRANSFER_STATE:
+        FTP_POLLFD(session->data_fd, (session->flags & SESSION_RECV) ? POLLIN : POLLOUT);
+        break;
+    }
+  }
+
+#undef FTP_POLLFD
+
+  return n;
 }
 
 /*! ftp look
@@ -1650,7 +1793,12 @@ static int build_path(ftp_session_t *session, const char *cwd, const char *args)
   char *p;
 
   session->buffersize = 0;
-  memset(session->buffer, 0, sizeof(session->buffer));
+  if(ftp_session_get_buffer(session, XFER_BUFFERSIZE) != 0)
+  {
+    errno = ENOMEM;
+    return -1;
+  }
+  memset(session->buffer, 0, XFER_BUFFERSIZE);
 
   /* make sure the input is a valid path */
   if(validate_path(args) != 0)
@@ -1663,7 +1811,7 @@ static int build_path(ftp_session_t *session, const char *cwd, const char *args)
   {
     /* this is an absolute path */
     size_t len = strlen(args);
-    if(len > sizeof(session->buffer)-1)
+    if(len > XFER_BUFFERSIZE-1)
     {
       errno = ENAMETOOLONG;
       return -1;
@@ -1676,13 +1824,13 @@ static int build_path(ftp_session_t *session, const char *cwd, const char *args)
   {
     /* this is a relative path */
     if(strcmp(cwd, "/") == 0)
-      rc = snprintf(session->buffer, sizeof(session->buffer), "/%s",
+      rc = snprintf(session->buffer, XFER_BUFFERSIZE, "/%s",
                     args);
     else
-      rc = snprintf(session->buffer, sizeof(session->buffer), "%s/%s",
+      rc = snprintf(session->buffer, XFER_BUFFERSIZE, "%s/%s",
                     cwd, args);
 
-    if((long unsigned int)rc >= sizeof(session->buffer))
+    if((long unsigned int)rc >= XFER_BUFFERSIZE)
     {
       errno = ENAMETOOLONG;
       return -1;
@@ -1837,6 +1985,43 @@ static loop_status_t list_transfer(ftp_session_t *session) {
 static loop_status_t retrieve_transfer(ftp_session_t *session) {
   ssize_t rc;
 
+#if defined(FTP_SENDFILE)
+  if(!sendfile_unsupported && session->bufferpos == session->buffersize)
+  {
+    /* let the kernel copy straight from the file to the socket */
+    off_t offset = session->filepos;
+    rc = sendfile(session->data_fd, session->fd, &offset, XFER_BUFFERSIZE);
+    if(rc > 0)
+    {
+      session->filepos = offset;
+      return LOOP_CONTINUE;
+    }
+    else if(rc == 0)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 226, "OK\r\n");
+      return LOOP_EXIT;
+    }
+    else if(errno == EWOULDBLOCK)
+      return LOOP_EXIT;
+    else if(errno != EINVAL && errno != ENOSYS)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 426, "Connection broken during transfer\r\n");
+      return LOOP_EXIT;
+    }
+
+    /* this file can't be sent with sendfile, use the buffered path from now on */
+    sendfile_unsupported = true;
+    if(lseek(session->fd, session->filepos, SEEK_SET) < 0)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 451, "Failed to read file\r\n");
+      return LOOP_EXIT;
+    }
+  }
+#endif
+
   if(session->bufferpos == session->buffersize)
   {
     /* we have sent all the data so read some more */
@@ -1880,7 +2065,7 @@ static loop_status_t retrieve_transfer(ftp_session_t *session) {
   return LOOP_CONTINUE;
 }
 
-/*! send a file to the client
+/*! receive a file from the client
  *
  *  @param[in] session ftp session
  *
@@ -1889,35 +2074,21 @@ static loop_status_t retrieve_transfer(ftp_session_t *session) {
 static loop_status_t store_transfer(ftp_session_t *session) {
   ssize_t rc;
 
-  if(session->bufferpos == session->buffersize)
-  {
-    /* we have written all the received data, so try to get some more */
-    rc = recv(session->data_fd, session->buffer, sizeof(session->buffer), 0);
-    if(rc <= 0)
-    {
-      /* can't read any more data */
-      if(rc < 0)
-      {
-        if(errno == EWOULDBLOCK)
-          return LOOP_EXIT;
-      }
-
-      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-
-      if(rc == 0)
-        ftp_send_response(session, 226, "OK\r\n");
-      else
-        ftp_send_response(session, 426, "Connection broken during transfer\r\n");
-      return LOOP_EXIT;
-    }
+  /* receive straight into the session buffer, it is written out once full */
+  rc = recv(session->data_fd, session->buffer + session->buffersize,
+            session->buffercap - session->buffersize, 0);
+  if(rc < 0 && errno == EWOULDBLOCK)
+    return LOOP_EXIT;
 
-    /* we received some data so reset the session buffer to write */
-    session->bufferpos  = 0;
-    session->buffersize = rc;
+  if(rc > 0)
+  {
+    session->buffersize += rc;
+    if(session->buffersize < session->buffercap)
+      return LOOP_CONTINUE;
   }
 
-  rc = ftp_session_write_file(session);
-  if(rc <= 0)
+  /* the buffer is full or the transfer is over, write what we have */
+  if(ftp_session_write_file(session) != 0)
   {
     /* error writing data */
     ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
@@ -1925,8 +2096,19 @@ static loop_status_t store_transfer(ftp_session_t *session) {
     return LOOP_EXIT;
   }
 
+  if(rc <= 0)
+  {
+    /* can't read any more data */
+    ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+
+    if(rc == 0)
+      ftp_send_response(session, 226, "OK\r\n");
+    else
+      ftp_send_response(session, 426, "Connection broken during transfer\r\n");
+    return LOOP_EXIT;
+  }
+
   /* we can try to receive more data */
-  session->bufferpos += rc;
   return LOOP_CONTINUE;
 }
 
@@ -1971,6 +2153,14 @@ static void ftp_xfer_file(ftp_session_t *session, const char *args, xfer_file_mo
     return;
   }
 
+  /* the path is not needed anymore, uploads may want a larger buffer */
+  if(mode != XFER_FILE_RETR && ftp_session_get_buffer(session, STOR_BUFFERSIZE) != 0)
+  {
+    ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+    ftp_send_response(session, 451, "Failed to write file\r\n");
+    return;
+  }
+
   if(session->flags & (SESSION_PORT|SESSION_PASV))
   {
     ftp_session_set_state(session, DATA_CONNECT_STATE, CLOSE_DATA);
@@ -2029,6 +2219,14 @@ ftp_xfer_dir(ftp_session_t   *session,
   struct stat st;
   char        *buffer;
 
+  /* the listing is formatted into the session buffer */
+  if(ftp_session_get_buffer(session, XFER_BUFFERSIZE) != 0)
+  {
+    ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+    ftp_send_response(session, 451, "%s\r\n", strerror(ENOMEM));
+    return;
+  }
+
   /* set up the transfer */
   session->dir_mode = mode;
   session->flags &= ~SESSION_RECV;
@@ -2463,7 +2661,7 @@ FTP_DECLARE(MDTM)
     return;
   }
 
-  session->buffersize = strftime(session->buffer, sizeof(session->buffer), "%Y%m%d%H%M%S", tm);
+  session->buffersize = strftime(session->buffer, XFER_BUFFERSIZE, "%Y%m%d%H%M%S", tm);
   if(session->buffersize == 0)
   {
     ftp_send_response(session, 550, "Error getting mtime\r\n");
@@ -1,6 +1,8 @@
 #ifndef FTP_H
 #define FTP_H
 
+#include <poll.h>
+
 /*! Loop status */
 typedef enum {
   LOOP_CONTINUE, /*!< Continue looping */
@@ -11,5 +13,6 @@ typedef enum {
 int           ftp_init(void);
 loop_status_t ftp_loop(void);
 void          ftp_exit(void);
+int           ftp_pollfds(struct pollfd *fds, int max);
 
 #endif
@@ -26,36 +26,86 @@
 
 #include "Screen.hpp"
 #include "Overlay.hpp"
+#include "PerfOverlay.hpp"
+#include "trace.hpp"
+#if defined(_3DS)
+#include "gui.hpp"
+#elif defined(__SWITCH__)
+#include "SDLHelper.hpp"
+#endif
 
 #if defined(_3DS)
 
 void Screen::doDrawTop() const
 {
-    drawTop();
-    if (currentOverlay) {
-        currentOverlay->drawTop();
+    TRACE_SCOPE("Screen::doDrawTop");
+    if (redraw || !Gui::hasCache()) {
+        Gui::beginCache(GFX_TOP);
+        drawTop();
+        if (currentOverlay) {
+            // the screen is dimmed below the overlay, its outlines stay in the cache as they are
+            Gui::dropAnimations();
+            currentOverlay->drawTop();
+        }
     }
+    Gui::drawCache(GFX_TOP);
+    drawHud();
 }
 
 void Screen::doDrawBottom() const
 {
-    drawBottom();
-    if (currentOverlay) {
-        currentOverlay->drawBottom();
+    TRACE_SCOPE("Screen::doDrawBottom");
+    if (redraw || !Gui::hasCache()) {
+        Gui::beginCache(GFX_BOTTOM);
+        drawBottom();
+        if (currentOverlay) {
+            Gui::dropAnimations();
+            currentOverlay->drawBottom();
+        }
     }
+    Gui::drawCache(GFX_BOTTOM);
 }
 
 #elif defined(__SWITCH__)
 
 void Screen::doDraw() const
 {
-    draw();
-    if (currentOverlay) {
-        currentOverlay->draw();
+    TRACE_SCOPE("Screen::doDraw");
+    if (redraw || !SDLH_HasCache()) {
+        SDLH_BeginCache();
+        draw();
+        if (currentOverlay) {
+            // the screen is dimmed below the overlay, its outlines stay in the cache as they are
+            SDLH_DropAnimations();
+            currentOverlay->draw();
+        }
+    }
+    SDLH_DrawCache();
+    drawHud();
+}
+
+#endif
+
+void Screen::toggleHud(void)
+{
+    if (hud) {
+        hud = nullptr;
+    }
+    else {
+        hud = std::make_shared<PerfOverlay>(*this);
     }
 }
 
+void Screen::drawHud(void) const
+{
+    if (hud) {
+#if defined(_3DS)
+        hud->drawTop();
+#elif defined(__SWITCH__)
+        hud->draw();
 #endif
+    }
+}
 
 void Screen::doUpdate(touchPosition* touch)
 {
@@ -65,4 +115,12 @@ void Screen::doUpdate(touchPosition* touch)
     else {
         update(touch);
     }
-}
\ No newline at end of file
+
+#if defined(_3DS)
+    const bool input = hidKeysDown() | hidKeysHeld() | hidKeysUp();
+#elif defined(__SWITCH__)
+    const bool input = (hidKeysDown(CONTROLLER_P1_AUTO) | hidKeysHeld(CONTROLLER_P1_AUTO) | hidKeysUp(CONTROLLER_P1_AUTO)) || hidTouchCount() > 0;
+#endif
+    // clear the flag before drawing, so a markDirty racing with this frame schedules the next one
+    redraw = dirty.exchange(false) || input;
+}
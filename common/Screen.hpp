@@ -32,6 +32,7 @@
 #elif defined(__SWITCH__)
 #include <switch.h>
 #endif
+#include <atomic>
 #include <memory>
 
 class Overlay;
@@ -55,13 +56,32 @@ public:
     virtual void doDraw() const final;
     virtual void draw() const = 0;
 #endif
-    void removeOverlay() { currentOverlay = nullptr; }
-    void setOverlay(std::shared_ptr<Overlay>& overlay) { currentOverlay = overlay; }
+    void removeOverlay()
+    {
+        currentOverlay = nullptr;
+        dirty          = true;
+    }
+    void setOverlay(std::shared_ptr<Overlay>& overlay)
+    {
+        currentOverlay = overlay;
+        dirty          = true;
+    }
+    // Frames are redrawn after input and after markDirty, which is safe to call from worker threads that change what is drawn.
+    // Other frames show the cached one, only pulsing outlines keep animating
+    void markDirty(void) { dirty = true; }
+    // The performance hud is drawn above everything else, including the current overlay, and never receives input
+    void toggleHud(void);
+    void drawHud(void) const;
 
 protected:
     // No point in restricting this to only being editable during update, especially since it's drawn afterwards. Allows setting it before the first
     // draw loop is done
     mutable std::shared_ptr<Overlay> currentOverlay = nullptr;
+    std::shared_ptr<Overlay> hud                    = nullptr;
+
+private:
+    std::atomic<bool> dirty{true};
+    bool redraw = true;
 };
 
 #endif
\ No newline at end of file
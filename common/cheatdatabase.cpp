@@ -0,0 +1,408 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "cheatdatabase.hpp"
+#include "compression.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+    const char MAGIC[4]    = {'C', 'K', 'D', 'B'};
+    const uint16_t VERSION = 1;
+
+    const size_t WRITE_BUFFER_SIZE = 0x4000;
+    // the largest title in the sharkive database decodes to a few hundred KiB, anything far above that is corruption
+    const uint32_t MAX_BLOCK_SIZE = 0x1000000;
+
+    struct Header {
+        char magic[4];
+        uint16_t version;
+        uint16_t codec;
+        uint32_t titles;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 16, "unexpected cheat database header size");
+}
+
+CheatBlock::CheatBlock(std::unique_ptr<uint8_t[]> data, size_t size)
+    : mData(std::move(data)),
+      mSize(size),
+      mGood(false),
+      mBuilds(0),
+      mCheats(0),
+      mLines(0),
+      mBuildTable(nullptr),
+      mCheatTable(nullptr),
+      mLineTable(nullptr),
+      mPool(nullptr),
+      mPoolSize(0)
+{
+    if (mSize < 3 * sizeof(uint32_t)) {
+        return;
+    }
+
+    const uint32_t* header = (const uint32_t*)mData.get();
+    const uint64_t tables  = 3 * sizeof(uint32_t) + ((uint64_t)header[0] + header[1]) * sizeof(Entry) + (uint64_t)header[2] * sizeof(uint32_t);
+    if (tables >= mSize) {
+        return;
+    }
+
+    const Entry* buildTable   = (const Entry*)(header + 3);
+    const Entry* cheatTable   = buildTable + header[0];
+    const uint32_t* lineTable = (const uint32_t*)(cheatTable + header[1]);
+    const char* pool          = (const char*)(lineTable + header[2]);
+    const size_t poolSize     = mSize - tables;
+
+    // every string must be nul terminated inside the pool
+    if (pool[poolSize - 1] != '\0') {
+        return;
+    }
+    for (uint32_t i = 0; i < header[0]; i++) {
+        if (buildTable[i].name >= poolSize || (uint64_t)buildTable[i].first + buildTable[i].count > header[1]) {
+            return;
+        }
+    }
+    for (uint32_t i = 0; i < header[1]; i++) {
+        if (cheatTable[i].name >= poolSize || (uint64_t)cheatTable[i].first + cheatTable[i].count > header[2]) {
+            return;
+        }
+    }
+    for (uint32_t i = 0; i < header[2]; i++) {
+        if (lineTable[i] >= poolSize) {
+            return;
+        }
+    }
+
+    mBuilds     = header[0];
+    mCheats     = header[1];
+    mLines      = header[2];
+    mBuildTable = buildTable;
+    mCheatTable = cheatTable;
+    mLineTable  = lineTable;
+    mPool       = pool;
+    mPoolSize   = poolSize;
+    mGood       = true;
+}
+
+std::shared_ptr<CheatBlock> CheatBlock::fromJson(const nlohmann::json& title)
+{
+    if (!title.is_object()) {
+        return nullptr;
+    }
+
+    // 3ds titles map cheat names to lines directly, switch titles have a build id level in between
+    bool flat = true;
+    for (auto it = title.begin(); it != title.end(); ++it) {
+        flat = flat && it.value().is_array();
+    }
+
+    std::vector<std::pair<std::string, const nlohmann::json*>> builds;
+    if (flat) {
+        builds.emplace_back("", &title);
+    }
+    else {
+        for (auto it = title.begin(); it != title.end(); ++it) {
+            if (it.value().is_object()) {
+                builds.emplace_back(it.key(), &it.value());
+            }
+        }
+    }
+
+    std::string pool;
+    auto addString = [&pool](const std::string& str) {
+        uint32_t offset = pool.size();
+        pool.append(str.c_str(), str.size() + 1);
+        return offset;
+    };
+
+    std::vector<uint32_t> buildTable, cheatTable, lineTable;
+    for (auto& build : builds) {
+        buildTable.push_back(addString(build.first));
+        buildTable.push_back(cheatTable.size() / 3);
+        buildTable.push_back(0);
+        for (auto it = build.second->begin(); it != build.second->end(); ++it) {
+            if (!it.value().is_array()) {
+                continue;
+            }
+            cheatTable.push_back(addString(it.key()));
+            cheatTable.push_back(lineTable.size());
+            cheatTable.push_back(0);
+            for (auto& line : it.value()) {
+                if (line.is_string()) {
+                    lineTable.push_back(addString(line.get<std::string>()));
+                    cheatTable.back()++;
+                }
+            }
+            buildTable.back()++;
+        }
+    }
+
+    const uint32_t header[3] = {(uint32_t)(buildTable.size() / 3), (uint32_t)(cheatTable.size() / 3), (uint32_t)lineTable.size()};
+    const size_t size        = sizeof(header) + (buildTable.size() + cheatTable.size() + lineTable.size()) * sizeof(uint32_t) + pool.size();
+    std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    uint8_t* p  = data.get();
+    auto append = [&p](const void* src, size_t len) {
+        // empty tables may have no storage at all, memcpy wants a valid pointer even for 0 bytes
+        if (len > 0) {
+            memcpy(p, src, len);
+            p += len;
+        }
+    };
+    append(header, sizeof(header));
+    append(buildTable.data(), buildTable.size() * sizeof(uint32_t));
+    append(cheatTable.data(), cheatTable.size() * sizeof(uint32_t));
+    append(lineTable.data(), lineTable.size() * sizeof(uint32_t));
+    append(pool.data(), pool.size());
+
+    return std::make_shared<CheatBlock>(std::move(data), size);
+}
+
+const CheatBlock::Entry* CheatBlock::build(uint32_t build) const
+{
+    return mBuildTable + build;
+}
+
+const CheatBlock::Entry* CheatBlock::cheat(uint32_t build, uint32_t cheat) const
+{
+    return mCheatTable + mBuildTable[build].first + cheat;
+}
+
+uint32_t CheatBlock::builds(void) const
+{
+    return mBuilds;
+}
+
+const char* CheatBlock::buildId(uint32_t build) const
+{
+    return mPool + this->build(build)->name;
+}
+
+uint32_t CheatBlock::cheats(uint32_t build) const
+{
+    return this->build(build)->count;
+}
+
+const char* CheatBlock::cheatName(uint32_t build, uint32_t cheat) const
+{
+    return mPool + this->cheat(build, cheat)->name;
+}
+
+uint32_t CheatBlock::lines(uint32_t build, uint32_t cheat) const
+{
+    return this->cheat(build, cheat)->count;
+}
+
+const char* CheatBlock::line(uint32_t build, uint32_t cheat, uint32_t line) const
+{
+    return mPool + mLineTable[this->cheat(build, cheat)->first + line];
+}
+
+bool CheatBlock::save(const std::string& path, uint32_t build, const std::unordered_set<std::string_view>& selected) const
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (f == NULL) {
+        return false;
+    }
+
+    // write straight from the block through a large stdio buffer, no intermediate copies
+    std::unique_ptr<char[]> buffer(new char[WRITE_BUFFER_SIZE]);
+    setvbuf(f, buffer.get(), _IOFBF, WRITE_BUFFER_SIZE);
+
+    bool ok = true;
+    for (uint32_t i = 0; i < cheats(build) && ok; i++) {
+        const char* name = cheatName(build, i);
+        if (selected.find(name) == selected.end()) {
+            continue;
+        }
+        ok = fputc('[', f) != EOF && fputs(name, f) != EOF && fputs("]\n", f) != EOF;
+        for (uint32_t j = 0; j < lines(build, i) && ok; j++) {
+            ok = fputs(line(build, i, j), f) != EOF && fputc('\n', f) != EOF;
+        }
+        ok = ok && fputc('\n', f) != EOF;
+    }
+
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+CheatDatabase::CheatDatabase(void)
+{
+    mCodec = Compression::CODEC_NONE;
+}
+
+bool CheatDatabase::load(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        Logger::getInstance().log(Logger::WARN, "Failed to open " + path + " with errno %d.", errno);
+        return false;
+    }
+
+    // only the header and the title index are loaded, blocks are read on demand
+    Header header;
+    if (fread(&header, sizeof(Header), 1, f) != 1 || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        Logger::getInstance().log(Logger::ERROR, "Invalid cheat database " + path + ".");
+        fclose(f);
+        return false;
+    }
+
+    if (!Compression::available(header.codec)) {
+        Logger::getInstance().log(Logger::ERROR, "Unsupported cheat database codec %s.", Compression::name(header.codec));
+        fclose(f);
+        return false;
+    }
+
+    // the title count comes from the file, it must fit in it before anything gets allocated for it
+    long fileSize = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (fileSize < (long)sizeof(Header) || header.titles > ((uint64_t)fileSize - sizeof(Header)) / sizeof(IndexEntry) ||
+        fseek(f, sizeof(Header), SEEK_SET) != 0) {
+        Logger::getInstance().log(Logger::ERROR, "Truncated cheat database " + path + ".");
+        fclose(f);
+        return false;
+    }
+
+    mIndex.resize(header.titles);
+    if (fread(mIndex.data(), sizeof(IndexEntry), mIndex.size(), f) != mIndex.size()) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to read the cheat database index.");
+        mIndex.clear();
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    for (const IndexEntry& entry : mIndex) {
+        if ((uint64_t)entry.offset + entry.compressedSize > (uint64_t)fileSize || entry.size > MAX_BLOCK_SIZE ||
+            (header.codec == Compression::CODEC_NONE && entry.size != entry.compressedSize)) {
+            Logger::getInstance().log(Logger::ERROR, "Corrupted cheat database index in " + path + ".");
+            mIndex.clear();
+            return false;
+        }
+    }
+
+    if (!std::is_sorted(mIndex.begin(), mIndex.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.id < b.id; })) {
+        std::sort(mIndex.begin(), mIndex.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.id < b.id; });
+    }
+
+    mPath  = path;
+    mCodec = header.codec;
+    return true;
+}
+
+bool CheatDatabase::loadJson(const std::string& path)
+{
+    FILE* in = fopen(path.c_str(), "rt");
+    if (in == NULL) {
+        Logger::getInstance().log(Logger::WARN, "Failed to open " + path + " with errno %d.", errno);
+        return false;
+    }
+    mJson = std::make_unique<nlohmann::json>(nlohmann::json::parse(in, nullptr, false));
+    fclose(in);
+
+    if (!mJson->is_object()) {
+        Logger::getInstance().log(Logger::ERROR, "Invalid cheat database " + path + ".");
+        mJson = nullptr;
+        return false;
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> keys;
+    for (auto it = mJson->begin(); it != mJson->end(); ++it) {
+        char* end;
+        uint64_t id = strtoull(it.key().c_str(), &end, 16);
+        if (*end == '\0') {
+            keys.emplace_back(id, it.key());
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (auto& key : keys) {
+        mIndex.push_back({key.first, 0, 0, 0, 0});
+        mJsonKeys.push_back(key.second);
+    }
+
+    mPath = path;
+    return true;
+}
+
+const CheatDatabase::IndexEntry* CheatDatabase::find(uint64_t id) const
+{
+    auto it = std::lower_bound(mIndex.begin(), mIndex.end(), id, [](const IndexEntry& entry, uint64_t id) { return entry.id < id; });
+    return it != mIndex.end() && it->id == id ? &*it : nullptr;
+}
+
+bool CheatDatabase::contains(uint64_t id) const
+{
+    return find(id) != nullptr;
+}
+
+std::shared_ptr<CheatBlock> CheatDatabase::block(uint64_t id) const
+{
+    const IndexEntry* entry = find(id);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    if (mJson) {
+        auto it = mJson->find(mJsonKeys[entry - mIndex.data()]);
+        return it != mJson->end() ? CheatBlock::fromJson(it.value()) : nullptr;
+    }
+
+    FILE* f = fopen(mPath.c_str(), "rb");
+    if (f == NULL) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to open " + mPath + " with errno %d.", errno);
+        return nullptr;
+    }
+
+    // the sizes were checked when the index was loaded, the heap may still be too fragmented for them
+    std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[entry->size]);
+    std::unique_ptr<uint8_t[]> compressed(new (std::nothrow) uint8_t[entry->compressedSize]);
+    if (!data || !compressed) {
+        fclose(f);
+        Logger::getInstance().log(Logger::ERROR, "Not enough memory for the cheats of title %016llX.", id);
+        return nullptr;
+    }
+    bool ok = fseek(f, entry->offset, SEEK_SET) == 0 && fread(compressed.get(), 1, entry->compressedSize, f) == entry->compressedSize;
+    fclose(f);
+
+    if (!ok) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to read cheats for title %016llX.", id);
+        return nullptr;
+    }
+    if (!Compression::decompress(mCodec, data.get(), entry->size, compressed.get(), entry->compressedSize)) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to decompress cheats for title %016llX.", id);
+        return nullptr;
+    }
+
+    auto block = std::make_shared<CheatBlock>(std::move(data), entry->size);
+    if (!block->good()) {
+        Logger::getInstance().log(Logger::ERROR, "Corrupted cheats for title %016llX.", id);
+        return nullptr;
+    }
+    return block;
+}
@@ -0,0 +1,106 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef CHEATDATABASE_HPP
+#define CHEATDATABASE_HPP
+
+#include "json.hpp"
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// cheats of a single title, decoded from one block of the database
+class CheatBlock {
+public:
+    CheatBlock(std::unique_ptr<uint8_t[]> data, size_t size);
+
+    static std::shared_ptr<CheatBlock> fromJson(const nlohmann::json& title);
+
+    bool good(void) const { return mGood; }
+    uint32_t builds(void) const;
+    const char* buildId(uint32_t build) const;
+    uint32_t cheats(uint32_t build) const;
+    const char* cheatName(uint32_t build, uint32_t cheat) const;
+    uint32_t lines(uint32_t build, uint32_t cheat) const;
+    const char* line(uint32_t build, uint32_t cheat, uint32_t line) const;
+
+    // streams the selected cheats of a build to path in the atmosphere/luma text format
+    bool save(const std::string& path, uint32_t build, const std::unordered_set<std::string_view>& selected) const;
+
+private:
+    struct Entry {
+        uint32_t name;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    const Entry* build(uint32_t build) const;
+    const Entry* cheat(uint32_t build, uint32_t cheat) const;
+
+    std::unique_ptr<uint8_t[]> mData;
+    size_t mSize;
+    bool mGood;
+    uint32_t mBuilds, mCheats, mLines;
+    const Entry* mBuildTable;
+    const Entry* mCheatTable;
+    const uint32_t* mLineTable;
+    const char* mPool;
+    size_t mPoolSize;
+};
+
+class CheatDatabase {
+public:
+    CheatDatabase(void);
+
+    bool load(const std::string& path);
+    bool loadJson(const std::string& path);
+
+    bool contains(uint64_t id) const;
+    std::shared_ptr<CheatBlock> block(uint64_t id) const;
+
+private:
+    struct IndexEntry {
+        uint64_t id;
+        uint32_t offset;
+        uint32_t compressedSize;
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    const IndexEntry* find(uint64_t id) const;
+
+    std::string mPath;
+    uint16_t mCodec;
+    std::vector<IndexEntry> mIndex;
+    // only used for user provided json databases, mJsonKeys is parallel to mIndex
+    std::unique_ptr<nlohmann::json> mJson;
+    std::vector<std::string> mJsonKeys;
+};
+
+#endif
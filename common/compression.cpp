@@ -0,0 +1,168 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "compression.hpp"
+#include <bzlib.h>
+#include <string.h>
+#if defined(CHECKPOINT_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace {
+    // raw lz4 block format, without the frame header
+    bool lz4Decompress(uint8_t* dst, size_t dstSize, const uint8_t* src, size_t srcSize)
+    {
+        const uint8_t* ip   = src;
+        const uint8_t* iend = src + srcSize;
+        uint8_t* op         = dst;
+        uint8_t* oend       = dst + dstSize;
+
+        while (ip < iend) {
+            const uint8_t token = *ip++;
+
+            size_t literals = token >> 4;
+            if (literals == 15) {
+                uint8_t b;
+                do {
+                    if (ip >= iend) {
+                        return false;
+                    }
+                    b = *ip++;
+                    literals += b;
+                } while (b == 255);
+            }
+            if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals) {
+                return false;
+            }
+            memcpy(op, ip, literals);
+            op += literals;
+            ip += literals;
+
+            // the last sequence only carries literals
+            if (ip == iend) {
+                break;
+            }
+
+            if (iend - ip < 2) {
+                return false;
+            }
+            const size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > (size_t)(op - dst)) {
+                return false;
+            }
+
+            size_t length = token & 15;
+            if (length == 15) {
+                uint8_t b;
+                do {
+                    if (ip >= iend) {
+                        return false;
+                    }
+                    b = *ip++;
+                    length += b;
+                } while (b == 255);
+            }
+            length += 4;
+            if ((size_t)(oend - op) < length) {
+                return false;
+            }
+
+            const uint8_t* match = op - offset;
+            if (offset >= length) {
+                memcpy(op, match, length);
+                op += length;
+            }
+            else {
+                // overlapping match, replicates the last offset bytes
+                while (length--) {
+                    *op++ = *match++;
+                }
+            }
+        }
+
+        return op == oend;
+    }
+}
+
+bool Compression::available(uint16_t codec)
+{
+    switch (codec) {
+        case CODEC_NONE:
+        case CODEC_BZIP2:
+        case CODEC_LZ4:
+            return true;
+#if defined(CHECKPOINT_ZSTD)
+        case CODEC_ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* Compression::name(uint16_t codec)
+{
+    switch (codec) {
+        case CODEC_NONE:
+            return "none";
+        case CODEC_BZIP2:
+            return "bzip2";
+        case CODEC_LZ4:
+            return "lz4";
+        case CODEC_ZSTD:
+            return "zstd";
+        default:
+            return "unknown";
+    }
+}
+
+bool Compression::decompress(uint16_t codec, void* dst, size_t dstSize, const void* src, size_t srcSize)
+{
+    switch (codec) {
+        case CODEC_NONE:
+            if (srcSize != dstSize) {
+                return false;
+            }
+            memcpy(dst, src, dstSize);
+            return true;
+        case CODEC_BZIP2: {
+            unsigned int destLen = dstSize;
+            int res              = BZ2_bzBuffToBuffDecompress((char*)dst, &destLen, (char*)src, srcSize, 0, 0);
+            return res == BZ_OK && destLen == dstSize;
+        }
+        case CODEC_LZ4:
+            return lz4Decompress((uint8_t*)dst, dstSize, (const uint8_t*)src, srcSize);
+#if defined(CHECKPOINT_ZSTD)
+        case CODEC_ZSTD: {
+            size_t res = ZSTD_decompress(dst, dstSize, src, srcSize);
+            return !ZSTD_isError(res) && res == dstSize;
+        }
+#endif
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,43 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Compression {
+    // codec ids are stored on disk, never renumber them
+    typedef enum { CODEC_NONE = 0, CODEC_BZIP2 = 1, CODEC_LZ4 = 2, CODEC_ZSTD = 3 } codec_t;
+
+    bool available(uint16_t codec);
+    const char* name(uint16_t codec);
+    // decompresses src into exactly dstSize bytes of dst
+    bool decompress(uint16_t codec, void* dst, size_t dstSize, const void* src, size_t srcSize);
+}
+
+#endif
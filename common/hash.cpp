@@ -0,0 +1,373 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "hash.hpp"
+#include <algorithm>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HASH_NEON 1
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+#define HASH_SHA2 1
+#endif
+#endif
+
+namespace {
+    const uint32_t K256[64] = {0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+        0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa,
+        0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138,
+        0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624,
+        0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f,
+        0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    const uint32_t PRIME32_1 = 0x9E3779B1U;
+    const uint32_t PRIME32_2 = 0x85EBCA77U;
+    const uint32_t PRIME32_3 = 0xC2B2AE3DU;
+    const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    const uint64_t SECRET[8] = {0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL, 0x78e5c0cc4ee679cbULL,
+        0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL};
+
+    // stripes accumulated before the accumulators get scrambled
+    const size_t STRIPES_PER_BLOCK = 16;
+
+    inline uint32_t rotr32(uint32_t x, int n)
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    inline uint32_t readBE32(const uint8_t* p)
+    {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    }
+
+    inline uint64_t readLE64(const uint8_t* p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+#if defined(HASH_SHA2)
+    void sha256Blocks(uint32_t* state, const uint8_t* data, size_t blocks)
+    {
+        uint32x4_t state0 = vld1q_u32(&state[0]);
+        uint32x4_t state1 = vld1q_u32(&state[4]);
+
+        while (blocks--) {
+            const uint32x4_t save0 = state0;
+            const uint32x4_t save1 = state1;
+
+            uint32x4_t msg[4];
+            for (size_t i = 0; i < 4; i++) {
+                msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+            }
+
+            for (size_t i = 0; i < 16; i++) {
+                const uint32x4_t wk = vaddq_u32(msg[i & 3], vld1q_u32(&K256[i * 4]));
+                if (i < 12) {
+                    msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]), msg[(i + 2) & 3], msg[(i + 3) & 3]);
+                }
+                const uint32x4_t abcd = state0;
+                state0                = vsha256hq_u32(state0, state1, wk);
+                state1                = vsha256h2q_u32(state1, abcd, wk);
+            }
+
+            state0 = vaddq_u32(state0, save0);
+            state1 = vaddq_u32(state1, save1);
+            data += 64;
+        }
+
+        vst1q_u32(&state[0], state0);
+        vst1q_u32(&state[4], state1);
+    }
+#else
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, i)                                                                                                      \
+    {                                                                                                                                                \
+        uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + K256[i] + w[i];                                   \
+        uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));                                               \
+        d += t1;                                                                                                                                     \
+        h = t1 + t2;                                                                                                                                 \
+    }
+
+    void sha256Blocks(uint32_t* state, const uint8_t* data, size_t blocks)
+    {
+        uint32_t w[64];
+        while (blocks--) {
+            for (size_t i = 0; i < 16; i++) {
+                w[i] = readBE32(data + i * 4);
+            }
+            for (size_t i = 16; i < 64; i++) {
+                uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i]        = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+            // eight rounds per iteration, rotating the variables instead of shuffling them
+            for (size_t i = 0; i < 64; i += 8) {
+                SHA256_ROUND(a, b, c, d, e, f, g, h, i + 0);
+                SHA256_ROUND(h, a, b, c, d, e, f, g, i + 1);
+                SHA256_ROUND(g, h, a, b, c, d, e, f, i + 2);
+                SHA256_ROUND(f, g, h, a, b, c, d, e, i + 3);
+                SHA256_ROUND(e, f, g, h, a, b, c, d, i + 4);
+                SHA256_ROUND(d, e, f, g, h, a, b, c, i + 5);
+                SHA256_ROUND(c, d, e, f, g, h, a, b, i + 6);
+                SHA256_ROUND(b, c, d, e, f, g, h, a, i + 7);
+            }
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+            data += 64;
+        }
+    }
+
+#undef SHA256_ROUND
+#endif
+
+#if defined(HASH_NEON)
+    void accumulate(uint64_t* acc, const uint8_t* data, const uint64_t* secret)
+    {
+        for (size_t i = 0; i < 4; i++) {
+            const uint64x2_t d   = vreinterpretq_u64_u8(vld1q_u8(data + i * 16));
+            const uint64x2_t key = veorq_u64(d, vld1q_u64(secret + i * 2));
+            uint64x2_t a         = vaddq_u64(vld1q_u64(acc + i * 2), vextq_u64(d, d, 1));
+            a                    = vmlal_u32(a, vmovn_u64(key), vshrn_n_u64(key, 32));
+            vst1q_u64(acc + i * 2, a);
+        }
+    }
+
+    void scramble(uint64_t* acc, const uint64_t* secret)
+    {
+        const uint32x2_t prime = vdup_n_u32(PRIME32_1);
+        for (size_t i = 0; i < 4; i++) {
+            uint64x2_t a = vld1q_u64(acc + i * 2);
+            a            = veorq_u64(a, vshrq_n_u64(a, 47));
+            a            = veorq_u64(a, vld1q_u64(secret + i * 2));
+            // 64x32 multiply split into two widening 32x32 ones
+            const uint64x2_t hi = vshlq_n_u64(vmull_u32(vshrn_n_u64(a, 32), prime), 32);
+            vst1q_u64(acc + i * 2, vmlal_u32(hi, vmovn_u64(a), prime));
+        }
+    }
+#else
+    void accumulate(uint64_t* acc, const uint8_t* data, const uint64_t* secret)
+    {
+        for (size_t i = 0; i < 8; i++) {
+            const uint64_t d   = readLE64(data + i * 8);
+            const uint64_t key = d ^ secret[i];
+            acc[i ^ 1] += d;
+            acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+        }
+    }
+
+    void scramble(uint64_t* acc, const uint64_t* secret)
+    {
+        for (size_t i = 0; i < 8; i++) {
+            uint64_t a = acc[i];
+            a ^= a >> 47;
+            a ^= secret[i];
+            acc[i] = a * PRIME32_1;
+        }
+    }
+#endif
+
+    inline uint64_t mul128fold64(uint64_t lhs, uint64_t rhs)
+    {
+#if defined(__SIZEOF_INT128__)
+        const unsigned __int128 product = (unsigned __int128)lhs * rhs;
+        return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+        const uint64_t lolo  = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+        const uint64_t hilo  = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+        const uint64_t lohi  = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+        const uint64_t hihi  = (lhs >> 32) * (rhs >> 32);
+        const uint64_t cross = (lolo >> 32) + (hilo & 0xFFFFFFFF) + lohi;
+        const uint64_t upper = (hilo >> 32) + (cross >> 32) + hihi;
+        const uint64_t lower = (cross << 32) | (lolo & 0xFFFFFFFF);
+        return lower ^ upper;
+#endif
+    }
+
+    inline uint64_t avalanche(uint64_t h)
+    {
+        h ^= h >> 37;
+        h *= 0x165667919E3779F9ULL;
+        h ^= h >> 32;
+        return h;
+    }
+}
+
+Hash::Sha256::Sha256(void)
+{
+    static const uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(mState, init, sizeof(mState));
+    mBufferLength = 0;
+    mLength       = 0;
+}
+
+void Hash::Sha256::update(const void* data, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    mLength += len;
+
+    if (mBufferLength > 0) {
+        size_t fill = std::min(len, sizeof(mBuffer) - mBufferLength);
+        memcpy(mBuffer + mBufferLength, p, fill);
+        mBufferLength += fill;
+        p += fill;
+        len -= fill;
+        if (mBufferLength < sizeof(mBuffer)) {
+            return;
+        }
+        sha256Blocks(mState, mBuffer, 1);
+        mBufferLength = 0;
+    }
+
+    // hash whole blocks straight from the source buffer
+    if (len >= 64) {
+        sha256Blocks(mState, p, len / 64);
+        p += len & ~(size_t)63;
+        len &= 63;
+    }
+
+    memcpy(mBuffer, p, len);
+    mBufferLength = len;
+}
+
+void Hash::Sha256::finish(uint8_t* hash)
+{
+    const uint64_t bits = mLength * 8;
+
+    mBuffer[mBufferLength++] = 0x80;
+    if (mBufferLength > 56) {
+        memset(mBuffer + mBufferLength, 0, sizeof(mBuffer) - mBufferLength);
+        sha256Blocks(mState, mBuffer, 1);
+        mBufferLength = 0;
+    }
+    memset(mBuffer + mBufferLength, 0, 56 - mBufferLength);
+    for (size_t i = 0; i < 8; i++) {
+        mBuffer[63 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    sha256Blocks(mState, mBuffer, 1);
+
+    for (size_t i = 0; i < 8; i++) {
+        hash[i * 4 + 0] = (uint8_t)(mState[i] >> 24);
+        hash[i * 4 + 1] = (uint8_t)(mState[i] >> 16);
+        hash[i * 4 + 2] = (uint8_t)(mState[i] >> 8);
+        hash[i * 4 + 3] = (uint8_t)mState[i];
+    }
+}
+
+Hash::Fast64::Fast64(uint64_t seed)
+{
+    static const uint64_t init[8] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+    memcpy(mAcc, init, sizeof(mAcc));
+    for (size_t i = 0; i < 8; i++) {
+        mSecret[i] = (i & 1) ? SECRET[i] - seed : SECRET[i] + seed;
+    }
+    mBufferLength = 0;
+    mStripes      = 0;
+    mLength       = 0;
+}
+
+void Hash::Fast64::update(const void* data, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    mLength += len;
+
+    while (len > 0) {
+        const uint8_t* stripe;
+        if (mBufferLength == 0 && len >= sizeof(mBuffer)) {
+            stripe = p;
+            p += sizeof(mBuffer);
+            len -= sizeof(mBuffer);
+        }
+        else {
+            size_t fill = std::min(len, sizeof(mBuffer) - mBufferLength);
+            memcpy(mBuffer + mBufferLength, p, fill);
+            mBufferLength += fill;
+            p += fill;
+            len -= fill;
+            if (mBufferLength < sizeof(mBuffer)) {
+                return;
+            }
+            stripe        = mBuffer;
+            mBufferLength = 0;
+        }
+
+        accumulate(mAcc, stripe, mSecret);
+        if (++mStripes == STRIPES_PER_BLOCK) {
+            scramble(mAcc, mSecret);
+            mStripes = 0;
+        }
+    }
+}
+
+uint64_t Hash::Fast64::finish(void) const
+{
+    uint64_t acc[8];
+    memcpy(acc, mAcc, sizeof(acc));
+
+    // the trailing partial stripe is zero padded, the length below disambiguates it
+    if (mBufferLength > 0) {
+        uint8_t last[64] = {0};
+        memcpy(last, mBuffer, mBufferLength);
+        accumulate(acc, last, mSecret);
+    }
+
+    uint64_t result = mLength * PRIME64_1;
+    for (size_t i = 0; i < 4; i++) {
+        result += mul128fold64(acc[i * 2] ^ mSecret[(i * 2 + 3) & 7], acc[i * 2 + 1] ^ mSecret[(i * 2 + 4) & 7]);
+    }
+    return avalanche(result);
+}
+
+void Hash::sha256(uint8_t* hash, const void* data, size_t len)
+{
+    Sha256 ctx;
+    ctx.update(data, len);
+    ctx.finish(hash);
+}
+
+uint64_t Hash::fast64(const void* data, size_t len, uint64_t seed)
+{
+    Fast64 ctx(seed);
+    ctx.update(data, len);
+    return ctx.finish();
+}
@@ -0,0 +1,73 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Hash {
+    inline constexpr size_t SHA256_SIZE = 32;
+
+    // incremental SHA-256, uses the ARMv8 crypto extensions when available
+    class Sha256 {
+    public:
+        Sha256(void);
+
+        void update(const void* data, size_t len);
+        void finish(uint8_t* hash);
+
+    private:
+        uint32_t mState[8];
+        uint8_t mBuffer[64];
+        size_t mBufferLength;
+        uint64_t mLength;
+    };
+
+    // incremental xxHash3-style 64 bit hash, meant for checksums and cache keys.
+    // it follows the same stripe layout as XXH3 but it is not bit compatible with it
+    class Fast64 {
+    public:
+        Fast64(uint64_t seed = 0);
+
+        void update(const void* data, size_t len);
+        uint64_t finish(void) const;
+
+    private:
+        uint64_t mAcc[8];
+        uint64_t mSecret[8];
+        uint8_t mBuffer[64];
+        size_t mBufferLength;
+        size_t mStripes;
+        uint64_t mLength;
+    };
+
+    void sha256(uint8_t* hash, const void* data, size_t len);
+    uint64_t fast64(const void* data, size_t len, uint64_t seed = 0);
+}
+
+#endif
@@ -59,7 +59,7 @@ public:
 
     std::string text(void) { return mText; }
 
-    void text(const std::string& v) { mText = v; }
+    virtual void text(const std::string& v) { mText = v; }
 
     bool selected(void) { return mSelected; }
 
@@ -0,0 +1,225 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#include "image.hpp"
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IMAGE_NEON 1
+#endif
+
+namespace {
+    template <typename T>
+    void tileImpl(T* dst, const T* src, size_t width, size_t height)
+    {
+        for (size_t y = 0; y < height; y += 8) {
+            for (size_t x = 0; x < width; x += 8, dst += 64) {
+                for (size_t i = 0; i < 64; i++) {
+                    dst[Image::TILE_SWIZZLE[i]] = src[(y + (i >> 3)) * width + x + (i & 7)];
+                }
+            }
+        }
+    }
+
+    template <typename T>
+    void untileImpl(T* dst, const T* src, size_t width, size_t height)
+    {
+        for (size_t y = 0; y < height; y += 8) {
+            for (size_t x = 0; x < width; x += 8, src += 64) {
+                for (size_t i = 0; i < 64; i++) {
+                    dst[(y + (i >> 3)) * width + x + (i & 7)] = src[Image::TILE_SWIZZLE[i]];
+                }
+            }
+        }
+    }
+}
+
+void Image::tile(uint16_t* dst, const uint16_t* src, size_t width, size_t height)
+{
+    tileImpl(dst, src, width, height);
+}
+
+void Image::tile(uint32_t* dst, const uint32_t* src, size_t width, size_t height)
+{
+    tileImpl(dst, src, width, height);
+}
+
+void Image::untile(uint16_t* dst, const uint16_t* src, size_t width, size_t height)
+{
+    untileImpl(dst, src, width, height);
+}
+
+void Image::untile(uint32_t* dst, const uint32_t* src, size_t width, size_t height)
+{
+    untileImpl(dst, src, width, height);
+}
+
+void Image::copyTiled(void* dst, size_t dstWidth, const void* src, size_t srcWidth, size_t height, size_t pixelSize)
+{
+    // a row of tiles is contiguous, so the copy only has to skip the unused tiles at the end of each destination row
+    uint8_t* out      = (uint8_t*)dst;
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t y = 0; y < height; y += 8) {
+        memcpy(out, in, srcWidth * 8 * pixelSize);
+        in += srcWidth * 8 * pixelSize;
+        out += dstWidth * 8 * pixelSize;
+    }
+}
+
+void Image::decodeDS(uint16_t* dst, const uint8_t* data, const uint16_t* palette)
+{
+    uint16_t colors[16];
+    colors[0] = 0xFFFF;
+    for (size_t i = 1; i < 16; i++) {
+        const uint16_t r = palette[i] & 0x1F;
+        const uint16_t g = (palette[i] >> 5) & 0x1F;
+        const uint16_t b = (palette[i] >> 10) & 0x1F;
+        colors[i]        = (r << 11) | (g << 6) | (g >> 4) | b;
+    }
+
+    // DS tiles store their pixels row by row and both formats lay their tiles out row by row, so a pixel never leaves
+    // its tile. The low nibble is the left pixel of each pair
+    for (size_t tile = 0; tile < 16; tile++, dst += 64) {
+        for (size_t i = 0; i < 64; i += 2, data++) {
+            dst[TILE_SWIZZLE[i]]     = colors[*data & 0xF];
+            dst[TILE_SWIZZLE[i + 1]] = colors[*data >> 4];
+        }
+    }
+}
+
+void Image::rgba8ToRgb565(uint16_t* dst, const uint8_t* src, size_t count)
+{
+    size_t i = 0;
+#if defined(IMAGE_NEON)
+    for (; i + 8 <= count; i += 8) {
+        // widen each channel into the top byte and shift-insert the next one below it
+        uint8x8x4_t px   = vld4_u8(src + i * 4);
+        uint16x8_t color = vshll_n_u8(px.val[0], 8);
+        color            = vsriq_n_u16(color, vshll_n_u8(px.val[1], 8), 5);
+        color            = vsriq_n_u16(color, vshll_n_u8(px.val[2], 8), 11);
+        vst1q_u16(dst + i, color);
+    }
+#endif
+    for (; i < count; i++) {
+        const uint8_t* px = src + i * 4;
+        dst[i]            = ((px[0] >> 3) << 11) | ((px[1] >> 2) << 5) | (px[2] >> 3);
+    }
+}
+
+void Image::rgb565ToRgba8(uint8_t* dst, const uint16_t* src, size_t count)
+{
+    size_t i = 0;
+#if defined(IMAGE_NEON)
+    for (; i + 8 <= count; i += 8) {
+        // move each channel to the top of a byte, then replicate its top bits into the low ones
+        uint16x8_t color = vld1q_u16(src + i);
+        uint8x8x4_t px;
+        px.val[0] = vshrn_n_u16(color, 8);
+        px.val[0] = vsri_n_u8(px.val[0], px.val[0], 5);
+        px.val[1] = vshrn_n_u16(color, 3);
+        px.val[1] = vsri_n_u8(px.val[1], px.val[1], 6);
+        px.val[2] = vmovn_u16(vshlq_n_u16(color, 3));
+        px.val[2] = vsri_n_u8(px.val[2], px.val[2], 5);
+        px.val[3] = vdup_n_u8(0xFF);
+        vst4_u8(dst + i * 4, px);
+    }
+#endif
+    for (; i < count; i++) {
+        const uint8_t r = (src[i] >> 11) & 0x1F;
+        const uint8_t g = (src[i] >> 5) & 0x3F;
+        const uint8_t b = src[i] & 0x1F;
+        uint8_t* px     = dst + i * 4;
+        px[0]           = (r << 3) | (r >> 2);
+        px[1]           = (g << 2) | (g >> 4);
+        px[2]           = (b << 3) | (b >> 2);
+        px[3]           = 0xFF;
+    }
+}
+
+void Image::colorKey(uint8_t* pixels, size_t count, uint8_t r, uint8_t g, uint8_t b)
+{
+    size_t i = 0;
+#if defined(IMAGE_NEON)
+    const uint32x4_t key   = vdupq_n_u32(r | (g << 8) | (b << 16));
+    const uint32x4_t rgb   = vdupq_n_u32(0x00FFFFFF);
+    const uint32x4_t alpha = vdupq_n_u32(0xFF000000);
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t px    = vreinterpretq_u32_u8(vld1q_u8(pixels + i * 4));
+        uint32x4_t match = vceqq_u32(vandq_u32(px, rgb), key);
+        px               = vbicq_u32(px, vandq_u32(match, alpha));
+        vst1q_u8(pixels + i * 4, vreinterpretq_u8_u32(px));
+    }
+#endif
+    for (; i < count; i++) {
+        uint8_t* px = pixels + i * 4;
+        if (px[0] == r && px[1] == g && px[2] == b) {
+            px[3] = 0;
+        }
+    }
+}
+
+void Image::downscale(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, size_t srcWidth, size_t srcHeight, size_t factor)
+{
+    const size_t width  = srcWidth / factor;
+    const size_t height = srcHeight / factor;
+    const uint32_t area = factor * factor;
+    for (size_t y = 0; y < height; y++, dst += dstPitch, src += srcPitch * factor) {
+        size_t x = 0;
+#if defined(IMAGE_NEON)
+        if (factor == 2) {
+            const uint8_t* row0 = src;
+            const uint8_t* row1 = src + srcPitch;
+            for (; x + 4 <= width; x += 4) {
+                // split 8 source pixels of both rows into even and odd columns, then add them up per channel
+                uint32x4x2_t top    = vld2q_u32((const uint32_t*)(row0 + x * 8));
+                uint32x4x2_t bottom = vld2q_u32((const uint32_t*)(row1 + x * 8));
+                uint8x16_t te       = vreinterpretq_u8_u32(top.val[0]);
+                uint8x16_t to       = vreinterpretq_u8_u32(top.val[1]);
+                uint8x16_t be       = vreinterpretq_u8_u32(bottom.val[0]);
+                uint8x16_t bo       = vreinterpretq_u8_u32(bottom.val[1]);
+                uint16x8_t low      = vaddq_u16(vaddl_u8(vget_low_u8(te), vget_low_u8(to)), vaddl_u8(vget_low_u8(be), vget_low_u8(bo)));
+                uint16x8_t high     = vaddq_u16(vaddl_u8(vget_high_u8(te), vget_high_u8(to)), vaddl_u8(vget_high_u8(be), vget_high_u8(bo)));
+                vst1q_u8(dst + x * 4, vcombine_u8(vrshrn_n_u16(low, 2), vrshrn_n_u16(high, 2)));
+            }
+        }
+#endif
+        for (; x < width; x++) {
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (size_t j = 0; j < factor; j++) {
+                const uint8_t* px = src + j * srcPitch + x * factor * 4;
+                for (size_t k = 0; k < factor * 4; k += 4) {
+                    sum[0] += px[k];
+                    sum[1] += px[k + 1];
+                    sum[2] += px[k + 2];
+                    sum[3] += px[k + 3];
+                }
+            }
+            for (size_t c = 0; c < 4; c++) {
+                dst[x * 4 + c] = (sum[c] + area / 2) / area;
+            }
+        }
+    }
+}
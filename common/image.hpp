@@ -0,0 +1,74 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+// pixel format helpers shared by the icon loaders. RGBA8 pixels are stored as R, G, B, A bytes in memory, RGB565 pixels
+// as native 16 bit words with red in the top bits. Tiled images are made of 8x8 tiles laid out row by row, with the
+// pixels of each tile in Morton order, as the 3DS GPU expects them
+namespace Image {
+    constexpr std::array<uint8_t, 64> makeTileSwizzle(void)
+    {
+        std::array<uint8_t, 64> swizzle{};
+        for (uint32_t i = 0; i < 64; i++) {
+            const uint32_t x = i & 7;
+            const uint32_t y = i >> 3;
+            swizzle[i]       = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+        }
+        return swizzle;
+    }
+
+    // offset inside a tile of the pixel at (i & 7, i >> 3)
+    inline constexpr std::array<uint8_t, 64> TILE_SWIZZLE = makeTileSwizzle();
+
+    // width and height have to be multiples of 8
+    void tile(uint16_t* dst, const uint16_t* src, size_t width, size_t height);
+    void tile(uint32_t* dst, const uint32_t* src, size_t width, size_t height);
+    void untile(uint16_t* dst, const uint16_t* src, size_t width, size_t height);
+    void untile(uint32_t* dst, const uint32_t* src, size_t width, size_t height);
+    // copies a tiled image into the top left corner of a wider tiled image, src does not need to be aligned
+    void copyTiled(void* dst, size_t dstWidth, const void* src, size_t srcWidth, size_t height, size_t pixelSize);
+
+    // decodes a 4bpp DS banner icon, 32x32 pixels in 16 tiles of 32 bytes with a BGR555 palette, into a tiled RGB565
+    // 32x32 image. Palette index 0 is transparent and becomes white
+    void decodeDS(uint16_t* dst, const uint8_t* data, const uint16_t* palette);
+
+    void rgba8ToRgb565(uint16_t* dst, const uint8_t* src, size_t count);
+    void rgb565ToRgba8(uint8_t* dst, const uint16_t* src, size_t count);
+
+    // makes the pixels whose color matches r, g, b fully transparent
+    void colorKey(uint8_t* pixels, size_t count, uint8_t r, uint8_t g, uint8_t b);
+
+    // averages factor x factor blocks of an RGBA8 image, the pitches are in bytes. Rows and columns that do not fill a
+    // whole block are dropped
+    void downscale(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, size_t srcWidth, size_t srcHeight, size_t factor);
+}
+
+#endif
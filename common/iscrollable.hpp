@@ -30,34 +30,51 @@
 #include "iclickable.hpp"
 #include <vector>
 
+// Rows hold the data of every entry, while cells are only created for the rows of one page and are kept between
+// pages and rebuilds. A cell is rebound to its row when the page or the row changes, not on every frame
 template <typename T>
 class IScrollable {
 public:
     IScrollable(int x, int y, u16 w, u16 h, size_t visibleEntries) : mx(x), my(y), mw(w), mh(h), mVisibleEntries(visibleEntries)
     {
-        mIndex = 0;
-        mPage  = 0;
+        mIndex     = 0;
+        mPage      = 0;
+        mBoundPage = -1;
     }
 
-    virtual ~IScrollable(void) { flush(); }
+    virtual ~IScrollable(void)
+    {
+        for (size_t i = 0; i < mCells.size(); i++) {
+            delete mCells[i];
+        }
+    }
 
-    virtual void draw(bool condition = false)                                                  = 0;
-    virtual void push_back(T color, T colorMessage, const std::string& message, bool selected) = 0;
-    virtual void updateSelection(void)                                                         = 0;
+    virtual void draw(bool condition = false) = 0;
+    virtual void updateSelection(void)        = 0;
 
-    std::string cellName(size_t index) const { return mCells.at(index)->text(); }
+    void push_back(T color, T colorMessage, const std::string& message, bool selected)
+    {
+        mRows.push_back({message, color, colorMessage, selected});
+        mBoundPage = -1;
+    }
 
-    void cellName(size_t index, const std::string& name) { mCells.at(index)->text(name); }
+    std::string cellName(size_t index) const { return mRows.at(index).text; }
 
-    void flush(void)
+    void cellName(size_t index, const std::string& name)
     {
-        for (size_t i = 0; i < size(); i++) {
-            delete mCells[i];
+        mRows.at(index).text = name;
+        if (bound(index)) {
+            mCells[index % mVisibleEntries]->text(name);
         }
-        mCells.clear();
     }
 
-    size_t size(void) const { return mCells.size(); }
+    void flush(void)
+    {
+        mRows.clear();
+        mBoundPage = -1;
+    }
+
+    size_t size(void) const { return mRows.size(); }
 
     size_t maxVisibleEntries(void)
     {
@@ -82,9 +99,47 @@ public:
 
     size_t visibleEntries(void) { return mVisibleEntries; }
 
-    void selectRow(size_t i, bool selected) { mCells.at(i)->selected(selected); }
+    void selectRow(size_t i, bool selected)
+    {
+        mRows.at(i).selected = selected;
+        if (bound(i)) {
+            mCells[i % mVisibleEntries]->selected(selected);
+        }
+    }
 
 protected:
+    struct Row {
+        std::string text;
+        T color;
+        T colorMessage;
+        bool selected;
+    };
+
+    // creates the cell shown in the visible row i
+    virtual IClickable<T>* newCell(size_t i) = 0;
+
+    bool bound(size_t index) const { return mBoundPage >= 0 && index / mVisibleEntries == (size_t)mBoundPage; }
+
+    // binds the rows of the current page to the cells, returns how many of them are visible
+    size_t bind(void)
+    {
+        const size_t baseIndex = mPage * mVisibleEntries;
+        const size_t sz        = baseIndex >= size() ? 0 : size() - baseIndex > mVisibleEntries ? mVisibleEntries : size() - baseIndex;
+        if (mBoundPage != mPage) {
+            for (size_t i = 0; i < sz; i++) {
+                if (i == mCells.size()) {
+                    mCells.push_back(newCell(i));
+                }
+                const Row& row = mRows[baseIndex + i];
+                mCells[i]->setColors(row.color, row.colorMessage);
+                mCells[i]->text(row.text);
+                mCells[i]->selected(row.selected);
+            }
+            mBoundPage = mPage;
+        }
+        return sz;
+    }
+
     int mx;
     int my;
     u16 mw;
@@ -92,6 +147,8 @@ protected:
     size_t mVisibleEntries;
     size_t mIndex;
     int mPage;
+    int mBoundPage;
+    std::vector<Row> mRows;
     std::vector<IClickable<T>*> mCells;
 };
 
@@ -0,0 +1,178 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "logger.hpp"
+#if defined(_3DS)
+#include <3ds.h>
+#elif defined(__SWITCH__)
+#include <switch.h>
+#endif
+
+// how long the flusher sleeps between drains, the queue holds SLOT_COUNT lines in the meantime
+static const int64_t FLUSH_INTERVAL_NS = 100 * 1000 * 1000;
+
+static void sleepInterval(void)
+{
+#if defined(_3DS) || defined(__SWITCH__)
+    svcSleepThread(FLUSH_INTERVAL_NS);
+#else
+    usleep(FLUSH_INTERVAL_NS / 1000);
+#endif
+}
+
+Logger::Logger(void) : mFile(NULL), mEnqueue(0), mDequeue(0), mDropped(0), mRunning(true), mBlockSize(0)
+{
+    mDraining.clear();
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        mSlots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+size_t Logger::prefix(char* dst, const std::string& level)
+{
+    // formatting the date is the expensive part, redo it only when the second changes
+    thread_local time_t cachedTime = -1;
+    thread_local char cachedDate[24];
+    time_t now = time(NULL);
+    if (now != cachedTime) {
+        struct tm timeStruct;
+        localtime_r(&now, &timeStruct);
+        strftime(cachedDate, sizeof(cachedDate), "[%Y-%m-%d %H:%M:%S] ", &timeStruct);
+        cachedTime = now;
+    }
+
+    size_t len = strlen(cachedDate);
+    memcpy(dst, cachedDate, len);
+    len += level.copy(dst + len, LINE_SIZE / 2);
+    dst[len++] = ' ';
+    return len;
+}
+
+void Logger::push(const char* line, size_t length)
+{
+    // bounded multi-producer queue, a producer claims a slot by advancing mEnqueue while the slot is free
+    uint32_t pos = mEnqueue.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot         = &mSlots[pos % SLOT_COUNT];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (mEnqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else {
+            pos = mEnqueue.load(std::memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot->data, line, length);
+    slot->length = length;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void Logger::write(const char* data, size_t length)
+{
+    if (mBlockSize + length > BLOCK_SIZE) {
+        if (mFile != NULL) {
+            fwrite(mBlock, 1, mBlockSize, mFile);
+        }
+        fwrite(mBlock, 1, mBlockSize, stderr);
+        mBlockSize = 0;
+    }
+    memcpy(mBlock + mBlockSize, data, length);
+    mBlockSize += length;
+}
+
+void Logger::drain(void)
+{
+    // there is a single consumer at a time, flush() and late log() calls may race the flusher thread
+    while (mDraining.test_and_set(std::memory_order_acquire)) {
+        sleepInterval();
+    }
+
+    // the file is closed after the last drain of flush(), later drains reopen it to append
+    if (mFile == NULL) {
+        mFile = fopen(mPath.c_str(), "a");
+    }
+
+    while (true) {
+        Slot* slot   = &mSlots[mDequeue % SLOT_COUNT];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        if (seq != mDequeue + 1) {
+            break;
+        }
+        write(slot->data, slot->length);
+        slot->sequence.store(mDequeue + SLOT_COUNT, std::memory_order_release);
+        mDequeue++;
+    }
+
+    uint32_t dropped = mDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        char line[LINE_SIZE];
+        size_t len = prefix(line, WARN);
+        len += snprintf(line + len, LINE_SIZE - len, "%u log lines dropped, the log queue was full.\n", (unsigned)dropped);
+        write(line, std::min(len, LINE_SIZE));
+    }
+
+    if (mBlockSize > 0) {
+        if (mFile != NULL) {
+            fwrite(mBlock, 1, mBlockSize, mFile);
+            fflush(mFile);
+        }
+        fwrite(mBlock, 1, mBlockSize, stderr);
+        mBlockSize = 0;
+    }
+
+    if (!mRunning.load(std::memory_order_relaxed) && mFile != NULL) {
+        fclose(mFile);
+        mFile = NULL;
+    }
+
+    mDraining.clear(std::memory_order_release);
+}
+
+void Logger::run(void)
+{
+    while (mRunning) {
+        drain();
+        sleepInterval();
+    }
+}
+
+void Logger::flush(void)
+{
+    // pairs with the fence in log(): a line pushed before a caller saw mRunning set is drained here,
+    // anything later is drained by the caller
+    mRunning.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    drain();
+}
@@ -28,9 +28,13 @@
 #define LOGGER_HPP
 
 #include "common.hpp"
+#include <atomic>
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
 
+// log lines are formatted by the caller into a bounded lock-free queue and written out in blocks by a flusher thread.
+// when the queue is full lines are dropped and counted instead of blocking the caller
 class Logger {
 public:
     static Logger& getInstance(void)
@@ -47,26 +51,49 @@ public:
     template <typename... Args>
     void log(const std::string& level, const std::string& format = {}, Args... args)
     {
-        buffer += StringUtils::format(("[" + DateTime::logDateTime() + "] " + level + " " + format + "\n").c_str(), args...);
-    }
+        char line[LINE_SIZE];
+        size_t len = prefix(line, level);
+        // always formatted, so "%%" collapses the same way with or without arguments
+        int n       = snprintf(line + len, LINE_SIZE - 1 - len, format.c_str(), args...);
+        len         = n < 0 ? len : std::min(len + n, LINE_SIZE - 2);
+        line[len++] = '\n';
+        push(line, len);
 
-    void flush(void)
-    {
-        mFile = fopen(mPath.c_str(), "a");
-        if (mFile != NULL) {
-            fprintf(mFile, buffer.c_str());
-            fprintf(stderr, buffer.c_str());
-            fclose(mFile);
+        // lines logged after flush() have no flusher left to write them out
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!mRunning.load(std::memory_order_relaxed)) {
+            drain();
         }
     }
 
+    // body of the flusher thread, returns once flush() has been called
+    void run(void);
+    // writes out everything queued so far and closes the log, called once at exit.
+    // anything logged afterwards is appended to the log by the caller itself
+    void flush(void);
+
 private:
-    Logger(void) { buffer = ""; }
+    Logger(void);
     ~Logger(void) {}
 
     Logger(Logger const&) = delete;
     void operator=(Logger const&) = delete;
 
+    static constexpr size_t LINE_SIZE  = 256;
+    static constexpr size_t SLOT_COUNT = 256;
+    static constexpr size_t BLOCK_SIZE = 0x4000;
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        uint32_t length;
+        char data[LINE_SIZE];
+    };
+
+    size_t prefix(char* dst, const std::string& level);
+    void push(const char* line, size_t length);
+    void drain(void);
+    void write(const char* data, size_t length);
+
 #if defined(_3DS)
     const std::string mPath = "sdmc:/3ds/Checkpoint/checkpoint.log";
 #elif defined(__SWITCH__)
@@ -77,7 +104,14 @@ private:
 
     FILE* mFile;
 
-    std::string buffer;
+    Slot mSlots[SLOT_COUNT];
+    std::atomic<uint32_t> mEnqueue;
+    uint32_t mDequeue;
+    std::atomic<uint32_t> mDropped;
+    std::atomic_flag mDraining;
+    std::atomic<bool> mRunning;
+    char mBlock[BLOCK_SIZE];
+    size_t mBlockSize;
 };
 
-#endif
\ No newline at end of file
+#endif
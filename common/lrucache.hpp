@@ -0,0 +1,111 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef LRUCACHE_HPP
+#define LRUCACHE_HPP
+
+#include <functional>
+#include <list>
+#include <stddef.h>
+#include <unordered_map>
+#include <utility>
+
+// least recently used cache with a cost budget. Every entry has a cost, 1 by default, and inserting evicts from the least
+// recently used end until the new entry fits. The evict callback releases whatever the value owns
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    LruCache(size_t capacity, std::function<void(Value&)> evict = nullptr) : mCapacity(capacity), mUsed(0), mEvict(evict) {}
+    ~LruCache(void) { clear(); }
+
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    // returns nullptr on a miss. The pointer stays valid until the entry is evicted
+    Value* find(const Key& key)
+    {
+        auto got = mIndex.find(key);
+        if (got == mIndex.end()) {
+            return nullptr;
+        }
+        mEntries.splice(mEntries.begin(), mEntries, got->second);
+        return &got->second->value;
+    }
+
+    Value* insert(const Key& key, Value value, size_t cost = 1)
+    {
+        erase(key);
+        while (!mEntries.empty() && mUsed + cost > mCapacity) {
+            evict(std::prev(mEntries.end()));
+        }
+        mEntries.push_front({key, std::move(value), cost});
+        mIndex.emplace(key, mEntries.begin());
+        mUsed += cost;
+        return &mEntries.front().value;
+    }
+
+    void erase(const Key& key)
+    {
+        auto got = mIndex.find(key);
+        if (got != mIndex.end()) {
+            evict(got->second);
+        }
+    }
+
+    void clear(void)
+    {
+        while (!mEntries.empty()) {
+            evict(mEntries.begin());
+        }
+    }
+
+    size_t size(void) const { return mEntries.size(); }
+    size_t used(void) const { return mUsed; }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t cost;
+    };
+
+    void evict(typename std::list<Entry>::iterator entry)
+    {
+        if (mEvict) {
+            mEvict(entry->value);
+        }
+        mUsed -= entry->cost;
+        mIndex.erase(entry->key);
+        mEntries.erase(entry);
+    }
+
+    std::list<Entry> mEntries;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> mIndex;
+    size_t mCapacity;
+    size_t mUsed;
+    std::function<void(Value&)> mEvict;
+};
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// read only view of a contiguous range owned by someone else
+template <typename T>
+class Span {
+public:
+    Span(void) : mData(nullptr), mSize(0) {}
+    Span(const T* data, size_t size) : mData(data), mSize(size) {}
+
+    const T* begin(void) const { return mData; }
+    const T* end(void) const { return mData + mSize; }
+    size_t size(void) const { return mSize; }
+    bool empty(void) const { return mSize == 0; }
+    const T& operator[](size_t i) const { return mData[i]; }
+
+private:
+    const T* mData;
+    size_t mSize;
+};
+
+// set of title ids kept as a sorted array, lookups are a binary search
+class IdSet {
+public:
+    IdSet(void) {}
+    IdSet(std::vector<uint64_t> ids) : mIds(std::move(ids))
+    {
+        std::sort(mIds.begin(), mIds.end());
+        mIds.erase(std::unique(mIds.begin(), mIds.end()), mIds.end());
+    }
+
+    bool contains(uint64_t id) const { return std::binary_search(mIds.begin(), mIds.end(), id); }
+    size_t size(void) const { return mIds.size(); }
+
+private:
+    std::vector<uint64_t> mIds;
+};
+
+// title id to folder list map, the folders of every title are stored back to back in a single array
+template <typename String>
+class FolderTable {
+public:
+    FolderTable(void) {}
+    FolderTable(std::vector<std::pair<uint64_t, std::vector<String>>> entries)
+    {
+        // a title listed twice keeps its first entry, as emplace into the old maps did
+        std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        mOffsets.push_back(0);
+        for (auto& entry : entries) {
+            if (!mIds.empty() && mIds.back() == entry.first) {
+                continue;
+            }
+            mIds.push_back(entry.first);
+            for (auto& folder : entry.second) {
+                mFolders.push_back(std::move(folder));
+            }
+            mOffsets.push_back(mFolders.size());
+        }
+    }
+
+    Span<String> find(uint64_t id) const
+    {
+        auto it = std::lower_bound(mIds.begin(), mIds.end(), id);
+        if (it == mIds.end() || *it != id) {
+            return Span<String>();
+        }
+        const size_t i = it - mIds.begin();
+        return Span<String>(mFolders.data() + mOffsets[i], mOffsets[i + 1] - mOffsets[i]);
+    }
+
+private:
+    std::vector<uint64_t> mIds;
+    std::vector<size_t> mOffsets;
+    std::vector<String> mFolders;
+};
+
+// holds the current version of an immutable value. Readers get it with a single atomic load, without locking or
+// allocating. Replaced versions are retired instead of freed, so anything a reader got out of one stays valid for the
+// lifetime of the holder; they are only as many as the times the value was replaced.
+// publish is meant to be called by one thread at a time
+template <typename T>
+class SnapshotHolder {
+public:
+    SnapshotHolder(void) : mCurrent(nullptr) {}
+
+    SnapshotHolder(const SnapshotHolder&) = delete;
+    SnapshotHolder& operator=(const SnapshotHolder&) = delete;
+
+    const T& get(void) const { return *mCurrent.load(std::memory_order_acquire); }
+
+    void publish(std::unique_ptr<const T> value)
+    {
+        mCurrent.store(value.get(), std::memory_order_release);
+        mVersions.push_back(std::move(value));
+    }
+
+private:
+    std::atomic<const T*> mCurrent;
+    std::vector<std::unique_ptr<const T>> mVersions;
+};
+
+#endif
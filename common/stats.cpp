@@ -0,0 +1,153 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "stats.hpp"
+#include <atomic>
+#include <malloc.h>
+#if defined(_3DS)
+#include <3ds.h>
+#include <citro3d.h>
+#elif defined(__SWITCH__)
+#include <switch.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+    std::atomic<uint64_t> ioBytes{0};
+    std::atomic<uint32_t> ioFiles{0};
+    std::atomic<int> jobs{0};
+
+    // only touched by the render thread
+    Stats::Sample current;
+    uint32_t drawCalls      = 0;
+    uint64_t lastFrame      = 0;
+    uint64_t windowStart    = 0;
+    uint64_t windowMaxFrame = 0;
+    uint32_t windowFrames   = 0;
+    uint64_t windowBytes    = 0;
+    uint32_t windowFiles    = 0;
+
+    // timestamps stay in raw ticks, converting absolute tick counts to nanoseconds overflows on the 3DS after ~69 s
+    uint64_t nowTicks(void)
+    {
+#if defined(_3DS)
+        return svcGetSystemTick();
+#elif defined(__SWITCH__)
+        return armGetSystemTick();
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+    }
+
+    // only called with differences, which stay small
+    uint64_t toNs(uint64_t ticks)
+    {
+#if defined(_3DS)
+        return ticks * 1000000000ULL / SYSCLOCK_ARM11;
+#elif defined(__SWITCH__)
+        return armTicksToNs(ticks);
+#else
+        return ticks;
+#endif
+    }
+}
+
+void Stats::drawCall(void)
+{
+    drawCalls++;
+}
+
+void Stats::frameEnd(void)
+{
+    uint64_t now = nowTicks();
+    if (lastFrame == 0) {
+        lastFrame   = now;
+        windowStart = now;
+    }
+    uint64_t frame = toNs(now - lastFrame);
+    lastFrame      = now;
+    windowMaxFrame = frame > windowMaxFrame ? frame : windowMaxFrame;
+    windowFrames++;
+
+    current.drawCalls = drawCalls;
+    drawCalls         = 0;
+#if defined(_3DS)
+    current.gpuUsage = C3D_GetCmdBufUsage();
+    current.gpuTime  = C3D_GetDrawingTime();
+#endif
+
+    uint64_t window = toNs(now - windowStart);
+    if (window < 1000000000ULL) {
+        return;
+    }
+
+    uint64_t bytes = ioBytes.load(std::memory_order_relaxed);
+    uint32_t files = ioFiles.load(std::memory_order_relaxed);
+    float seconds  = window / 1e9f;
+    // mallinfo walks the allocator bins, which is why it is only called once per window
+    struct mallinfo info = mallinfo();
+
+    current.frameTime    = window / 1e6f / windowFrames;
+    current.maxFrameTime = windowMaxFrame / 1e6f;
+    current.heapUsed     = info.uordblks;
+    current.ioRate       = (bytes - windowBytes) / (1024.0f * 1024.0f) / seconds;
+    current.fileRate     = (files - windowFiles) / seconds;
+    current.jobs         = jobs.load(std::memory_order_relaxed);
+
+    windowStart    = now;
+    windowMaxFrame = 0;
+    windowFrames   = 0;
+    windowBytes    = bytes;
+    windowFiles    = files;
+}
+
+const Stats::Sample& Stats::sample(void)
+{
+    return current;
+}
+
+void Stats::io(size_t bytes)
+{
+    ioBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Stats::fileDone(void)
+{
+    ioFiles.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::jobQueued(void)
+{
+    jobs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::jobDone(void)
+{
+    jobs.fetch_sub(1, std::memory_order_relaxed);
+}
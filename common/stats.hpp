@@ -0,0 +1,59 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+// cheap counters fed by the renderer and the io layer, sampled once per second for the performance hud
+namespace Stats {
+    struct Sample {
+        float frameTime;    // average over the last second, in ms
+        float maxFrameTime; // worst frame of the last second, in ms
+        uint32_t drawCalls; // last frame, sdl only
+        float gpuUsage;     // command buffer usage of the last frame, citro3d only
+        float gpuTime;      // gpu drawing time of the last frame in ms, citro3d only
+        size_t heapUsed;
+        float ioRate;   // MB/s
+        float fileRate; // files/s
+        int jobs;
+    };
+
+    // render thread
+    void drawCall(void);
+    void frameEnd(void);
+    const Sample& sample(void);
+
+    // any thread
+    void io(size_t bytes);
+    void fileDone(void);
+    void jobQueued(void);
+    void jobDone(void);
+}
+
+#endif
@@ -0,0 +1,524 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "tar.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace {
+    const size_t BLOCK_SIZE     = 512;
+    const size_t MAX_META_SIZE  = 0x10000;
+    const char LONG_NAME_PATH[] = "././@LongLink";
+
+    size_t padding(uint64_t size)
+    {
+        return (BLOCK_SIZE - size % BLOCK_SIZE) % BLOCK_SIZE;
+    }
+
+    void putOctal(uint8_t* dst, size_t width, uint64_t value)
+    {
+        // values that do not fit the octal field use the base-256 extension
+        if (width < 12 ? value >= (1ULL << (3 * (width - 1))) : value >= (1ULL << 33)) {
+            dst[0] = 0x80;
+            for (size_t i = width - 1; i > 0; i--, value >>= 8) {
+                dst[i] = value & 0xFF;
+            }
+            return;
+        }
+        // zero padded octal digits and a terminating nul
+        dst[width - 1] = 0;
+        for (size_t i = width - 1; i > 0; i--, value >>= 3) {
+            dst[i - 1] = '0' + (value & 7);
+        }
+    }
+
+    uint64_t getNumber(const uint8_t* src, size_t width)
+    {
+        uint64_t value = 0;
+        if (src[0] & 0x80) {
+            for (size_t i = 1; i < width; i++) {
+                value = (value << 8) | src[i];
+            }
+            return value;
+        }
+        for (size_t i = 0; i < width && src[i] != 0 && src[i] != ' '; i++) {
+            if (src[i] >= '0' && src[i] <= '7') {
+                value = (value << 3) | (src[i] - '0');
+            }
+        }
+        return value;
+    }
+
+    std::string getString(const uint8_t* src, size_t width)
+    {
+        return std::string((const char*)src, strnlen((const char*)src, width));
+    }
+
+    // pax extended headers are "<length> <key>=<value>\n" records, only the path is used
+    std::string paxPath(const std::string& data)
+    {
+        std::string path;
+        for (size_t pos = 0; pos < data.size();) {
+            size_t space = data.find(' ', pos);
+            size_t len   = strtoul(data.c_str() + pos, NULL, 10);
+            if (space == std::string::npos || len == 0 || pos + len > data.size()) {
+                break;
+            }
+            std::string record = data.substr(space + 1, pos + len - space - 2);
+            if (record.compare(0, 5, "path=") == 0) {
+                path = record.substr(5);
+            }
+            pos += len;
+        }
+        return path;
+    }
+
+    std::vector<std::string> children(const std::string& path)
+    {
+        std::vector<std::string> children;
+        DIR* dir = opendir(path.c_str());
+        if (dir != NULL) {
+            struct dirent* ent;
+            while ((ent = readdir(dir)) != NULL) {
+                if (strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0) {
+                    children.push_back(ent->d_name);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(children.begin(), children.end());
+        return children;
+    }
+
+    void removeTree(const std::string& path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            for (auto& child : children(path)) {
+                removeTree(path + "/" + child);
+            }
+            rmdir(path.c_str());
+        }
+        else {
+            remove(path.c_str());
+        }
+    }
+
+    // paths of the entries depth levels below root + rel, relative to root. Files found on the way count as entries
+    void listEntries(const std::string& root, const std::string& rel, size_t depth, std::vector<std::string>& entries)
+    {
+        for (auto& child : children(root + rel)) {
+            const std::string path = rel + "/" + child;
+            struct stat st;
+            if (depth > 1 && stat((root + path).c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                listEntries(root, path, depth - 1, entries);
+            }
+            else {
+                entries.push_back(path);
+            }
+        }
+    }
+
+    uint32_t checksum(const uint8_t* block)
+    {
+        // the checksum field itself counts as spaces
+        uint32_t sum = 0;
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            sum += i >= 148 && i < 156 ? ' ' : block[i];
+        }
+        return sum;
+    }
+}
+
+Tar::Writer::Writer(void) : mHeaderPos(0), mFile(NULL), mRemaining(0), mPadding(0), mEnded(false) {}
+
+Tar::Writer::~Writer(void)
+{
+    if (mFile != NULL) {
+        fclose(mFile);
+    }
+}
+
+void Tar::Writer::add(const std::string& name, const std::string& path)
+{
+    // entries are popped from the back
+    mPending.insert(mPending.begin(), {name, path});
+}
+
+void Tar::Writer::header(const std::string& name, char type, uint64_t size, uint32_t mode, time_t mtime)
+{
+    std::string stored = name;
+    std::string prefix;
+    mHeader.clear();
+    mHeaderPos = 0;
+
+    if (name.size() > 100) {
+        // prefer the ustar prefix field, fall back to a gnu long name entry
+        size_t split = name.find('/', name.size() - 101);
+        if (split != std::string::npos && split > 0 && split <= 155) {
+            prefix = name.substr(0, split);
+            stored = name.substr(split + 1);
+        }
+        else {
+            header(LONG_NAME_PATH, 'L', name.size() + 1, 0644, 0);
+            std::vector<uint8_t> longName = std::move(mHeader);
+            longName.insert(longName.end(), name.begin(), name.end());
+            longName.resize(longName.size() + 1 + padding(name.size() + 1), 0);
+            header(name.substr(0, 100), type, size, mode, mtime);
+            mHeader.insert(mHeader.begin(), longName.begin(), longName.end());
+            return;
+        }
+    }
+
+    mHeader.resize(BLOCK_SIZE, 0);
+    uint8_t* block = mHeader.data();
+    memcpy(block, stored.data(), stored.size());
+    putOctal(block + 100, 8, mode);
+    putOctal(block + 108, 8, 0);
+    putOctal(block + 116, 8, 0);
+    putOctal(block + 124, 12, size);
+    putOctal(block + 136, 12, mtime > 0 ? mtime : 0);
+    block[156] = type;
+    memcpy(block + 257, "ustar", 6);
+    memcpy(block + 263, "00", 2);
+    memcpy(block + 345, prefix.data(), prefix.size());
+    snprintf((char*)block + 148, 8, "%06o", checksum(block));
+    block[155] = ' ';
+}
+
+bool Tar::Writer::next(void)
+{
+    while (!mPending.empty()) {
+        Entry entry = std::move(mPending.back());
+        mPending.pop_back();
+
+        struct stat st;
+        if (stat(entry.path.c_str(), &st) != 0) {
+            Logger::getInstance().log(Logger::WARN, "Skipping %s in archive with errno %d.", entry.path.c_str(), errno);
+            continue;
+        }
+
+        if (S_ISDIR(st.st_mode)) {
+            // reverse order, so the stack yields them alphabetically
+            std::vector<std::string> names = children(entry.path);
+            for (auto it = names.rbegin(); it != names.rend(); ++it) {
+                mPending.push_back({entry.name + "/" + *it, entry.path + "/" + *it});
+            }
+            header(entry.name + "/", '5', 0, 0755, st.st_mtime);
+            return true;
+        }
+        else if (S_ISREG(st.st_mode)) {
+            mFile = fopen(entry.path.c_str(), "rb");
+            if (mFile == NULL) {
+                Logger::getInstance().log(Logger::WARN, "Skipping %s in archive with errno %d.", entry.path.c_str(), errno);
+                continue;
+            }
+            mRemaining = st.st_size;
+            mPadding   = padding(st.st_size);
+            header(entry.name, '0', st.st_size, 0644, st.st_mtime);
+            if (mRemaining == 0) {
+                fclose(mFile);
+                mFile = NULL;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Tar::Writer::read(uint8_t* dst, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        if (mHeaderPos < mHeader.size()) {
+            size_t n = std::min(size - done, mHeader.size() - mHeaderPos);
+            memcpy(dst + done, mHeader.data() + mHeaderPos, n);
+            mHeaderPos += n;
+            done += n;
+        }
+        else if (mRemaining > 0) {
+            size_t n = std::min<uint64_t>(size - done, mRemaining);
+            size_t r = mFile != NULL ? fread(dst + done, 1, n, mFile) : 0;
+            if (r < n) {
+                // the file shrank since it was stat'ed, zero fill to keep the archive consistent
+                memset(dst + done + r, 0, n - r);
+                if (mFile != NULL) {
+                    fclose(mFile);
+                    mFile = NULL;
+                }
+            }
+            mRemaining -= n;
+            done += n;
+            if (mRemaining == 0 && mFile != NULL) {
+                fclose(mFile);
+                mFile = NULL;
+            }
+        }
+        else if (mPadding > 0) {
+            size_t n = std::min(size - done, mPadding);
+            memset(dst + done, 0, n);
+            mPadding -= n;
+            done += n;
+        }
+        else if (!next()) {
+            if (mEnded) {
+                break;
+            }
+            // two zero blocks terminate the archive
+            mEnded   = true;
+            mPadding = 2 * BLOCK_SIZE;
+        }
+    }
+    return done;
+}
+
+Tar::Reader::Reader(const std::string& root, const std::string& staging, size_t depth)
+    : mRoot(root),
+      mStaging(staging),
+      mDepth(depth),
+      mBlockPos(0),
+      mFile(NULL),
+      mMetaType(0),
+      mRemaining(0),
+      mPadding(0),
+      mFiles(0),
+      mError(0),
+      mEnded(false)
+{
+}
+
+Tar::Reader::~Reader(void)
+{
+    if (mFile != NULL) {
+        fclose(mFile);
+    }
+    // an archive that was cut short or rejected leaves nothing behind
+    removeTree(mStaging);
+}
+
+bool Tar::Reader::fail(int error)
+{
+    if (mFile != NULL) {
+        fclose(mFile);
+        remove(mFilePath.c_str());
+        mFile = NULL;
+    }
+    mError = error;
+    return false;
+}
+
+bool Tar::Reader::write(const uint8_t* data, size_t size)
+{
+    while (size > 0 && mError == 0 && !mEnded) {
+        if (mRemaining > 0) {
+            size_t n = std::min<uint64_t>(size, mRemaining);
+            if (mMetaType != 0) {
+                mMeta.append((const char*)data, n);
+            }
+            else if (mFile != NULL && fwrite(data, 1, n, mFile) != n) {
+                return fail(EIO);
+            }
+            data += n;
+            size -= n;
+            mRemaining -= n;
+            if (mRemaining == 0) {
+                if (mMetaType == 'L') {
+                    mLongName = mMeta.substr(0, strnlen(mMeta.c_str(), mMeta.size()));
+                    mMetaType = 0;
+                }
+                else if (mMetaType == 'x') {
+                    mLongName = paxPath(mMeta);
+                    mMetaType = 0;
+                }
+                else if (mFile != NULL) {
+                    int res = fclose(mFile);
+                    mFile   = NULL;
+                    if (res != 0) {
+                        remove(mFilePath.c_str());
+                        return fail(EIO);
+                    }
+                    mFiles++;
+                }
+            }
+        }
+        else if (mPadding > 0) {
+            size_t n = std::min(size, mPadding);
+            data += n;
+            size -= n;
+            mPadding -= n;
+        }
+        else {
+            size_t n = std::min(size, BLOCK_SIZE - mBlockPos);
+            memcpy(mBlock + mBlockPos, data, n);
+            data += n;
+            size -= n;
+            mBlockPos += n;
+            if (mBlockPos == BLOCK_SIZE) {
+                mBlockPos = 0;
+                if (!entry()) {
+                    return false;
+                }
+            }
+        }
+    }
+    return mError == 0;
+}
+
+bool Tar::Reader::entry(void)
+{
+    if (std::all_of(mBlock, mBlock + BLOCK_SIZE, [](uint8_t c) { return c == 0; })) {
+        mEnded = true;
+        return true;
+    }
+    if (getNumber(mBlock + 148, 8) != checksum(mBlock)) {
+        return fail(EINVAL);
+    }
+
+    uint64_t size = getNumber(mBlock + 124, 12);
+    char type     = mBlock[156];
+    mRemaining    = size;
+    mPadding      = padding(size);
+
+    if (type == 'L' || type == 'x') {
+        if (size > MAX_META_SIZE) {
+            return fail(ENAMETOOLONG);
+        }
+        mMeta.clear();
+        mMetaType = type;
+        return true;
+    }
+
+    std::string name;
+    if (!mLongName.empty()) {
+        name.swap(mLongName);
+    }
+    else {
+        name               = getString(mBlock, 100);
+        std::string prefix = getString(mBlock + 345, 155);
+        if (memcmp(mBlock + 257, "ustar", 5) == 0 && !prefix.empty()) {
+            name = prefix + "/" + name;
+        }
+    }
+
+    // only plain files and directories are extracted, everything else is skipped
+    if (type != '0' && type != '\0' && type != '7' && type != '5') {
+        return true;
+    }
+
+    // rebuild the path below the root, refusing anything that could escape it
+    if (name.empty() || name[0] == '/') {
+        return fail(EACCES);
+    }
+    std::vector<std::string> parts;
+    for (size_t start = 0, end; start <= name.size(); start = end + 1) {
+        end = name.find('/', start);
+        if (end == std::string::npos) {
+            end = name.size();
+        }
+        std::string part = name.substr(start, end - start);
+        if (part == "..") {
+            return fail(EACCES);
+        }
+        if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+    }
+    if (parts.empty()) {
+        return true;
+    }
+
+    std::string path = mStaging;
+    mkdir(path.c_str(), 0777);
+    size_t dirs = type == '5' ? parts.size() : parts.size() - 1;
+    for (size_t i = 0; i < dirs; i++) {
+        path += "/" + parts[i];
+        if (mkdir(path.c_str(), 0777) != 0 && errno != EEXIST) {
+            return fail(errno);
+        }
+    }
+    if (type == '5') {
+        return true;
+    }
+
+    path += "/" + parts.back();
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        return fail(EEXIST);
+    }
+    mFile = fopen(path.c_str(), "wb");
+    if (mFile == NULL) {
+        return fail(errno);
+    }
+    mFilePath = path;
+    if (mRemaining == 0) {
+        fclose(mFile);
+        mFile = NULL;
+        mFiles++;
+    }
+    return true;
+}
+
+bool Tar::Reader::finish(void)
+{
+    if (mError != 0 || mFile != NULL || mRemaining != 0 || mPadding != 0 || mBlockPos != 0 || mMetaType != 0) {
+        return false;
+    }
+
+    std::vector<std::string> entries;
+    listEntries(mStaging, "", mDepth, entries);
+    struct stat st;
+    for (auto& entry : entries) {
+        if (stat((mRoot + entry).c_str(), &st) == 0) {
+            mConflicts.push_back(entry.substr(1));
+        }
+    }
+    if (!mConflicts.empty()) {
+        return fail(EEXIST);
+    }
+
+    mkdir(mRoot.c_str(), 0777);
+    for (size_t i = 0; i < entries.size(); i++) {
+        for (size_t slash = entries[i].find('/', 1); slash != std::string::npos; slash = entries[i].find('/', slash + 1)) {
+            mkdir((mRoot + entries[i].substr(0, slash)).c_str(), 0777);
+        }
+        if (rename((mStaging + entries[i]).c_str(), (mRoot + entries[i]).c_str()) != 0) {
+            int error = errno;
+            // put back what was already moved, so that the upload is all or nothing
+            while (i-- > 0) {
+                rename((mRoot + entries[i]).c_str(), (mStaging + entries[i]).c_str());
+            }
+            return fail(error);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,107 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TAR_HPP
+#define TAR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// streaming ustar archives, neither side ever holds more than a block and the current file open
+namespace Tar {
+    // produces an archive of directory trees, the trees are walked lazily while the archive is read
+    class Writer {
+    public:
+        Writer(void);
+        ~Writer(void);
+
+        // adds the tree at path, stored under name in the archive
+        void add(const std::string& name, const std::string& path);
+        // fills dst with the next bytes of the archive, returns 0 once it is complete
+        size_t read(uint8_t* dst, size_t size);
+
+    private:
+        struct Entry {
+            std::string name;
+            std::string path;
+        };
+
+        bool next(void);
+        void header(const std::string& name, char type, uint64_t size, uint32_t mode, time_t mtime);
+
+        std::vector<Entry> mPending;
+        std::vector<uint8_t> mHeader;
+        size_t mHeaderPos;
+        FILE* mFile;
+        uint64_t mRemaining;
+        size_t mPadding;
+        bool mEnded;
+    };
+
+    // extracts an archive fed in arbitrary pieces into staging, and only moves it below root once it is complete. The
+    // entries depth levels down the archive are moved one by one and must not exist below root yet, the folders above
+    // them are merged. Whatever is left in staging is deleted along with the reader
+    class Reader {
+    public:
+        Reader(const std::string& root, const std::string& staging, size_t depth);
+        ~Reader(void);
+
+        // returns false once the archive is rejected, the reason is in error()
+        bool write(const uint8_t* data, size_t size);
+        // whether the archive ended on an entry boundary and all of its entries were moved below root. Either all of
+        // them are or none, entries already below root fail with EEXIST and are listed in conflicts()
+        bool finish(void);
+        int error(void) const { return mError; }
+        size_t files(void) const { return mFiles; }
+        const std::vector<std::string>& conflicts(void) const { return mConflicts; }
+
+    private:
+        bool entry(void);
+        bool fail(int error);
+
+        std::string mRoot;
+        std::string mStaging;
+        size_t mDepth;
+        std::vector<std::string> mConflicts;
+        uint8_t mBlock[512];
+        size_t mBlockPos;
+        FILE* mFile;
+        std::string mFilePath;
+        std::string mMeta;     // data of the gnu long name or pax header being read
+        char mMetaType;        // type of that entry, 0 while reading anything else
+        std::string mLongName; // name overriding the one in the next header
+        uint64_t mRemaining;
+        size_t mPadding;
+        size_t mFiles;
+        int mError;
+        bool mEnded;
+    };
+}
+
+#endif
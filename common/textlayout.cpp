@@ -0,0 +1,172 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#include "textlayout.hpp"
+#include <algorithm>
+
+namespace {
+    constexpr uint16_t UNMEASURED  = 0xFFFF;
+    constexpr uint32_t REPLACEMENT = 0xFFFD;
+}
+
+uint32_t TextLayout::decode(const std::string& text, size_t& i)
+{
+    const uint8_t lead = text[i++];
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    size_t length;
+    uint32_t codepoint;
+    if ((lead & 0xE0) == 0xC0) {
+        length    = 1;
+        codepoint = lead & 0x1F;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+        length    = 2;
+        codepoint = lead & 0x0F;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+        length    = 3;
+        codepoint = lead & 0x07;
+    }
+    else {
+        return REPLACEMENT;
+    }
+
+    if (i + length > text.size()) {
+        return REPLACEMENT;
+    }
+    for (size_t j = 0; j < length; j++) {
+        if ((text[i + j] & 0xC0) != 0x80) {
+            return REPLACEMENT;
+        }
+        codepoint = codepoint << 6 | (text[i + j] & 0x3F);
+    }
+    i += length;
+    return codepoint;
+}
+
+TextLayout::GlyphTable::GlyphTable(std::function<uint16_t(uint32_t)> measure) : mMeasure(measure) {}
+
+uint16_t TextLayout::GlyphTable::width(uint32_t codepoint)
+{
+    if (codepoint > 0xFFFF) {
+        return mMeasure(codepoint);
+    }
+    if (!mWidths) {
+        mWidths = std::make_unique<uint16_t[]>(0x10000);
+        std::fill_n(mWidths.get(), 0x10000, UNMEASURED);
+    }
+    uint16_t& width = mWidths[codepoint];
+    if (width == UNMEASURED) {
+        width = std::min<uint16_t>(mMeasure(codepoint), UNMEASURED - 1);
+    }
+    return width;
+}
+
+float TextLayout::width(GlyphTable& glyphs, const std::string& text, float scale)
+{
+    float line    = 0.0f;
+    float largest = 0.0f;
+    for (size_t i = 0; i < text.size();) {
+        const uint32_t codepoint = decode(text, i);
+        if (codepoint == '\n') {
+            largest = std::max(largest, line);
+            line    = 0.0f;
+        }
+        else {
+            line += glyphs.width(codepoint) * scale;
+        }
+    }
+    return std::max(largest, line);
+}
+
+std::string TextLayout::wrap(GlyphTable& glyphs, const std::string& text, float scale, float maxWidth)
+{
+    std::string dst;
+    dst.reserve(text.size() + text.size() / 16);
+
+    float line = 0.0f;
+    // offset in dst of the last space on the current line, and the width of what follows it
+    size_t lastSpace = std::string::npos;
+    float afterSpace = 0.0f;
+
+    for (size_t i = 0; i < text.size();) {
+        const size_t start       = i;
+        const uint32_t codepoint = decode(text, i);
+        if (codepoint == '\n') {
+            dst += '\n';
+            line      = 0.0f;
+            lastSpace = std::string::npos;
+            continue;
+        }
+
+        const float width = glyphs.width(codepoint) * scale;
+        if (codepoint == ' ') {
+            // a space never starts a line, an overflowing line is broken at it instead
+            lastSpace  = dst.size();
+            afterSpace = 0.0f;
+            dst += ' ';
+            line += width;
+            continue;
+        }
+
+        if (line + width > maxWidth && lastSpace != std::string::npos) {
+            dst[lastSpace] = '\n';
+            line           = afterSpace;
+            lastSpace      = std::string::npos;
+        }
+        if (line + width > maxWidth && line > 0.0f) {
+            dst += '\n';
+            line = 0.0f;
+        }
+
+        dst.append(text, start, i - start);
+        line += width;
+        afterSpace += width;
+    }
+
+    return dst;
+}
+
+std::string TextLayout::ellipsize(GlyphTable& glyphs, const std::string& text, float scale, float maxWidth, const std::string& ellipsis)
+{
+    const float ellipsisWidth = width(glyphs, ellipsis, scale);
+
+    float line = 0.0f;
+    // longest prefix that still leaves room for the ellipsis
+    size_t fits = 0;
+    for (size_t i = 0; i < text.size();) {
+        line += glyphs.width(decode(text, i)) * scale;
+        if (line > maxWidth) {
+            return text.substr(0, fits) + ellipsis;
+        }
+        if (line + ellipsisWidth <= maxWidth) {
+            fits = i;
+        }
+    }
+    return text;
+}
@@ -0,0 +1,60 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef TEXTLAYOUT_HPP
+#define TEXTLAYOUT_HPP
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace TextLayout {
+    // decodes the codepoint at text[i] and moves i past it, malformed sequences decode to U+FFFD one byte at a time
+    uint32_t decode(const std::string& text, size_t& i);
+
+    // unscaled advance widths, measured once per codepoint. The basic multilingual plane is looked up in a flat
+    // table indexed by codepoint, allocated on first use; codepoints above it are measured every time
+    class GlyphTable {
+    public:
+        GlyphTable(std::function<uint16_t(uint32_t)> measure);
+
+        uint16_t width(uint32_t codepoint);
+
+    private:
+        std::function<uint16_t(uint32_t)> mMeasure;
+        std::unique_ptr<uint16_t[]> mWidths;
+    };
+
+    // width of the widest line
+    float width(GlyphTable& glyphs, const std::string& text, float scale);
+    // greedy word wrap in a single pass: lines break at the last space that fits, words wider than a line are split
+    std::string wrap(GlyphTable& glyphs, const std::string& text, float scale, float maxWidth);
+    // cuts single line text at a codepoint boundary and appends the ellipsis so that the result fits in maxWidth
+    std::string ellipsize(GlyphTable& glyphs, const std::string& text, float scale, float maxWidth, const std::string& ellipsis = "...");
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#include "titleindex.hpp"
+#include "textlayout.hpp"
+#include <stdio.h>
+
+namespace {
+    // U+00C0 to U+017F without diacritics, '-' keeps the codepoint
+    const char* LATIN = "aaaaaaaceeeeiiii"
+                        "dnooooo-ouuuuyts"
+                        "aaaaaaaceeeeiiii"
+                        "dnooooo-ouuuuyty"
+                        "aaaaaaccccccccdd"
+                        "ddeeeeeeeeeegggg"
+                        "gggghhhhiiiiiiii"
+                        "iiiijjkkklllllll"
+                        "lllnnnnnnnnnoooo"
+                        "oooorrrrrrssssss"
+                        "ssttttttuuuuuuuu"
+                        "uuuuwwyyyzzzzzzs";
+
+    // fields are joined with a separator nobody types, so that queries don't match across them
+    constexpr char SEPARATOR = '\x1F';
+
+    void encode(uint32_t codepoint, std::string& dst)
+    {
+        if (codepoint < 0x80) {
+            dst += (char)codepoint;
+        }
+        else if (codepoint < 0x800) {
+            dst += (char)(0xC0 | codepoint >> 6);
+            dst += (char)(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000) {
+            dst += (char)(0xE0 | codepoint >> 12);
+            dst += (char)(0x80 | (codepoint >> 6 & 0x3F));
+            dst += (char)(0x80 | (codepoint & 0x3F));
+        }
+        else {
+            dst += (char)(0xF0 | codepoint >> 18);
+            dst += (char)(0x80 | (codepoint >> 12 & 0x3F));
+            dst += (char)(0x80 | (codepoint >> 6 & 0x3F));
+            dst += (char)(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    uint32_t trigram(const std::string& text, size_t i)
+    {
+        return (uint8_t)text[i] << 16 | (uint8_t)text[i + 1] << 8 | (uint8_t)text[i + 2];
+    }
+}
+
+std::string TitleIndex::fold(const std::string& text)
+{
+    std::string dst;
+    dst.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        uint32_t codepoint = TextLayout::decode(text, i);
+        if (codepoint >= 'A' && codepoint <= 'Z') {
+            codepoint += 'a' - 'A';
+        }
+        else if (codepoint >= 0xC0 && codepoint <= 0x17F && LATIN[codepoint - 0xC0] != '-') {
+            codepoint = LATIN[codepoint - 0xC0];
+        }
+        else if (codepoint >= 0xFF01 && codepoint <= 0xFF5E) {
+            codepoint -= 0xFEE0;
+            if (codepoint >= 'A' && codepoint <= 'Z') {
+                codepoint += 'a' - 'A';
+            }
+        }
+        else if (codepoint == 0x3000) {
+            codepoint = ' ';
+        }
+        encode(codepoint, dst);
+    }
+    return dst;
+}
+
+void TitleIndex::clear(void)
+{
+    mTexts.clear();
+    mTrigrams.clear();
+}
+
+void TitleIndex::add(const std::string& name, const std::string& author, uint64_t id)
+{
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llX", (unsigned long long)id);
+    const std::string text = fold(name) + SEPARATOR + fold(author) + SEPARATOR + fold(hex);
+
+    const uint32_t title = mTexts.size();
+    for (size_t i = 0; i + 3 <= text.size(); i++) {
+        std::vector<uint32_t>& titles = mTrigrams[trigram(text, i)];
+        if (titles.empty() || titles.back() != title) {
+            titles.push_back(title);
+        }
+    }
+    mTexts.push_back(text);
+}
+
+void TitleIndex::search(const std::string& query, std::vector<bool>& matches) const
+{
+    const std::string folded = fold(query);
+    if (folded.empty()) {
+        matches.assign(mTexts.size(), true);
+        return;
+    }
+
+    matches.assign(mTexts.size(), false);
+    // shorter queries have no trigram to look up, the titles are few enough to scan
+    if (folded.size() < 3) {
+        for (size_t i = 0; i < mTexts.size(); i++) {
+            matches[i] = mTexts[i].find(folded) != std::string::npos;
+        }
+        return;
+    }
+
+    const std::vector<uint32_t>* rarest = nullptr;
+    for (size_t i = 0; i + 3 <= folded.size(); i++) {
+        auto got = mTrigrams.find(trigram(folded, i));
+        if (got == mTrigrams.end()) {
+            return;
+        }
+        if (rarest == nullptr || got->second.size() < rarest->size()) {
+            rarest = &got->second;
+        }
+    }
+    for (uint32_t title : *rarest) {
+        matches[title] = mTexts[title].find(folded) != std::string::npos;
+    }
+}
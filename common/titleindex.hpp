@@ -0,0 +1,54 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef TITLEINDEX_HPP
+#define TITLEINDEX_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// case and accent insensitive substring search over title names, authors and ids. Every trigram of the folded text lists
+// the titles containing it, so a query only has to check the titles listed under its rarest trigram
+class TitleIndex {
+public:
+    void clear(void);
+    // titles are numbered in the order they are added
+    void add(const std::string& name, const std::string& author, uint64_t id);
+    size_t size(void) const { return mTexts.size(); }
+    // matches[i] tells whether title i contains the query, an empty query matches every title
+    void search(const std::string& query, std::vector<bool>& matches) const;
+
+    // lower case ascii, latin letters without diacritics and fullwidth forms as ascii, anything else is kept as is
+    static std::string fold(const std::string& text);
+
+private:
+    std::vector<std::string> mTexts;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> mTrigrams;
+};
+
+#endif
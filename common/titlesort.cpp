@@ -0,0 +1,111 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#include "titlesort.hpp"
+#include <algorithm>
+
+namespace {
+    constexpr uint64_t NOT_FAVORITE = 1ULL << 63;
+    constexpr size_t PREFIX_LENGTH  = 7;
+    constexpr uint64_t RANK_MASK    = 0x7FFFFFFF;
+
+    unsigned char fold(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    }
+
+    // the first bytes of the folded name, big endian so that comparing keys compares the prefixes
+    uint64_t nameKey(const TitleSort::Item& item)
+    {
+        uint64_t key = 0;
+        for (size_t i = 0; i < PREFIX_LENGTH; i++) {
+            key = key << 8 | (i < item.name.size() ? fold(item.name[i]) : 0);
+        }
+        return (item.favorite ? 0 : NOT_FAVORITE) | key;
+    }
+
+    int compareFolded(const std::string& l, const std::string& r)
+    {
+        const size_t length = std::min(l.size(), r.size());
+        for (size_t i = PREFIX_LENGTH; i < length; i++) {
+            if (fold(l[i]) != fold(r[i])) {
+                return fold(l[i]) < fold(r[i]) ? -1 : 1;
+            }
+        }
+        return l.size() < r.size() ? -1 : l.size() > r.size() ? 1 : 0;
+    }
+
+    // descending value, then the alphabetical rank. Every key is unique, the rank recovers the index
+    TitleSort::Permutation descending(
+        const std::vector<TitleSort::Item>& items, const TitleSort::Permutation& alpha, uint32_t TitleSort::Item::*value)
+    {
+        std::vector<uint64_t> keys(alpha.size());
+        for (size_t rank = 0; rank < alpha.size(); rank++) {
+            const TitleSort::Item& item = items[alpha[rank]];
+            keys[rank]                  = (item.favorite ? 0 : NOT_FAVORITE) | (uint64_t)(UINT32_MAX - item.*value) << 31 | rank;
+        }
+        std::sort(keys.begin(), keys.end());
+
+        TitleSort::Permutation permutation(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            permutation[i] = alpha[keys[i] & RANK_MASK];
+        }
+        return permutation;
+    }
+}
+
+TitleSort::Permutation TitleSort::alphabetical(const std::vector<Item>& items)
+{
+    std::vector<uint64_t> keys(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        keys[i] = nameKey(items[i]);
+    }
+
+    Permutation permutation(items.size());
+    for (size_t i = 0; i < permutation.size(); i++) {
+        permutation[i] = i;
+    }
+    std::sort(permutation.begin(), permutation.end(), [&](uint32_t l, uint32_t r) {
+        if (keys[l] != keys[r]) {
+            return keys[l] < keys[r];
+        }
+        // same favorite flag and prefix, only now the names themselves are compared
+        const int folded = compareFolded(items[l].name, items[r].name);
+        if (folded != 0) {
+            return folded < 0;
+        }
+        return items[l].name != items[r].name ? items[l].name < items[r].name : l < r;
+    });
+    return permutation;
+}
+
+std::array<TitleSort::Permutation, TitleSort::ORDER_COUNT> TitleSort::permutations(const std::vector<Item>& items)
+{
+    std::array<Permutation, ORDER_COUNT> permutations;
+    permutations[ORDER_ALPHA]       = alphabetical(items);
+    permutations[ORDER_LAST_PLAYED] = descending(items, permutations[ORDER_ALPHA], &Item::lastPlayed);
+    permutations[ORDER_PLAY_TIME]   = descending(items, permutations[ORDER_ALPHA], &Item::playTime);
+    return permutations;
+}
@@ -0,0 +1,54 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef TITLESORT_HPP
+#define TITLESORT_HPP
+
+#include <array>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// sorts title lists through compact integer keys built once per title, instead of comparing Title objects and looking up
+// favorites on every comparison. Favorites come first in every order, ties are broken alphabetically
+namespace TitleSort {
+    enum order_t { ORDER_ALPHA, ORDER_LAST_PLAYED, ORDER_PLAY_TIME, ORDER_COUNT };
+
+    struct Item {
+        std::string name;
+        bool favorite;
+        uint32_t lastPlayed;
+        uint32_t playTime;
+    };
+
+    typedef std::vector<uint32_t> Permutation;
+
+    // indices into items in alphabetical order, case insensitive for ascii
+    Permutation alphabetical(const std::vector<Item>& items);
+    // one permutation per order, so that switching between them doesn't sort again
+    std::array<Permutation, ORDER_COUNT> permutations(const std::vector<Item>& items);
+}
+
+#endif
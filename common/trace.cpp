@@ -0,0 +1,181 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "trace.hpp"
+
+#if defined(CHECKPOINT_TRACING)
+
+#include "logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <memory>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#if defined(_3DS)
+#include <3ds.h>
+#elif defined(__SWITCH__)
+#include <switch.h>
+#endif
+
+namespace {
+#if defined(_3DS)
+    const char* TRACE_PATH = "sdmc:/3ds/Checkpoint/trace.json";
+#elif defined(__SWITCH__)
+    const char* TRACE_PATH = "/switch/Checkpoint/trace.json";
+#else
+    const char* TRACE_PATH = "trace.json";
+#endif
+
+    // events kept per thread, once full the oldest ones are overwritten so that the per-frame scopes of a long session
+    // never crowd out the slow paths that happen last
+    const size_t MAX_EVENTS = 0x2000;
+
+    struct Event {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // fixed size ring so that dump can read a buffer while its thread is still appending to it.
+    // count is the number of events ever recorded, event n lives in events[n % MAX_EVENTS]
+    struct ThreadBuffer {
+        uint32_t tid;
+        std::atomic<size_t> count{0};
+        Event events[MAX_EVENTS];
+    };
+
+    // buffers outlive their threads, the registry is only locked when a thread records its first event and on dump
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::atomic_flag buffersLock = ATOMIC_FLAG_INIT;
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+
+    void lock(void)
+    {
+        while (buffersLock.test_and_set(std::memory_order_acquire))
+            ;
+    }
+
+    void unlock(void)
+    {
+        buffersLock.clear(std::memory_order_release);
+    }
+
+    double toMicroseconds(uint64_t ticks)
+    {
+#if defined(_3DS)
+        return ticks / (SYSCLOCK_ARM11 / 1e6);
+#elif defined(__SWITCH__)
+        return ticks / (armGetSystemTickFreq() / 1e6);
+#else
+        return ticks / 1e3;
+#endif
+    }
+}
+
+uint64_t Trace::now(void)
+{
+#if defined(_3DS)
+    return svcGetSystemTick();
+#elif defined(__SWITCH__)
+    return armGetSystemTick();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+void Trace::record(const char* name, uint64_t start, uint64_t end)
+{
+    if (threadBuffer == nullptr) {
+        lock();
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        threadBuffer      = buffers.back().get();
+        threadBuffer->tid = buffers.size();
+        unlock();
+    }
+    size_t count                             = threadBuffer->count.load(std::memory_order_relaxed);
+    threadBuffer->events[count % MAX_EVENTS] = {name, start, end};
+    threadBuffer->count.store(count + 1, std::memory_order_release);
+}
+
+void Trace::dump(void)
+{
+    FILE* f = fopen(TRACE_PATH, "w");
+    if (f == NULL) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to write the trace with errno %d.", errno);
+        return;
+    }
+
+    // threads still running keep recording. events are copied out first, any of them that the thread may have started
+    // overwriting in the meantime is discarded
+    lock();
+    std::vector<std::vector<Event>> events(buffers.size());
+    std::vector<size_t> overwritten(buffers.size());
+    uint64_t origin = UINT64_MAX;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        auto& buffer = buffers[i];
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        size_t first = count > MAX_EVENTS ? count - MAX_EVENTS : 0;
+        for (size_t n = first; n < count; n++) {
+            events[i].push_back(buffer->events[n % MAX_EVENTS]);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        size_t after = buffer->count.load(std::memory_order_relaxed);
+        size_t valid = after >= MAX_EVENTS ? after - MAX_EVENTS + 1 : 0;
+        if (valid > first) {
+            events[i].erase(events[i].begin(), events[i].begin() + std::min(valid - first, events[i].size()));
+        }
+        overwritten[i] = count - events[i].size();
+        for (const Event& event : events[i]) {
+            origin = std::min(origin, event.start);
+        }
+    }
+
+    fputs("{\"traceEvents\":[", f);
+    for (size_t i = 0; i < buffers.size(); i++) {
+        unsigned tid = buffers[i]->tid;
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", i == 0 ? "" : ",", tid,
+            tid);
+        for (const Event& event : events[i]) {
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event.name, tid,
+                toMicroseconds(event.start - origin), toMicroseconds(event.end - event.start));
+        }
+        if (overwritten[i] > 0) {
+            fprintf(f, ",\n{\"name\":\"%u older events overwritten\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":0}",
+                (unsigned)overwritten[i], tid);
+        }
+    }
+    fputs("\n]}\n", f);
+    unlock();
+
+    fclose(f);
+    Logger::getInstance().log(Logger::INFO, "Trace written to %s.", TRACE_PATH);
+}
+
+#endif
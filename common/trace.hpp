@@ -0,0 +1,67 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <stdint.h>
+
+// scoped timing of slow paths, compiled in with TRACING=1 and dumped as chrome trace-event json
+// (chrome://tracing or ui.perfetto.dev) when the app exits. without it TRACE_SCOPE expands to nothing
+#if defined(CHECKPOINT_TRACING)
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// name must be a string literal, only the pointer is stored
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+namespace Trace {
+    uint64_t now(void);
+    void record(const char* name, uint64_t start, uint64_t end);
+    void dump(void);
+
+    class Scope {
+    public:
+        Scope(const char* name) : mName(name), mStart(now()) {}
+        ~Scope(void) { record(mName, mStart, now()); }
+
+    private:
+        const char* mName;
+        uint64_t mStart;
+    };
+}
+
+#else
+
+#define TRACE_SCOPE(name)
+
+namespace Trace {
+    inline void dump(void) {}
+}
+
+#endif
+
+#endif
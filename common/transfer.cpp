@@ -0,0 +1,478 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "transfer.hpp"
+#include "hash.hpp"
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <memory>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+    const char MAGIC[8]          = {'P', 'K', 'S', 'M', 'B', 'R', 'D', 'G'};
+    const uint32_t VERSION       = 3;
+    const size_t CHUNK_SIZE      = 0x10000;
+    const uint64_t WINDOW        = 8; // chunks the sender may have in flight before waiting for an ack
+    const int SOCKET_BUFFER_SIZE = 0x40000;
+    const int HELLO_TIMEOUT_MS   = 1500;
+
+    static_assert(sizeof(Transfer::Hello) == 16, "unexpected transfer hello size");
+    static_assert(sizeof(Transfer::Header) == 32, "unexpected transfer header size");
+    static_assert(sizeof(Transfer::Ack) == 16, "unexpected transfer ack size");
+
+    bool sendAll(int fd, const void* data, size_t size)
+    {
+        const uint8_t* p = (const uint8_t*)data;
+        while (size > 0) {
+            ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool recvAll(int fd, void* data, size_t size)
+    {
+        uint8_t* p = (uint8_t*)data;
+        while (size > 0) {
+            ssize_t n = recv(fd, p, size, 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (n == 0) {
+                errno = ECONNRESET;
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool waitReadable(int fd, int timeoutMs)
+    {
+        struct pollfd pfd;
+        pfd.fd     = fd;
+        pfd.events = POLLIN;
+        int n;
+        do {
+            n = poll(&pfd, 1, timeoutMs);
+        } while (n < 0 && errno == EINTR);
+        return n > 0;
+    }
+
+    bool sendHello(int fd)
+    {
+        Transfer::Hello hello;
+        memcpy(hello.magic, MAGIC, sizeof(MAGIC));
+        hello.version  = VERSION;
+        hello.reserved = 0;
+        return sendAll(fd, &hello, sizeof(Transfer::Hello));
+    }
+
+    bool sendAck(int fd, uint32_t status, uint64_t offset)
+    {
+        Transfer::Ack ack;
+        ack.status   = status;
+        ack.reserved = 0;
+        ack.offset   = offset;
+        return sendAll(fd, &ack, sizeof(Transfer::Ack));
+    }
+
+    const char PART_EXTENSION[] = ".part";
+
+    // staged data is keyed by the payload checksum, so a resume never mixes two different payloads
+    std::string partName(const Transfer::Header& header)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx%s", (unsigned long long)header.checksum, PART_EXTENSION);
+        return name;
+    }
+
+    // rename does not replace an existing file on every platform
+    int replaceFile(const std::string& src, const std::string& dst)
+    {
+        if (rename(src.c_str(), dst.c_str()) == 0) {
+            return 0;
+        }
+        if (remove(dst.c_str()) != 0 && errno != ENOENT) {
+            return errno;
+        }
+        return rename(src.c_str(), dst.c_str()) == 0 ? 0 : errno;
+    }
+
+    const char LEGACY_PART[] = "legacy.part";
+
+    // raw payload for peers without framing, there is nothing to resume or verify
+    int sendLegacy(int fd, FILE* f, uint8_t* buffer, const Transfer::progress_t& progress)
+    {
+        fseek(f, 0, SEEK_END);
+        uint64_t size = ftell(f);
+        rewind(f);
+
+        uint64_t sent = 0;
+        size_t n;
+        while ((n = fread(buffer, 1, CHUNK_SIZE, f)) > 0) {
+            if (!sendAll(fd, buffer, n)) {
+                return errno;
+            }
+            sent += n;
+            if (progress) {
+                progress(sent, size);
+            }
+        }
+        return ferror(f) || sent != size ? EIO : 0;
+    }
+
+    // head holds the bytes already read while looking for the header magic
+    int recvLegacy(int fd, const uint8_t* head, size_t headSize, const std::string& path, const std::string& stagingDir,
+        uint64_t maxSize, uint64_t legacySize, const Transfer::progress_t& progress)
+    {
+        if (legacySize == 0) {
+            return EPROTO;
+        }
+        if (legacySize > maxSize || headSize > legacySize) {
+            return EFBIG;
+        }
+        if (mkdir(stagingDir.c_str(), 0777) != 0 && errno != EEXIST) {
+            return errno;
+        }
+
+        std::string part = stagingDir + "/" + LEGACY_PART;
+        FILE* f          = fopen(part.c_str(), "wb");
+        if (f == NULL) {
+            return errno;
+        }
+
+        std::unique_ptr<uint8_t[]> buffer(new uint8_t[CHUNK_SIZE]);
+        int res           = fwrite(head, 1, headSize, f) == headSize ? 0 : EIO;
+        uint64_t received = headSize;
+        while (res == 0 && received < legacySize) {
+            ssize_t n = recv(fd, buffer.get(), std::min<uint64_t>(CHUNK_SIZE, legacySize - received), 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                res = errno;
+                break;
+            }
+            if (n == 0) {
+                res = ECONNRESET;
+                break;
+            }
+            if (fwrite(buffer.get(), 1, n, f) != (size_t)n) {
+                res = EIO;
+                break;
+            }
+            received += n;
+            if (progress) {
+                progress(received, legacySize);
+            }
+        }
+
+        if (fclose(f) != 0 && res == 0) {
+            res = EIO;
+        }
+        if (res == 0) {
+            res = replaceFile(part, path);
+        }
+        if (res != 0) {
+            remove(part.c_str());
+        }
+        return res;
+    }
+
+    // only the payload being received can ever be resumed, anything else staged is left over from an older transfer
+    void removeStaleParts(const std::string& stagingDir, const std::string& keep)
+    {
+        DIR* dir = opendir(stagingDir.c_str());
+        if (dir == NULL) {
+            return;
+        }
+        const size_t extLength = sizeof(PART_EXTENSION) - 1;
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            std::string name = ent->d_name;
+            if (name != keep && name.size() > extLength && name.compare(name.size() - extLength, extLength, PART_EXTENSION) == 0) {
+                remove((stagingDir + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+
+    // opens the staged file and feeds what it already holds to the hash, returns the offset to resume from
+    FILE* openPart(const std::string& part, uint64_t size, Hash::Fast64& hash, uint64_t& offset, uint8_t* buffer)
+    {
+        offset = 0;
+        struct stat st;
+        if (stat(part.c_str(), &st) == 0 && (uint64_t)st.st_size <= size) {
+            FILE* f = fopen(part.c_str(), "r+b");
+            if (f != NULL) {
+                size_t n;
+                while ((n = fread(buffer, 1, CHUNK_SIZE, f)) > 0) {
+                    hash.update(buffer, n);
+                    offset += n;
+                }
+                // switching from reading to writing requires a seek
+                if (!ferror(f) && fseek(f, 0, SEEK_END) == 0) {
+                    return f;
+                }
+                fclose(f);
+            }
+            hash   = Hash::Fast64();
+            offset = 0;
+        }
+        return fopen(part.c_str(), "wb");
+    }
+
+}
+
+void Transfer::configureSocket(int fd)
+{
+    // the default buffers are tiny, failures here only cost throughput
+    int size = SOCKET_BUFFER_SIZE;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+}
+
+int Transfer::sendFile(int fd, const std::string& path, const progress_t& progress)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return errno;
+    }
+
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[CHUNK_SIZE]);
+
+    // receivers that know the framing greet first, anything else gets the bare payload
+    Hello hello;
+    if (!waitReadable(fd, HELLO_TIMEOUT_MS)) {
+        int res = sendLegacy(fd, f, buffer.get(), progress);
+        fclose(f);
+        return res;
+    }
+    if (!recvAll(fd, &hello, sizeof(Hello))) {
+        int err = errno;
+        fclose(f);
+        return err;
+    }
+    if (memcmp(hello.magic, MAGIC, sizeof(MAGIC)) != 0 || hello.version != VERSION) {
+        fclose(f);
+        return EPROTO;
+    }
+
+    // the checksum travels in the header, compute it in a first streaming pass
+    Hash::Fast64 hash;
+    uint64_t size = 0;
+    size_t n;
+    while ((n = fread(buffer.get(), 1, CHUNK_SIZE, f)) > 0) {
+        hash.update(buffer.get(), n);
+        size += n;
+    }
+    if (ferror(f)) {
+        fclose(f);
+        return EIO;
+    }
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version  = VERSION;
+    header.flags    = 0;
+    header.size     = size;
+    header.checksum = hash.finish();
+
+    // the first ack tells how much of this payload the receiver already holds
+    Ack ack;
+    if (!sendAll(fd, &header, sizeof(Header)) || !recvAll(fd, &ack, sizeof(Ack))) {
+        int err = errno;
+        fclose(f);
+        return err;
+    }
+    if (ack.status != 0 || ack.offset > size || fseek(f, ack.offset, SEEK_SET) != 0) {
+        fclose(f);
+        return ack.status != 0 ? (int)ack.status : EPROTO;
+    }
+
+    uint64_t sent  = ack.offset;
+    uint64_t acked = ack.offset;
+    if (progress) {
+        progress(acked, size);
+    }
+
+    // keep a few chunks in flight, the ack reaching size arrives once the receiver verified the whole payload
+    bool verified = false;
+    while (!verified) {
+        if (sent < size && sent - acked < WINDOW * CHUNK_SIZE) {
+            n = fread(buffer.get(), 1, std::min<uint64_t>(CHUNK_SIZE, size - sent), f);
+            if (n == 0) {
+                fclose(f);
+                return EIO;
+            }
+            if (!sendAll(fd, buffer.get(), n)) {
+                int err = errno;
+                fclose(f);
+                return err;
+            }
+            sent += n;
+            continue;
+        }
+
+        if (!recvAll(fd, &ack, sizeof(Ack))) {
+            int err = errno;
+            fclose(f);
+            return err;
+        }
+        if (ack.status != 0 || ack.offset < acked || ack.offset > sent) {
+            fclose(f);
+            return ack.status != 0 ? (int)ack.status : EPROTO;
+        }
+        acked    = ack.offset;
+        verified = acked == size;
+        if (progress) {
+            progress(acked, size);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+int Transfer::recvFile(
+    int fd, const std::string& path, const std::string& stagingDir, uint64_t maxSize, uint64_t legacySize, const progress_t& progress)
+{
+    // a peer without framing never reads the hello and starts with the payload itself
+    Header header;
+    if (!sendHello(fd) || !recvAll(fd, header.magic, sizeof(MAGIC))) {
+        return errno;
+    }
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return recvLegacy(fd, (const uint8_t*)header.magic, sizeof(MAGIC), path, stagingDir, maxSize, legacySize, progress);
+    }
+    if (!recvAll(fd, (uint8_t*)&header + sizeof(MAGIC), sizeof(Header) - sizeof(MAGIC))) {
+        return errno;
+    }
+
+    int res = 0;
+    if (header.version != VERSION) {
+        res = EPROTO;
+    }
+    else if (header.size > maxSize) {
+        res = EFBIG;
+    }
+
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[CHUNK_SIZE]);
+    std::string part = stagingDir + "/" + partName(header);
+    Hash::Fast64 hash;
+    uint64_t received = 0;
+    FILE* f           = NULL;
+    if (res == 0) {
+        if (mkdir(stagingDir.c_str(), 0777) != 0 && errno != EEXIST) {
+            res = errno;
+        }
+        else {
+            removeStaleParts(stagingDir, partName(header));
+            if ((f = openPart(part, header.size, hash, received, buffer.get())) == NULL) {
+                res = errno;
+            }
+        }
+    }
+
+    if (!sendAck(fd, res, received) || res != 0) {
+        if (f != NULL) {
+            fclose(f);
+        }
+        return res != 0 ? res : errno;
+    }
+
+    if (progress) {
+        progress(received, header.size);
+    }
+
+    bool connected = true;
+    while (received < header.size) {
+        size_t n = std::min<uint64_t>(CHUNK_SIZE, header.size - received);
+        if (!recvAll(fd, buffer.get(), n)) {
+            res       = errno;
+            connected = false;
+            break;
+        }
+        if (fwrite(buffer.get(), 1, n, f) != n || fflush(f) != 0) {
+            res = EIO;
+            break;
+        }
+        hash.update(buffer.get(), n);
+        received += n;
+        if (progress) {
+            progress(received, header.size);
+        }
+        // the last chunk is acknowledged together with the verification below
+        if (received < header.size && !sendAck(fd, 0, received)) {
+            res       = errno;
+            connected = false;
+            break;
+        }
+    }
+
+    if (fclose(f) != 0 && res == 0) {
+        res = EIO;
+    }
+    if (!connected) {
+        // keep what made it to disk, the sender can resume from there
+        return res;
+    }
+
+    if (res == 0 && hash.finish() != header.checksum) {
+        res = EBADMSG;
+    }
+    if (res == 0) {
+        res = replaceFile(part, path);
+    }
+    if (res != 0) {
+        // corrupted or unwritable data cannot be resumed
+        remove(part.c_str());
+    }
+
+    // best effort, the outcome on disk does not depend on the sender hearing about it
+    sendAck(fd, res, received);
+    return res;
+}
@@ -0,0 +1,78 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TRANSFER_HPP
+#define TRANSFER_HPP
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// framed, resumable file transfers over a connected TCP socket, used by the PKSM bridge.
+// the receiver greets with a Hello as soon as the connection is up, the sender writes a Header and the receiver
+// answers with an Ack holding the offset to resume from, then the payload follows in CHUNK_SIZE chunks.
+// the receiver acks every chunk once it is on disk, the ack of the last chunk carries the outcome of the checksum
+// verification. all fields are little endian.
+// peers predating the framing send and expect the bare payload: a sender that is not greeted within
+// HELLO_TIMEOUT_MS sends it raw, and a receiver that does not find the header magic stores the raw stream
+namespace Transfer {
+    struct Hello {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint64_t size;
+        uint64_t checksum; // Hash::fast64 of the payload
+    };
+
+    struct Ack {
+        uint32_t status; // 0 or an errno value, the transfer is over when not 0
+        uint32_t reserved;
+        uint64_t offset; // payload bytes stored by the receiver
+    };
+
+    // called after every acknowledged chunk with the amount of bytes transferred so far
+    typedef std::function<void(uint64_t done, uint64_t total)> progress_t;
+
+    void configureSocket(int fd);
+    // both return 0 on success or an errno value.
+    // the receiver stages the payload in stagingDir and only renames it over path once the checksum matches.
+    // stagingDir must be on the same device as path and outside anything that gets copied around, an interrupted
+    // transfer leaves the staged data there and the next transfer of the same payload resumes it.
+    // staged data of any other payload is stale and deleted when a transfer starts.
+    // legacySize is the exact size of a raw payload from a peer without framing, 0 rejects such peers
+    int sendFile(int fd, const std::string& path, const progress_t& progress);
+    int recvFile(int fd, const std::string& path, const std::string& stagingDir, uint64_t maxSize, uint64_t legacySize,
+        const progress_t& progress);
+}
+
+#endif
@@ -31,6 +31,7 @@
 #include "ErrorOverlay.hpp"
 #include "InfoOverlay.hpp"
 #include "Screen.hpp"
+#include "SearchOverlay.hpp"
 #include "YesNoOverlay.hpp"
 #include "clickable.hpp"
 #include "hid.hpp"
@@ -73,6 +74,9 @@ private:
     bool pksmBridge;
     Hid<HidDirection::HORIZONTAL, HidDirection::HORIZONTAL> hid;
     std::unique_ptr<Scrollable> backupList;
+    // what the backup list was last built from
+    mutable std::tuple<AccountUid, u64, u32> backupListKey;
+    mutable size_t backupListIndex;
     std::unique_ptr<Clickable> buttonCheats, buttonBackup, buttonRestore;
     char ver[8];
 };
@@ -10,6 +10,7 @@
 #include <string>
 #include <switch.h>
 #include <unordered_map>
+#include <vector>
 
 bool SDLH_Init(void);
 void SDLH_Exit(void);
@@ -19,6 +20,11 @@ void SDLH_DrawRect(int x, int y, int w, int h, SDL_Color color);
 void SDLH_DrawText(int size, int x, int y, SDL_Color color, const char* text);
 void SDLH_LoadImage(SDL_Texture** texture, char* path);
 void SDLH_LoadImage(SDL_Texture** texture, u8* buff, size_t size);
+// decodes an image to an RGBA32 surface without touching the renderer, so it can run on any thread
+SDL_Surface* SDLH_DecodeImage(u8* buff, size_t size);
+// decodes a square image and box filters it down to side x side RGBA8 pixels, its side has to be a multiple of side
+bool SDLH_DecodeThumbnail(u8* buff, size_t size, u8* pixels, int side);
+SDL_Texture* SDLH_CreateTextureRGBA(const u8* pixels, int w, int h, int pitch);
 void SDLH_DrawImage(SDL_Texture* texture, int x, int y);
 void SDLH_DrawImageScale(SDL_Texture* texture, int x, int y, int w, int h);
 void SDLH_DrawIcon(std::string icon, int x, int y);
@@ -26,6 +32,13 @@ void SDLH_GetTextDimensions(int size, const char* text, u32* w, u32* h);
 void SDLH_DrawTextBox(int size, int x, int y, SDL_Color color, int max, const char* text);
 void SDLH_Render(void);
 
+// The static part of the screen is drawn into a texture only when something changed. Pulsing outlines drawn while the cache
+// is filled are recorded and replayed over it every frame, so that they keep animating
+bool SDLH_HasCache(void);
+void SDLH_BeginCache(void);
+void SDLH_DropAnimations(void);
+void SDLH_DrawCache(void);
+
 void drawOutline(u32 x, u32 y, u16 w, u16 h, u8 size, SDL_Color color);
 void drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, SDL_Color color);
 std::string trimToFit(const std::string& text, u32 maxsize, size_t textsize);
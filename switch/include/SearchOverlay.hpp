@@ -0,0 +1,54 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#ifndef SEARCHOVERLAY_HPP
+#define SEARCHOVERLAY_HPP
+
+#include "KeyboardManager.hpp"
+#include "Overlay.hpp"
+#include "SDLHelper.hpp"
+#include "colors.hpp"
+#include "title.hpp"
+#include "util.hpp"
+#include <functional>
+#include <string>
+
+// filters the title list while typing. The inline keyboard reports every change of the text, the title grid below shows the
+// matching titles right away. Without the inline keyboard, the full screen one asks for the whole query at once
+class SearchOverlay : public Overlay {
+public:
+    SearchOverlay(Screen& screen, const std::function<void()>& callbackChanged);
+    ~SearchOverlay(void);
+    void draw(void) const override;
+    void update(touchPosition* touch) override;
+
+private:
+    SwkbdInline keyboard;
+    bool inlineKeyboard;
+    std::string previous;
+    std::function<void()> changedFunc;
+};
+
+#endif
@@ -29,9 +29,10 @@
 
 #include "io.hpp"
 #include "json.hpp"
+#include "snapshot.hpp"
 #include "util.hpp"
-#include <unordered_map>
-#include <unordered_set>
+#include <poll.h>
+#include <atomic>
 #include <vector>
 extern "C" {
 #include "mongoose.h"
@@ -51,13 +52,19 @@ public:
     bool favorite(u64 id);
     bool isPKSMBridgeEnabled(void);
     bool isFTPEnabled(void);
-    std::vector<std::string> additionalSaveFolders(u64 id);
+    // valid until the application exits, reloads do not free the folders handed out before
+    Span<std::string> additionalSaveFolders(u64 id);
+    // appends the config server sockets and returns the ms until its next timer, -1 if there is none
+    int serverPollfds(std::vector<struct pollfd>& fds);
+    // handles whatever is ready without blocking
     void pollServer(void);
     void save(void);
     void load(void);
     void parse(void);
     const char* c_str(void);
     nlohmann::json getJson(void);
+    // changes every time the configuration is parsed, after the new values are visible
+    u32 generation(void);
 
     const std::string BASEPATH = "/switch/Checkpoint/config.json";
 
@@ -70,11 +77,17 @@ private:
     Configuration(Configuration const&) = delete;
     void operator=(Configuration const&) = delete;
 
+    // everything the ui thread reads, compiled from the json every time it is parsed
+    struct Snapshot {
+        IdSet filterIds, favoriteIds;
+        FolderTable<std::string> additionalSaveFolders;
+        bool PKSMBridgeEnabled;
+        bool FTPEnabled;
+    };
+
     nlohmann::json mJson;
-    bool PKSMBridgeEnabled;
-    bool FTPEnabled;
-    std::unordered_set<u64> mFilterIds, mFavoriteIds;
-    std::unordered_map<u64, std::vector<std::string>> mAdditionalSaveFolders;
+    std::atomic<u32> mGeneration;
+    SnapshotHolder<Snapshot> mSnapshot;
 };
 
 #endif
\ No newline at end of file
@@ -33,6 +33,8 @@
 namespace FileSystem {
     Result mount(FsFileSystem* fileSystem, u64 titleID, AccountUid userID);
     int mount(FsFileSystem fs);
+    // bytes the save can hold uncommitted, 0 when unknown
+    s64 journalSize(u64 titleID, AccountUid userID);
     void unmount(void);
 }
 
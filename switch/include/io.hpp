@@ -46,8 +46,9 @@ namespace io {
     std::tuple<bool, Result, std::string> backup(size_t index, AccountUid uid, size_t cellIndex);
     std::tuple<bool, Result, std::string> restore(size_t index, AccountUid uid, size_t cellIndex, const std::string& nameFromCell);
 
+    // both stop at the first error. Writes to save:/ are not committed, the caller commits the device once at the end
     Result copyDirectory(const std::string& srcPath, const std::string& dstPath);
-    void copyFile(const std::string& srcPath, const std::string& dstPath);
+    Result copyFile(const std::string& srcPath, const std::string& dstPath);
     Result createDirectory(const std::string& path);
     Result deleteFolderRecursively(const std::string& path);
     bool directoryExists(const std::string& path);
@@ -31,6 +31,7 @@
 #include "account.hpp"
 #include "title.hpp"
 #include "util.hpp"
+#include <atomic>
 #include <memory>
 #include <switch.h>
 
@@ -51,4 +52,7 @@ inline sort_t g_sortMode = SORT_ALPHA;
 inline std::string g_currentFile = "";
 inline bool g_isTransferringFile = false;
 
+// set by the config server when an upload created backups, the ui thread rescans the backup folders
+inline std::atomic<bool> g_backupsChanged = false;
+
 #endif
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include "KeyboardManager.hpp"
 #include "account.hpp"
 #include "title.hpp"
+#include "transfer.hpp"
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netinet/in.h>
@@ -40,6 +41,12 @@
 #include <utility>
 
 #define PKSM_PORT 34567
+// upper bound for a received save, the actual size comes from the transfer header
+#define PKSM_MAX_SIZE 0x1000000
+// connections made for a single send before giving up
+#define PKSM_ATTEMPTS 3
+// received saves are staged here until verified, away from the backups so that a restore never picks them up
+#define PKSM_STAGING_PATH "sdmc:/switch/Checkpoint/transfers"
 
 bool isPKSMBridgeTitle(u64 id);
 std::tuple<bool, Result, std::string> sendToPKSMBrigde(size_t index, AccountUid uid, size_t cellIndex);
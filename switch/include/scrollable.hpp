@@ -43,12 +43,13 @@ public:
 
     void draw(bool condition = false) override;
     void setIndex(size_t i);
-    void push_back(SDL_Color color, SDL_Color colorMessage, const std::string& message, bool selected) override;
     void resetIndex(void) override;
     void updateSelection(void) override;
     void text(size_t i, const std::string& v);
 
 protected:
+    IClickable<SDL_Color>* newCell(size_t i) override;
+
     Hid<HidDirection::VERTICAL, HidDirection::HORIZONTAL> mHid;
 };
 
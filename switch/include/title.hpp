@@ -33,6 +33,7 @@
 #include "filesystem.hpp"
 #include "io.hpp"
 #include <algorithm>
+#include <atomic>
 #include <stdlib.h>
 #include <string>
 #include <switch.h>
@@ -45,25 +46,25 @@ public:
     void init(u8 saveDataType, u64 titleid, AccountUid userID, const std::string& name, const std::string& author);
     ~Title(void){};
 
-    std::string author(void);
-    std::pair<std::string, std::string> displayName(void);
-    SDL_Texture* icon(void);
-    u64 id(void);
-    std::string name(void);
-    std::string path(void);
-    u32 playTimeMinutes(void);
-    std::string playTime(void);
+    std::string author(void) const;
+    std::pair<std::string, std::string> displayName(void) const;
+    SDL_Texture* icon(void) const;
+    u64 id(void) const;
+    std::string name(void) const;
+    std::string path(void) const;
+    u32 playTimeMinutes(void) const;
+    std::string playTime(void) const;
     void playTimeMinutes(u32 playTimeMinutes);
-    u32 lastPlayedTimestamp(void);
+    u32 lastPlayedTimestamp(void) const;
     void lastPlayedTimestamp(u32 lastPlayedTimestamp);
-    std::string fullPath(size_t index);
+    std::string fullPath(size_t index) const;
     void refreshDirectories(void);
-    u64 saveId();
+    u64 saveId() const;
     void saveId(u64 id);
-    std::vector<std::string> saves(void);
-    u8 saveDataType(void);
-    AccountUid userId(void);
-    std::string userName(void);
+    std::vector<std::string> saves(void) const;
+    u8 saveDataType(void) const;
+    AccountUid userId(void) const;
+    std::string userName(void) const;
 
 private:
     u64 mId;
@@ -83,14 +84,27 @@ private:
 };
 
 void getTitle(Title& dst, AccountUid uid, size_t i);
+// the title shown at i without copying it, valid until the title list changes
+const Title* titleAt(AccountUid uid, size_t i);
 size_t getTitleCount(AccountUid uid);
 void loadTitles(void);
 void sortTitles(void);
 void rotateSortMode(void);
+// narrows the titles seen through getTitle and the other accessors, an empty query shows all of them
+void setTitleFilter(const std::string& query);
+std::string getTitleFilter(void);
 void refreshDirectories(u64 id);
 bool favorite(AccountUid uid, int i);
 void freeIcons(void);
+// turns a full icon loaded in the background into a texture, true when one arrived and the screen should be redrawn
+bool pollFullIcons(void);
 SDL_Texture* smallIcon(AccountUid uid, size_t i);
+// both read the list published by the last loadTitles, they are safe to call from the network thread
 std::unordered_map<std::string, std::string> getCompleteTitleList(void);
+std::unordered_map<u64, std::string> getTitleBackupPaths(void);
+// changes every time the title list is reloaded
+u32 getTitlesGeneration(void);
+// changes every time the backup list of a title is refreshed
+u32 getDirectoriesGeneration(void);
 
 #endif
\ No newline at end of file
@@ -55,16 +55,17 @@ CheatManagerOverlay::CheatManagerOverlay(Screen& screen, const std::string& mkey
     size_t i     = 0;
     currentIndex = i;
     scrollable   = std::make_shared<Scrollable>(90, 20, 1100, 640, 16);
-    auto cheats  = *CheatManager::getInstance().cheats().get();
-    for (auto it = cheats[key].begin(); it != cheats[key].end(); ++it) {
-        std::string buildid = it.key();
-        for (auto it2 = cheats[key][buildid].begin(); it2 != cheats[key][buildid].end(); ++it2) {
-            std::string value = it2.key();
-            if (existingCheat.find(value) != std::string::npos) {
-                value = SELECTED_MAGIC + value;
+    auto cheats  = CheatManager::getInstance().cheats(key);
+    if (cheats != nullptr) {
+        for (u32 build = 0; build < cheats->builds(); build++) {
+            for (u32 j = 0; j < cheats->cheats(build); j++) {
+                std::string value = cheats->cheatName(build, j);
+                if (existingCheat.find(value) != std::string::npos) {
+                    value = SELECTED_MAGIC + value;
+                }
+                scrollable->push_back(COLOR_GREY_DARKER, COLOR_WHITE, value, i == 0);
+                i++;
             }
-            scrollable->push_back(COLOR_GREY_DARKER, COLOR_WHITE, value, i == 0);
-            i++;
         }
     }
 }
@@ -40,6 +40,10 @@ MainScreen::MainScreen() : hid(rowlen * collen, collen)
     buttonBackup->canChangeColorWhenSelected(true);
     buttonRestore->canChangeColorWhenSelected(true);
     buttonCheats->canChangeColorWhenSelected(true);
+
+    // generations start at 0 and are bumped by the first refresh, so this never matches a loaded title
+    backupListKey   = std::make_tuple(AccountUid{}, 0, 0);
+    backupListIndex = 0;
 }
 
 int MainScreen::selectorX(size_t i) const
@@ -102,25 +106,39 @@ void MainScreen::draw() const
         SDLH_DrawRect(x, y, 124, 124, COLOR_WHITEMASK);
     }
 
-    if (getTitleCount(g_currentUId) > 0) {
-        Title title;
-        getTitle(title, g_currentUId, hid.fullIndex());
+    const Title* title = titleAt(g_currentUId, hid.fullIndex());
+    if (title != nullptr) {
 
-        backupList->flush();
-        std::vector<std::string> dirs = title.saves();
+        // the list is only rebuilt when the title or its backups change, otherwise only the selection moves
+        const auto listKey = std::make_tuple(g_currentUId, title->id(), getDirectoriesGeneration());
+        if (listKey != backupListKey) {
+            backupListKey = listKey;
+            backupList->flush();
+            std::vector<std::string> dirs = title->saves();
 
-        for (size_t i = 0; i < dirs.size(); i++) {
-            backupList->push_back(theme().c2, theme().c6, dirs.at(i), i == backupList->index());
+            for (size_t i = 0; i < dirs.size(); i++) {
+                backupList->push_back(theme().c2, theme().c6, dirs.at(i), i == backupList->index());
+            }
+            backupListIndex = backupList->index();
+        }
+        else if (backupListIndex != backupList->index()) {
+            if (backupListIndex < backupList->size()) {
+                backupList->selectRow(backupListIndex, false);
+            }
+            if (backupList->index() < backupList->size()) {
+                backupList->selectRow(backupList->index(), true);
+            }
+            backupListIndex = backupList->index();
         }
 
-        if (title.icon() != NULL) {
+        if (title->icon() != NULL) {
             drawOutline(1018, 6, 256, 256, 4, theme().c3);
-            SDLH_DrawImage(title.icon(), 1018, 6);
+            SDLH_DrawImageScale(title->icon(), 1018, 6, 256, 256);
         }
 
         // draw infos
         u32 title_w, title_h, h, titleid_w, producer_w, user_w, subtitle_w, playtime_w;
-        auto displayName = title.displayName();
+        auto displayName = title->displayName();
         SDLH_GetTextDimensions(28, displayName.first.c_str(), &title_w, &title_h);
         SDLH_GetTextDimensions(23, "Title: ", &subtitle_w, NULL);
         SDLH_GetTextDimensions(23, "Title ID: ", &titleid_w, &h);
@@ -135,7 +153,7 @@ void MainScreen::draw() const
         u8 boxRows = (displayName.second.length() > 0 ? 4 : 3);
 
         h += 6;
-        if (!title.playTime().empty()) {
+        if (!title->playTime().empty()) {
             boxRows++;
             SDLH_GetTextDimensions(23, "Play Time: ", &playtime_w, NULL);
         }
@@ -154,17 +172,17 @@ void MainScreen::draw() const
 
         SDLH_DrawText(23, 538, offset + h * i, theme().c5, "Title ID:");
         SDLH_DrawTextBox(
-            23, 538 + titleid_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - titleid_w, StringUtils::format("%016llX", title.id()).c_str());
+            23, 538 + titleid_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - titleid_w, StringUtils::format("%016llX", title->id()).c_str());
 
         SDLH_DrawText(23, 538, offset + h * i, theme().c5, "Author:");
-        SDLH_DrawTextBox(23, 538 + producer_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - producer_w, title.author().c_str());
+        SDLH_DrawTextBox(23, 538 + producer_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - producer_w, title->author().c_str());
 
         SDLH_DrawText(23, 538, offset + h * i, theme().c5, "User:");
-        SDLH_DrawTextBox(23, 538 + user_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - user_w, title.userName().c_str());
+        SDLH_DrawTextBox(23, 538 + user_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - user_w, title->userName().c_str());
 
-        if (!title.playTime().empty()) {
+        if (!title->playTime().empty()) {
             SDLH_DrawText(23, 538, offset + h * i, theme().c5, "Play Time:");
-            SDLH_DrawTextBox(23, 538 + playtime_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - playtime_w, title.playTime().c_str());
+            SDLH_DrawTextBox(23, 538 + playtime_w, offset + h * (i++), theme().c6, 478 - 4 * 2 - playtime_w, title->playTime().c_str());
         }
 
         drawOutline(538, 276, 414, 380, 4, theme().c3);
@@ -174,7 +192,9 @@ void MainScreen::draw() const
         backupList->draw(g_backupScrollEnabled);
         buttonBackup->draw(30, COLOR_NULL);
         buttonRestore->draw(30, COLOR_NULL);
-        buttonCheats->draw(30, COLOR_NULL);
+        if (CheatManager::getInstance().loaded()) {
+            buttonCheats->draw(30, COLOR_NULL);
+        }
     }
 
     SDL_Color lightBlack = FC_MakeColor(theme().c0.r + 20, theme().c0.g + 20, theme().c0.b + 20, 255);
@@ -195,9 +215,10 @@ void MainScreen::draw() const
         SDLH_DrawText(24, 100, 390, theme().c6, "\ue002 to change sort mode");
         SDLH_DrawText(24, 100, 420, theme().c6, "\ue003 to multiselect title");
         SDLH_DrawText(24, 100, 450, theme().c6, "Hold \ue003 to select all titles");
+        SDLH_DrawText(24, 100, 480, theme().c6, "Hold \ue046 and press \ue003 to search titles");
         SDLH_DrawText(24, 616, 480, theme().c6, "\ue002 to delete a backup");
         if (Configuration::getInstance().isPKSMBridgeEnabled()) {
-            SDLH_DrawText(24, 100, 480, theme().c6, "\ue004 + \ue005 to enable PKSM bridge");
+            SDLH_DrawText(24, 100, 510, theme().c6, "\ue004 + \ue005 to enable PKSM bridge");
         }
         if (gethostid() != INADDR_LOOPBACK) {
             if (g_ftpAvailable && Configuration::getInstance().isFTPEnabled()) {
@@ -214,6 +235,14 @@ void MainScreen::draw() const
     SDLH_DrawText(20, 16 + checkpoint_w + 8, 672 + (40 - checkpoint_h) / 2 + checkpoint_h - ver_h, theme().c6, ver);
     SDLH_DrawText(24, 16 * 3 + checkpoint_w + 8 + ver_w, 672 + (40 - checkpoint_h) / 2 + checkpoint_h - inst_h, theme().c6, "\ue046 Instructions");
 
+    const std::string filter = getTitleFilter();
+    if (!filter.empty() && currentOverlay == nullptr) {
+        const std::string search = "Search: " + filter;
+        u32 search_w;
+        SDLH_GetTextDimensions(24, search.c_str(), &search_w, NULL);
+        SDLH_DrawText(24, 1280 - SIDEBAR_w - 16 - search_w, 672 + (40 - checkpoint_h) / 2 + checkpoint_h - inst_h, COLOR_GOLD, search.c_str());
+    }
+
     if (g_isTransferringFile) {
         SDLH_DrawRect(0, 0, 1280, 720, COLOR_OVERLAY);
 
@@ -265,6 +294,17 @@ void MainScreen::handleEvents(touchPosition* touch)
 {
     u32 kdown = hidKeysDown(CONTROLLER_P1_AUTO);
     u32 kheld = hidKeysHeld(CONTROLLER_P1_AUTO);
+    // the search starts from the title grid, positions and selections refer to the filtered list
+    if ((kheld & KEY_MINUS) && (kdown & KEY_Y) && !g_backupScrollEnabled) {
+        std::shared_ptr<Overlay> search = std::make_shared<SearchOverlay>(*this, [this]() {
+            this->index(TITLES, 0);
+            MS::clearSelectedEntries();
+            setPKSMBridgeFlag(false);
+            updateButtons();
+        });
+        setOverlay(search);
+        return;
+    }
     if (kdown & KEY_ZL || kdown & KEY_ZR) {
         while ((g_currentUId = Account::selectAccount()) == 0)
             ;
@@ -516,7 +556,7 @@ void MainScreen::handleEvents(touchPosition* touch)
         }
     }
 
-    if ((buttonCheats->released() || (hidKeysDown(CONTROLLER_P1_AUTO) & KEY_RSTICK)) && CheatManager::getInstance().cheats() != nullptr) {
+    if ((buttonCheats->released() || (hidKeysDown(CONTROLLER_P1_AUTO) & KEY_RSTICK)) && CheatManager::getInstance().loaded()) {
         if (MS::multipleSelectionEnabled()) {
             MS::clearSelectedEntries();
             updateButtons();
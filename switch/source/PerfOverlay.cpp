@@ -0,0 +1,51 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "PerfOverlay.hpp"
+
+void PerfOverlay::draw(void) const
+{
+    const Stats::Sample& sample = Stats::sample();
+    const std::string lines[]   = {StringUtils::format("%.1f ms (max %.1f ms)", sample.frameTime, sample.maxFrameTime),
+        StringUtils::format("%u draw calls", sample.drawCalls), StringUtils::format("Heap %.2f MB", sample.heapUsed / (1024.0f * 1024.0f)),
+        StringUtils::format("IO %.2f MB/s, %.0f files/s", sample.ioRate, sample.fileRate), StringUtils::format("Jobs %d", sample.jobs)};
+
+    u32 width = 0, height = 0;
+    for (const auto& line : lines) {
+        u32 w, h;
+        SDLH_GetTextDimensions(18, line.c_str(), &w, &h);
+        width  = std::max(width, w);
+        height = std::max(height, h);
+    }
+
+    const int n = sizeof(lines) / sizeof(lines[0]);
+    SDLH_DrawRect(1280 - width - 24, 72, width + 16, height * n + 8, COLOR_OVERLAY);
+    for (int i = 0; i < n; i++) {
+        SDLH_DrawText(18, 1280 - width - 16, 76 + height * i, COLOR_WHITE, lines[i].c_str());
+    }
+}
+
+void PerfOverlay::update(touchPosition* touch) {}
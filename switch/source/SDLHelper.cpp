@@ -1,12 +1,66 @@
 #include "SDLHelper.hpp"
+#include "image.hpp"
+#include "lrucache.hpp"
+#include "stats.hpp"
+#include "textlayout.hpp"
+#include "trace.hpp"
 
 static SDL_Window* s_window;
 static SDL_Renderer* s_renderer;
 static SDL_Texture* s_star;
 static SDL_Texture* s_checkbox;
 
+static SDL_Texture* s_cache;
+
+struct Animation {
+    u32 x, y;
+    u16 w, h;
+    u8 size;
+    SDL_Color color;
+};
+static std::vector<Animation> s_animations;
+static bool s_capturing = false;
+
 static PlFontData fontData, fontExtData;
 static std::unordered_map<int, FC_Font*> s_fonts;
+static std::unordered_map<int, TextLayout::GlyphTable> s_glyphs;
+
+// text is rendered once into a texture and blitted afterwards. max is the box width for wrapped text, 0 for a single line
+struct TextKey {
+    int size;
+    int max;
+    Uint32 color;
+    std::string text;
+
+    bool operator==(const TextKey& other) const
+    {
+        return size == other.size && max == other.max && color == other.color && text == other.text;
+    }
+};
+
+struct TextKeyHash {
+    size_t operator()(const TextKey& key) const
+    {
+        size_t hash = std::hash<std::string>()(key.text);
+        hash ^= std::hash<Uint32>()(key.color) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<int>()(key.size << 16 | key.max) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+};
+
+struct TextTexture {
+    SDL_Texture* texture;
+    int w, h;
+};
+
+// budgets: distinct strings for the dimensions, pixels for the textures
+static constexpr size_t TEXT_DIMENSIONS = 512;
+static constexpr size_t TEXT_PIXELS     = 1280 * 720;
+static constexpr u32 TEXT_MAX_SIDE      = 2048;
+
+static LruCache<TextKey, std::pair<u32, u32>, TextKeyHash> s_textDimensions(TEXT_DIMENSIONS);
+static LruCache<TextKey, TextTexture, TextKeyHash> s_textTextures(TEXT_PIXELS, [](TextTexture& text) { SDL_DestroyTexture(text.texture); });
+static SDL_BlendMode s_premultiplied;
 
 static FC_Font* getFontFromMap(int size)
 {
@@ -21,6 +75,69 @@ static FC_Font* getFontFromMap(int size)
     return got->second;
 }
 
+static TextLayout::GlyphTable& getGlyphsFromMap(int size)
+{
+    std::unordered_map<int, TextLayout::GlyphTable>::iterator got = s_glyphs.find(size);
+    if (got == s_glyphs.end()) {
+        FC_Font* font = getFontFromMap(size);
+        auto measure  = [font](uint32_t codepoint) -> uint16_t {
+            // same fallback as FC_GetWidth, glyphs missing from the font are measured as spaces
+            FC_GlyphData glyph;
+            if (FC_GetGlyphData(font, &glyph, codepoint) || FC_GetGlyphData(font, &glyph, ' ')) {
+                return glyph.rect.w;
+            }
+            return 0;
+        };
+        got = s_glyphs.emplace(size, TextLayout::GlyphTable(measure)).first;
+    }
+    return got->second;
+}
+
+static Uint32 packColor(SDL_Color color)
+{
+    return (Uint32)color.r << 24 | (Uint32)color.g << 16 | (Uint32)color.b << 8 | color.a;
+}
+
+// returns nullptr when the text can't be cached, callers draw it directly then
+static const TextTexture* getTextTexture(int size, int max, SDL_Color color, const char* text)
+{
+    TextKey key{size, max, packColor(color), text};
+    if (TextTexture* cached = s_textTextures.find(key)) {
+        return cached;
+    }
+
+    u32 w, h;
+    SDLH_GetTextDimensions(size, text, &w, &h);
+    if (max > 0) {
+        w = max;
+    }
+    if (w == 0 || h == 0 || w > TEXT_MAX_SIDE || h > TEXT_MAX_SIDE) {
+        return nullptr;
+    }
+
+    SDL_Texture* texture = SDL_CreateTexture(s_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (!texture) {
+        return nullptr;
+    }
+    // glyphs blended over transparent black leave premultiplied colors behind
+    SDL_SetTextureBlendMode(texture, s_premultiplied);
+
+    SDL_Texture* target = SDL_GetRenderTarget(s_renderer);
+    SDL_SetRenderTarget(s_renderer, texture);
+    SDL_SetRenderDrawColor(s_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(s_renderer);
+    FC_Font* font = getFontFromMap(size);
+    if (max > 0) {
+        FC_DrawBoxColor(font, s_renderer, FC_MakeRect(0, 0, w, h), color, text);
+    }
+    else {
+        FC_DrawColor(font, s_renderer, 0, 0, color, text);
+    }
+    SDL_SetRenderTarget(s_renderer, target);
+
+    return s_textTextures.insert(key, TextTexture{texture, (int)w, (int)h}, w * h);
+}
+
 bool SDLH_Init(void)
 {
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
@@ -32,14 +149,25 @@ bool SDLH_Init(void)
         Logger::getInstance().log(Logger::ERROR, "SDL_CreateWindow: %s.", SDL_GetError());
         return false;
     }
-    s_renderer = SDL_CreateRenderer(s_window, 0, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    s_renderer = SDL_CreateRenderer(s_window, 0, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
     if (!s_renderer) {
         Logger::getInstance().log(Logger::ERROR, "SDL_CreateRenderer: %s.", SDL_GetError());
         return false;
     }
     SDL_SetRenderDrawBlendMode(s_renderer, SDL_BLENDMODE_BLEND);
+    s_premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "2");
 
+    // without the cache, every frame is drawn from scratch
+    s_cache = SDL_CreateTexture(s_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, 1280, 720);
+    if (s_cache) {
+        SDL_SetTextureBlendMode(s_cache, SDL_BLENDMODE_NONE);
+    }
+    else {
+        Logger::getInstance().log(Logger::WARN, "SDL_CreateTexture: %s. Frames won't be cached.", SDL_GetError());
+    }
+
     const int img_flags = IMG_INIT_PNG | IMG_INIT_JPG;
     if ((IMG_Init(img_flags) & img_flags) != img_flags) {
         Logger::getInstance().log(Logger::ERROR, "IMG_Init: %s.", IMG_GetError());
@@ -60,6 +188,7 @@ bool SDLH_Init(void)
 
 void SDLH_Exit(void)
 {
+    s_textTextures.clear();
     for (auto& value : s_fonts) {
         FC_FreeFont(value.second);
     }
@@ -67,6 +196,9 @@ void SDLH_Exit(void)
     TTF_Quit();
     SDL_DestroyTexture(s_star);
     SDL_DestroyTexture(s_checkbox);
+    if (s_cache) {
+        SDL_DestroyTexture(s_cache);
+    }
     IMG_Quit();
     SDL_DestroyRenderer(s_renderer);
     SDL_DestroyWindow(s_window);
@@ -75,18 +207,53 @@ void SDLH_Exit(void)
 
 void SDLH_ClearScreen(SDL_Color color)
 {
+    Stats::drawCall();
     SDL_SetRenderDrawColor(s_renderer, color.r, color.g, color.b, color.a);
     SDL_RenderClear(s_renderer);
 }
 
 void SDLH_Render(void)
 {
+    TRACE_SCOPE("SDLH_Render");
+    Stats::frameEnd();
     g_currentTime = SDL_GetTicks() / 1000.f;
     SDL_RenderPresent(s_renderer);
 }
 
+bool SDLH_HasCache(void)
+{
+    return s_cache != nullptr;
+}
+
+void SDLH_BeginCache(void)
+{
+    if (s_cache) {
+        s_animations.clear();
+        s_capturing = true;
+        SDL_SetRenderTarget(s_renderer, s_cache);
+    }
+}
+
+void SDLH_DropAnimations(void)
+{
+    s_animations.clear();
+}
+
+void SDLH_DrawCache(void)
+{
+    if (s_cache) {
+        s_capturing = false;
+        SDL_SetRenderTarget(s_renderer, NULL);
+        SDL_RenderCopy(s_renderer, s_cache, NULL, NULL);
+        for (const auto& animation : s_animations) {
+            drawPulsingOutline(animation.x, animation.y, animation.w, animation.h, animation.size, animation.color);
+        }
+    }
+}
+
 void SDLH_DrawRect(int x, int y, int w, int h, SDL_Color color)
 {
+    Stats::drawCall();
     SDL_Rect rect;
     rect.x = x;
     rect.y = y;
@@ -98,16 +265,53 @@ void SDLH_DrawRect(int x, int y, int w, int h, SDL_Color color)
 
 void SDLH_DrawText(int size, int x, int y, SDL_Color color, const char* text)
 {
-    FC_DrawColor(getFontFromMap(size), s_renderer, x, y, color, text);
+    Stats::drawCall();
+    if (const TextTexture* cached = getTextTexture(size, 0, color, text)) {
+        SDL_Rect position = {x, y, cached->w, cached->h};
+        SDL_RenderCopy(s_renderer, cached->texture, NULL, &position);
+    }
+    else {
+        FC_DrawColor(getFontFromMap(size), s_renderer, x, y, color, text);
+    }
 }
 
 void SDLH_DrawTextBox(int size, int x, int y, SDL_Color color, int max, const char* text)
 {
-    u32 h;
-    FC_Font* font = getFontFromMap(size);
-    SDLH_GetTextDimensions(size, text, NULL, &h);
-    FC_Rect rect = FC_MakeRect(x, y, max, h);
-    FC_DrawBoxColor(font, s_renderer, rect, color, text);
+    Stats::drawCall();
+    if (const TextTexture* cached = getTextTexture(size, max, color, text)) {
+        SDL_Rect position = {x, y, cached->w, cached->h};
+        SDL_RenderCopy(s_renderer, cached->texture, NULL, &position);
+    }
+    else {
+        u32 h;
+        FC_Font* font = getFontFromMap(size);
+        SDLH_GetTextDimensions(size, text, NULL, &h);
+        FC_Rect rect = FC_MakeRect(x, y, max, h);
+        FC_DrawBoxColor(font, s_renderer, rect, color, text);
+    }
+}
+
+// converts the image to RGBA8 once, turns black pixels transparent and uploads the result as a static texture
+static SDL_Texture* createKeyedTexture(SDL_Surface* surface)
+{
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (rgba == NULL) {
+        Logger::getInstance().log(Logger::ERROR, "SDL_ConvertSurfaceFormat: %s.", SDL_GetError());
+        return NULL;
+    }
+
+    u8* pixels = (u8*)rgba->pixels;
+    for (int y = 0; y < rgba->h; y++) {
+        Image::colorKey(pixels + y * rgba->pitch, rgba->w, 0, 0, 0);
+    }
+
+    SDL_Texture* texture = SDL_CreateTexture(s_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, rgba->w, rgba->h);
+    if (texture != NULL) {
+        SDL_UpdateTexture(texture, NULL, rgba->pixels, rgba->pitch);
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+    SDL_FreeSurface(rgba);
+    return texture;
 }
 
 void SDLH_LoadImage(SDL_Texture** texture, char* path)
@@ -116,9 +320,7 @@ void SDLH_LoadImage(SDL_Texture** texture, char* path)
     loaded_surface              = IMG_Load(path);
 
     if (loaded_surface) {
-        Uint32 colorkey = SDL_MapRGB(loaded_surface->format, 0, 0, 0);
-        SDL_SetColorKey(loaded_surface, SDL_TRUE, colorkey);
-        *texture = SDL_CreateTextureFromSurface(s_renderer, loaded_surface);
+        *texture = createKeyedTexture(loaded_surface);
     }
 
     SDL_FreeSurface(loaded_surface);
@@ -130,16 +332,54 @@ void SDLH_LoadImage(SDL_Texture** texture, u8* buff, size_t size)
     loaded_surface              = IMG_Load_RW(SDL_RWFromMem(buff, size), 1);
 
     if (loaded_surface) {
-        Uint32 colorkey = SDL_MapRGB(loaded_surface->format, 0, 0, 0);
-        SDL_SetColorKey(loaded_surface, SDL_TRUE, colorkey);
-        *texture = SDL_CreateTextureFromSurface(s_renderer, loaded_surface);
+        *texture = createKeyedTexture(loaded_surface);
+    }
+
+    SDL_FreeSurface(loaded_surface);
+}
+
+SDL_Surface* SDLH_DecodeImage(u8* buff, size_t size)
+{
+    SDL_Surface* loaded_surface = IMG_Load_RW(SDL_RWFromMem(buff, size), 1);
+    if (loaded_surface == NULL) {
+        return NULL;
     }
 
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded_surface, SDL_PIXELFORMAT_RGBA32, 0);
     SDL_FreeSurface(loaded_surface);
+    if (rgba == NULL) {
+        Logger::getInstance().log(Logger::ERROR, "SDL_ConvertSurfaceFormat: %s.", SDL_GetError());
+    }
+    return rgba;
+}
+
+bool SDLH_DecodeThumbnail(u8* buff, size_t size, u8* pixels, int side)
+{
+    SDL_Surface* rgba = SDLH_DecodeImage(buff, size);
+    if (rgba == NULL) {
+        return false;
+    }
+
+    const bool fits = rgba->w == rgba->h && rgba->w >= side && rgba->w % side == 0;
+    if (fits) {
+        Image::downscale(pixels, side * 4, (const u8*)rgba->pixels, rgba->pitch, rgba->w, rgba->h, rgba->w / side);
+    }
+    SDL_FreeSurface(rgba);
+    return fits;
+}
+
+SDL_Texture* SDLH_CreateTextureRGBA(const u8* pixels, int w, int h, int pitch)
+{
+    SDL_Texture* texture = SDL_CreateTexture(s_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, w, h);
+    if (texture != NULL) {
+        SDL_UpdateTexture(texture, NULL, pixels, pitch);
+    }
+    return texture;
 }
 
 void SDLH_DrawImage(SDL_Texture* texture, int x, int y)
 {
+    Stats::drawCall();
     SDL_Rect position;
     position.x = x;
     position.y = y;
@@ -149,6 +389,7 @@ void SDLH_DrawImage(SDL_Texture* texture, int x, int y)
 
 void SDLH_DrawImageScale(SDL_Texture* texture, int x, int y, int w, int h)
 {
+    Stats::drawCall();
     SDL_Rect position;
     position.x = x;
     position.y = y;
@@ -159,11 +400,16 @@ void SDLH_DrawImageScale(SDL_Texture* texture, int x, int y, int w, int h)
 
 void SDLH_GetTextDimensions(int size, const char* text, u32* w, u32* h)
 {
-    FC_Font* f = getFontFromMap(size);
+    TextKey key{size, 0, 0, text};
+    std::pair<u32, u32>* dimensions = s_textDimensions.find(key);
+    if (dimensions == nullptr) {
+        FC_Font* f = getFontFromMap(size);
+        dimensions = s_textDimensions.insert(key, {FC_GetWidth(f, text), FC_GetHeight(f, text)});
+    }
     if (w != NULL)
-        *w = FC_GetWidth(f, text);
+        *w = dimensions->first;
     if (h != NULL)
-        *h = FC_GetHeight(f, text);
+        *h = dimensions->second;
 }
 
 void SDLH_DrawIcon(std::string icon, int x, int y)
@@ -192,6 +438,9 @@ void drawOutline(u32 x, u32 y, u16 w, u16 h, u8 size, SDL_Color color)
 
 void drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, SDL_Color color)
 {
+    if (s_capturing) {
+        s_animations.push_back({x, y, w, h, size, color});
+    }
     float highlight_multiplier = fmax(0.0, fabs(fmod(g_currentTime, 1.0) - 0.5) / 0.5);
     color                      = FC_MakeColor(color.r + (255 - color.r) * highlight_multiplier, color.g + (255 - color.g) * highlight_multiplier,
         color.b + (255 - color.b) * highlight_multiplier, 255);
@@ -200,17 +449,6 @@ void drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, SDL_Color color)
 
 std::string trimToFit(const std::string& text, u32 maxsize, size_t textsize)
 {
-    u32 width;
-    std::string newtext = "";
-    for (size_t i = 0, len = text.length(); i < len; i++) {
-        SDLH_GetTextDimensions(textsize, newtext.c_str(), &width, NULL);
-        if (width < maxsize) {
-            newtext += text[i];
-        }
-        else {
-            newtext += "...";
-            break;
-        }
-    }
-    return newtext;
+    // measured up to the first nul, like SDL_FontCache draws it
+    return TextLayout::ellipsize(getGlyphsFromMap(textsize), text.c_str(), 1.0f, maxsize);
 }
\ No newline at end of file
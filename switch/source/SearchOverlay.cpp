@@ -0,0 +1,130 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+#include "SearchOverlay.hpp"
+
+// the keyboard callbacks carry no user data, only one search is open at a time
+static std::string s_query;
+static bool s_changed   = false;
+static bool s_finished  = false;
+static bool s_cancelled = false;
+
+static void changedString(const char* str, SwkbdChangedStringArg* arg)
+{
+    s_query   = str;
+    s_changed = true;
+}
+
+static void decidedEnter(const char* str, SwkbdDecidedEnterArg* arg)
+{
+    s_query    = str;
+    s_changed  = true;
+    s_finished = true;
+}
+
+static void decidedCancel(void)
+{
+    s_finished  = true;
+    s_cancelled = true;
+}
+
+SearchOverlay::SearchOverlay(Screen& screen, const std::function<void()>& callbackChanged) : Overlay(screen)
+{
+    changedFunc = callbackChanged;
+    previous    = getTitleFilter();
+    s_query     = previous;
+    s_changed   = false;
+    s_finished  = false;
+    s_cancelled = false;
+
+    inlineKeyboard = KeyboardManager::get().isSystemKeyboardAvailable().first && R_SUCCEEDED(swkbdInlineCreate(&keyboard));
+    if (inlineKeyboard && R_FAILED(swkbdInlineLaunchForLibraryApplet(&keyboard, SwkbdInlineMode_AppletDisplay, 0))) {
+        swkbdInlineClose(&keyboard);
+        inlineKeyboard = false;
+    }
+    if (inlineKeyboard) {
+        swkbdInlineSetChangedStringCallback(&keyboard, changedString);
+        swkbdInlineSetDecidedEnterCallback(&keyboard, decidedEnter);
+        swkbdInlineSetDecidedCancelCallback(&keyboard, decidedCancel);
+        swkbdInlineSetInputText(&keyboard, s_query.c_str());
+        swkbdInlineSetCursorPos(&keyboard, s_query.length());
+
+        SwkbdAppearArg arg;
+        swkbdInlineMakeAppearArg(&arg, SwkbdType_Normal);
+        swkbdInlineAppear(&keyboard, &arg);
+    }
+}
+
+SearchOverlay::~SearchOverlay(void)
+{
+    if (inlineKeyboard) {
+        swkbdInlineClose(&keyboard);
+    }
+}
+
+void SearchOverlay::draw(void) const
+{
+    const size_t count      = getTitleCount(g_currentUId);
+    const std::string text  = s_query.empty() ? "Search titles" : s_query;
+    const std::string found = StringUtils::format("%zu titles", count);
+
+    u32 text_h, found_w;
+    SDLH_GetTextDimensions(24, text.c_str(), NULL, &text_h);
+    SDLH_GetTextDimensions(24, found.c_str(), &found_w, NULL);
+
+    SDLH_DrawRect(0, 0, 532, 16 + text_h, theme().c3);
+    SDLH_DrawTextBox(24, 12, 8, s_query.empty() ? theme().c5 : theme().c6, 532 - found_w - 36, text.c_str());
+    SDLH_DrawText(24, 532 - found_w - 12, 8, theme().c5, found.c_str());
+}
+
+void SearchOverlay::update(touchPosition* touch)
+{
+    if (inlineKeyboard) {
+        swkbdInlineUpdate(&keyboard, NULL);
+    }
+    else {
+        auto result = KeyboardManager::get().keyboard(s_query);
+        if (result.first) {
+            s_query   = result.second;
+            s_changed = true;
+        }
+        s_finished = true;
+    }
+
+    if (s_cancelled) {
+        s_query   = previous;
+        s_changed = true;
+    }
+    if (s_changed && s_query != getTitleFilter()) {
+        setTitleFilter(s_query);
+        changedFunc();
+        screen.markDirty();
+    }
+    s_changed = false;
+
+    if (s_finished) {
+        screen.removeOverlay();
+    }
+}
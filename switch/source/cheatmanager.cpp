@@ -25,89 +25,73 @@
  */
 
 #include "cheatmanager.hpp"
+#include "trace.hpp"
 
 CheatManager::CheatManager(void)
 {
-    mCheats = nullptr;
-    if (io::fileExists("/switch/Checkpoint/cheats.json")) {
-        const std::string path = "/switch/Checkpoint/cheats.json";
-        FILE* in               = fopen(path.c_str(), "rt");
-        if (in != NULL) {
-            mCheats = std::make_shared<nlohmann::json>(nlohmann::json::parse(in, nullptr, false));
-            fclose(in);
-        }
-        else {
-            Logger::getInstance().log(Logger::WARN, "Failed to open " + path + " with errno %d.", errno);
-        }
-    }
-    else {
-        const std::string path = "romfs:/cheats/cheats.json.bz2";
-        // load compressed archive in memory
-        FILE* f = fopen(path.c_str(), "rb");
-        if (f != NULL) {
-            fseek(f, 0, SEEK_END);
-            u32 size             = ftell(f);
-            unsigned int destLen = CHEAT_SIZE_DECOMPRESSED;
-            char* s              = new char[size];
-            char* d              = new char[destLen]();
-            rewind(f);
-            fread(s, 1, size, f);
+    mLoaded = false;
+}
 
-            int r = BZ2_bzBuffToBuffDecompress(d, &destLen, s, size, 0, 0);
-            if (r == BZ_OK) {
-                mCheats = std::make_shared<nlohmann::json>(nlohmann::json::parse(d));
-            }
+void CheatManager::load(void)
+{
+    TRACE_SCOPE("CheatManager::load");
+    if (mLoaded) {
+        return;
+    }
 
-            delete[] s;
-            delete[] d;
-            fclose(f);
-        }
-        else {
-            Logger::getInstance().log(Logger::WARN, "Failed to open " + path + " with errno %d.", errno);
-        }
+    const std::string path = "/switch/Checkpoint/cheats.json";
+    if (io::fileExists(path)) {
+        mLoaded = mDatabase.loadJson(path);
+    }
+    else {
+        mLoaded = mDatabase.load("romfs:/cheats/cheats.db");
     }
 }
 
 bool CheatManager::areCheatsAvailable(const std::string& key)
 {
-    return mCheats->find(key) != mCheats->end();
+    return mLoaded && mDatabase.contains(strtoull(key.c_str(), NULL, 16));
+}
+
+std::shared_ptr<CheatBlock> CheatManager::cheats(const std::string& key)
+{
+    if (!mLoaded) {
+        return nullptr;
+    }
+    if (mBlock == nullptr || mBlockKey != key) {
+        // only the requested title gets decompressed
+        mBlock    = mDatabase.block(strtoull(key.c_str(), NULL, 16));
+        mBlockKey = key;
+    }
+    return mBlock;
 }
 
 void CheatManager::save(const std::string& key, const std::vector<std::string>& s)
 {
     static size_t MAGIC_LEN = strlen(SELECTED_MAGIC);
 
+    auto cheats = CheatManager::getInstance().cheats(key);
+    if (cheats == nullptr) {
+        return;
+    }
+
+    std::unordered_set<std::string_view> selected;
+    for (auto& cellName : s) {
+        if (cellName.compare(0, MAGIC_LEN, SELECTED_MAGIC) == 0) {
+            selected.insert(std::string_view(cellName).substr(MAGIC_LEN));
+        }
+    }
+
     std::string idfolder   = StringUtils::format("/atmosphere/contents/%s", key.c_str());
     std::string rootfolder = idfolder + "/cheats";
     mkdir(idfolder.c_str(), 777);
     mkdir(rootfolder.c_str(), 777);
 
-    auto cheats = *CheatManager::getInstance().cheats().get();
-    for (auto it = cheats[key].begin(); it != cheats[key].end(); ++it) {
-        std::string buildid   = it.key();
-        std::string cheatFile = "";
-        for (size_t i = 0; i < s.size(); i++) {
-            std::string cellName = s.at(i);
-            if (cellName.compare(0, MAGIC_LEN, SELECTED_MAGIC) == 0) {
-                cellName = cellName.substr(strlen(SELECTED_MAGIC), cellName.length());
-                if (cheats[key][buildid].find(cellName) != cheats[key][buildid].end()) {
-                    cheatFile += "[" + cellName + "]\n";
-                    for (auto& it2 : cheats[key][buildid][cellName]) {
-                        cheatFile += it2.get<std::string>() + "\n";
-                    }
-                    cheatFile += "\n";
-                }
-            }
-        }
-
-        std::string outPath = rootfolder + "/" + buildid + ".txt";
-        FILE* f             = fopen(outPath.c_str(), "w");
-        if (f != NULL) {
-            fwrite(cheatFile.c_str(), 1, cheatFile.length(), f);
-            fclose(f);
-        }
-        else {
+    // every build id is written in a single pass over the block
+    for (u32 build = 0; build < cheats->builds(); build++) {
+        std::string outPath = rootfolder + "/" + cheats->buildId(build) + ".txt";
+        if (!cheats->save(outPath, build, selected)) {
             Logger::getInstance().log(Logger::ERROR, "Failed to write " + outPath + " with errno %d.", errno);
         }
     }
-}
\ No newline at end of file
+}
@@ -25,22 +25,83 @@
  */
 
 #include "configuration.hpp"
+#include "directory.hpp"
+#include "hash.hpp"
+#include "main.hpp"
+#include "tar.hpp"
+#include <zlib.h>
 
 static struct mg_mgr mgr;
 static struct mg_connection* nc;
 static struct mg_serve_http_opts s_http_server_opts;
 static const char* s_http_port = "8000";
 
+// the populate body only changes with the title list or the configuration, it is serialized and compressed once per change
+struct PopulateCache {
+    u32 titles;
+    u32 config;
+    std::string body;
+    std::string gzip;
+    std::string etag;
+};
+
+static PopulateCache populateCache = {0, 0, "", "", ""};
+
+static std::string gzipCompress(const std::string& data)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 15 window bits plus 16 selects the gzip wrapper
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return "";
+    }
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in   = (Bytef*)data.data();
+    stream.avail_in  = data.size();
+    stream.next_out  = (Bytef*)&out[0];
+    stream.avail_out = out.size();
+    int res          = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return res == Z_STREAM_END ? out : "";
+}
+
+static const PopulateCache& populate(void)
+{
+    u32 titles = getTitlesGeneration();
+    u32 config = Configuration::getInstance().generation();
+    if (populateCache.body.empty() || populateCache.titles != titles || populateCache.config != config) {
+        auto json            = Configuration::getInstance().getJson();
+        json["title_list"]   = getCompleteTitleList();
+        populateCache.body   = json.dump();
+        populateCache.gzip   = gzipCompress(populateCache.body);
+        populateCache.etag   = StringUtils::format("\"%016llx\"", (unsigned long long)Hash::fast64(populateCache.body.data(), populateCache.body.size()));
+        populateCache.titles = titles;
+        populateCache.config = config;
+    }
+    return populateCache;
+}
+
 static void handle_populate(struct mg_connection* nc, struct http_message* hm)
 {
     // populate gets called at startup, assume a new connection has been started
     blinkLed(2);
 
-    auto json          = Configuration::getInstance().getJson();
-    auto map           = getCompleteTitleList();
-    json["title_list"] = map;
-    std::string body   = json.dump();
-    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: %lu\r\n\r\n%.*s", (unsigned long)body.length(), (int)body.length(), body.c_str());
+    const PopulateCache& cache = populate();
+    struct mg_str* match       = mg_get_http_header(hm, "If-None-Match");
+    if (match != NULL && mg_vcmp(match, cache.etag.c_str()) == 0) {
+        mg_printf(nc, "HTTP/1.1 304 Not Modified\r\nETag: %s\r\nCache-Control: no-cache\r\nContent-Length: 0\r\n\r\n", cache.etag.c_str());
+        return;
+    }
+
+    struct mg_str* encoding = mg_get_http_header(hm, "Accept-Encoding");
+    bool gzip               = encoding != NULL && !cache.gzip.empty() && mg_strstr(*encoding, mg_mk_str("gzip")) != NULL;
+    const std::string& body = gzip ? cache.gzip : cache.body;
+    mg_printf(nc,
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: %s\r\nCache-Control: no-cache\r\nVary: Accept-Encoding\r\n%s"
+        "Content-Length: %lu\r\n\r\n",
+        cache.etag.c_str(), gzip ? "Content-Encoding: gzip\r\n" : "", (unsigned long)body.length());
+    mg_send(nc, body.data(), body.length());
     Logger::getInstance().log(Logger::INFO, "A new Configuration connection has been handled.");
 }
 
@@ -61,6 +122,182 @@ static void handle_save(struct mg_connection* nc, struct http_message* hm)
     mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: %lu\r\n\r\n%.*s", (unsigned long)hm->body.len, (int)hm->body.len, hm->body.p);
 }
 
+static const size_t ARCHIVE_CHUNK_SIZE   = 0x4000;
+static const size_t ARCHIVE_SEND_BACKLOG = 0x10000;
+static const std::string SAVES_PATH      = "sdmc:/switch/Checkpoint/saves";
+// uploads are extracted in a folder of their own here, next to the backups so that moving them into place is a rename
+static const std::string UPLOADS_PATH = "sdmc:/switch/Checkpoint/uploads";
+static u32 uploads                    = 0;
+
+// per connection state of an archive download or upload, kept in mg_connection::user_data
+struct ArchiveStream {
+    std::unique_ptr<Tar::Writer> writer;
+    std::unique_ptr<Tar::Reader> reader;
+    int status;
+};
+
+static ArchiveStream* archiveStream(struct mg_connection* nc)
+{
+    if (nc->user_data == NULL) {
+        nc->user_data = new ArchiveStream{nullptr, nullptr, 0};
+    }
+    return (ArchiveStream*)nc->user_data;
+}
+
+static void sendJson(struct mg_connection* nc, int code, const nlohmann::json& json)
+{
+    std::string body = json.dump();
+    mg_send_head(nc, code, body.length(), "Content-Type: application/json");
+    mg_send(nc, body.c_str(), body.length());
+}
+
+// a backup name is a single folder below the title folder
+static bool validBackupName(const std::string& name)
+{
+    return !name.empty() && name != "." && name != ".." && name.find('/') == std::string::npos;
+}
+
+// resolves the optional id query variable to a title backup folder, an empty id means the whole saves folder
+static bool backupRoot(struct http_message* hm, std::string& root)
+{
+    char id[32];
+    if (mg_get_http_var(&hm->query_string, "id", id, sizeof(id)) <= 0) {
+        root = SAVES_PATH;
+        return true;
+    }
+    auto paths = getTitleBackupPaths();
+    auto it    = paths.find(strtoull(id, NULL, 16));
+    if (it == paths.end()) {
+        return false;
+    }
+    root = it->second;
+    return true;
+}
+
+static void handle_titles(struct mg_connection* nc, struct http_message* hm)
+{
+    nlohmann::json list = nlohmann::json::array();
+    for (const auto& title : getCompleteTitleList()) {
+        list.push_back({{"id", title.first}, {"name", title.second}});
+    }
+    sendJson(nc, 200, list);
+}
+
+static void handle_backups(struct mg_connection* nc, struct http_message* hm)
+{
+    std::string root;
+    if (!backupRoot(hm, root)) {
+        sendJson(nc, 404, {{"error", "Unknown title."}});
+        return;
+    }
+    nlohmann::json list = nlohmann::json::array();
+    Directory dir(root);
+    for (size_t i = 0, sz = dir.good() ? dir.size() : 0; i < sz; i++) {
+        if (dir.folder(i)) {
+            list.push_back(dir.entry(i));
+        }
+    }
+    sendJson(nc, 200, list);
+}
+
+static void pumpArchive(struct mg_connection* nc)
+{
+    ArchiveStream* stream = (ArchiveStream*)nc->user_data;
+    if (stream == NULL || !stream->writer) {
+        return;
+    }
+    // keep a bounded amount queued, the next MG_EV_SEND asks for more.
+    // the network thread has a small stack and is the only caller
+    static char buffer[ARCHIVE_CHUNK_SIZE];
+    while (nc->send_mbuf.len < ARCHIVE_SEND_BACKLOG) {
+        size_t n = stream->writer->read((uint8_t*)buffer, sizeof(buffer));
+        mg_send_http_chunk(nc, buffer, n);
+        if (n == 0) {
+            stream->writer.reset();
+            break;
+        }
+    }
+}
+
+static void handle_backup_download(struct mg_connection* nc, struct http_message* hm)
+{
+    std::string root;
+    if (!backupRoot(hm, root)) {
+        sendJson(nc, 404, {{"error", "Unknown title."}});
+        return;
+    }
+
+    // the archive layout matches what an upload to the same url expects
+    auto writer = std::make_unique<Tar::Writer>();
+    char name[256];
+    std::string filename;
+    if (mg_get_http_var(&hm->query_string, "name", name, sizeof(name)) > 0) {
+        if (!validBackupName(name) || !io::directoryExists(root + "/" + name)) {
+            sendJson(nc, 404, {{"error", "Unknown backup."}});
+            return;
+        }
+        writer->add(name, root + "/" + name);
+        filename = name;
+    }
+    else {
+        Directory dir(root);
+        for (size_t i = 0, sz = dir.good() ? dir.size() : 0; i < sz; i++) {
+            if (dir.folder(i)) {
+                writer->add(dir.entry(i), root + "/" + dir.entry(i));
+            }
+        }
+        filename = root.substr(root.find_last_of('/') + 1);
+    }
+    std::replace(filename.begin(), filename.end(), '"', '\'');
+
+    mg_printf(nc,
+        "HTTP/1.1 200 OK\r\nContent-Type: application/x-tar\r\nContent-Disposition: attachment; filename=\"%s.tar\"\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n",
+        filename.c_str());
+    archiveStream(nc)->writer = std::move(writer);
+    pumpArchive(nc);
+    Logger::getInstance().log(Logger::INFO, "Streaming backup archive %s.", filename.c_str());
+}
+
+static void handle_backup_upload(struct mg_connection* nc, struct http_message* hm)
+{
+    ArchiveStream* stream = archiveStream(nc);
+    std::string root;
+    if (!backupRoot(hm, root)) {
+        stream->status = 404;
+        return;
+    }
+    // the saves folder holds title folders, the backups are one level further down
+    stream->reader = std::make_unique<Tar::Reader>(root, UPLOADS_PATH + "/" + std::to_string(++uploads), root == SAVES_PATH ? 2 : 1);
+    stream->status = 200;
+}
+
+static void finish_backup_upload(struct mg_connection* nc)
+{
+    ArchiveStream* stream = archiveStream(nc);
+    if (!stream->reader) {
+        sendJson(nc, 404, {{"error", stream->status == 404 ? "Unknown title." : "Not found."}});
+    }
+    else if (!stream->reader->finish()) {
+        int error = stream->reader->error();
+        Logger::getInstance().log(Logger::ERROR, "Backup archive upload failed with errno %d.", error);
+        if (error == EEXIST) {
+            sendJson(nc, 409, {{"error", "Backup already exists."}, {"conflicts", stream->reader->conflicts()}});
+        }
+        else {
+            sendJson(nc, error == EIO ? 500 : 400, {{"error", error != 0 ? strerror(error) : "Truncated archive."}});
+        }
+    }
+    else {
+        Logger::getInstance().log(Logger::INFO, "Backup archive with %u files uploaded.", (unsigned)stream->reader->files());
+        sendJson(nc, 200, {{"files", stream->reader->files()}});
+        g_backupsChanged = true;
+    }
+    // deletes the staging folder, empty after a successful upload
+    stream->reader.reset();
+    nc->flags |= MG_F_SEND_AND_CLOSE;
+}
+
 static void ev_handler(struct mg_connection* nc, int ev, void* ev_data)
 {
     struct http_message* hm = (struct http_message*)ev_data;
@@ -73,16 +310,49 @@ static void ev_handler(struct mg_connection* nc, int ev, void* ev_data)
             else if (mg_vcmp(&hm->uri, "/populate") == 0) {
                 handle_populate(nc, hm);
             }
+            else if (mg_vcmp(&hm->uri, "/titles") == 0) {
+                handle_titles(nc, hm);
+            }
+            else if (mg_vcmp(&hm->uri, "/backups") == 0) {
+                handle_backups(nc, hm);
+            }
+            else if (mg_vcmp(&hm->uri, "/backup") == 0 && mg_vcmp(&hm->method, "GET") == 0) {
+                handle_backup_download(nc, hm);
+            }
             else {
                 mg_serve_http(nc, hm, s_http_server_opts);
             }
             break;
+        // uploads are multipart/form-data posts to /backup, the archive is extracted as it arrives
+        case MG_EV_HTTP_MULTIPART_REQUEST:
+            if (mg_vcmp(&hm->uri, "/backup") == 0) {
+                handle_backup_upload(nc, hm);
+            }
+            break;
+        case MG_EV_HTTP_PART_DATA: {
+            struct mg_http_multipart_part* part = (struct mg_http_multipart_part*)ev_data;
+            ArchiveStream* stream               = (ArchiveStream*)nc->user_data;
+            if (stream != NULL && stream->reader) {
+                stream->reader->write((const uint8_t*)part->data.p, part->data.len);
+            }
+            break;
+        }
+        case MG_EV_HTTP_MULTIPART_REQUEST_END:
+            finish_backup_upload(nc);
+            break;
+        case MG_EV_SEND:
+            pumpArchive(nc);
+            break;
+        case MG_EV_CLOSE:
+            delete (ArchiveStream*)nc->user_data;
+            nc->user_data = NULL;
+            break;
         default:
             break;
     }
 }
 
-Configuration::Configuration(void)
+Configuration::Configuration(void) : mGeneration(0)
 {
     // check for existing config.json files on the sd card, BASEPATH
     if (!io::fileExists(BASEPATH)) {
@@ -157,6 +427,10 @@ Configuration::Configuration(void)
 
     parse();
 
+    // uploads cut short by a crash are left in their staging folders
+    io::deleteFolderRecursively(UPLOADS_PATH + "/");
+    io::createDirectory(UPLOADS_PATH);
+
     // load server
     mg_mgr_init(&mgr, NULL);
     nc = mg_bind(&mgr, s_http_port, ev_handler);
@@ -191,29 +465,47 @@ void Configuration::store(void)
 
 bool Configuration::filter(u64 id)
 {
-    return mFilterIds.find(id) != mFilterIds.end();
+    return mSnapshot.get().filterIds.contains(id);
 }
 
 bool Configuration::favorite(u64 id)
 {
-    return mFavoriteIds.find(id) != mFavoriteIds.end();
+    return mSnapshot.get().favoriteIds.contains(id);
 }
 
-std::vector<std::string> Configuration::additionalSaveFolders(u64 id)
+Span<std::string> Configuration::additionalSaveFolders(u64 id)
 {
-    std::vector<std::string> emptyvec;
-    auto folders = mAdditionalSaveFolders.find(id);
-    return folders == mAdditionalSaveFolders.end() ? emptyvec : folders->second;
+    return mSnapshot.get().additionalSaveFolders.find(id);
 }
 
 bool Configuration::isPKSMBridgeEnabled(void)
 {
-    return PKSMBridgeEnabled;
+    return mSnapshot.get().PKSMBridgeEnabled;
+}
+
+int Configuration::serverPollfds(std::vector<struct pollfd>& fds)
+{
+    double now  = mg_time();
+    double next = -1;
+    for (struct mg_connection* c = mg_next(&mgr, NULL); c != NULL; c = mg_next(&mgr, c)) {
+        if (c->sock == INVALID_SOCKET) {
+            continue;
+        }
+        short events = POLLIN;
+        if (c->send_mbuf.len > 0 || (c->flags & MG_F_CONNECTING)) {
+            events |= POLLOUT;
+        }
+        fds.push_back({c->sock, events, 0});
+        if (c->ev_timer_time > 0 && (next < 0 || c->ev_timer_time < next)) {
+            next = c->ev_timer_time;
+        }
+    }
+    return next < 0 ? -1 : std::max(0, (int)((next - now) * 1000));
 }
 
 void Configuration::pollServer(void)
 {
-    mg_mgr_poll(&mgr, 1000 / 60);
+    mg_mgr_poll(&mgr, 0);
 }
 
 void Configuration::save(void)
@@ -240,37 +532,33 @@ void Configuration::load(void)
 
 void Configuration::parse(void)
 {
-    mFilterIds.clear();
-    mFavoriteIds.clear();
-    mAdditionalSaveFolders.clear();
+    std::vector<u64> filterIds, favoriteIds;
+    std::vector<std::pair<u64, std::vector<std::string>>> additionalSaveFolders;
 
     // parse filters
     std::vector<std::string> filter = mJson["filter"];
     for (auto& id : filter) {
-        mFilterIds.emplace(strtoull(id.c_str(), NULL, 16));
+        filterIds.push_back(strtoull(id.c_str(), NULL, 16));
     }
 
     // parse favorites
     std::vector<std::string> favorites = mJson["favorites"];
     for (auto& id : favorites) {
-        mFavoriteIds.emplace(strtoull(id.c_str(), NULL, 16));
+        favoriteIds.push_back(strtoull(id.c_str(), NULL, 16));
     }
 
     // parse additional save folders
     auto js = mJson["additional_save_folders"];
     for (auto it = js.begin(); it != js.end(); ++it) {
         std::vector<std::string> folders = it.value()["folders"];
-        std::vector<std::string> sfolders;
-        for (auto& folder : folders) {
-            sfolders.push_back(folder);
-        }
-        mAdditionalSaveFolders.emplace(strtoull(it.key().c_str(), NULL, 16), sfolders);
+        additionalSaveFolders.emplace_back(strtoull(it.key().c_str(), NULL, 16), std::move(folders));
     }
 
-    // parse PKSM Bridge flag
-    PKSMBridgeEnabled = mJson["pksm-bridge"];
-    // parse FTP flag
-    FTPEnabled = mJson["ftp-enabled"];
+    // the ui thread keeps reading the previous snapshot until this one is published
+    mSnapshot.publish(std::make_unique<const Snapshot>(Snapshot{IdSet(std::move(filterIds)), IdSet(std::move(favoriteIds)),
+        FolderTable<std::string>(std::move(additionalSaveFolders)), mJson["pksm-bridge"], mJson["ftp-enabled"]}));
+    // bumped once the snapshot is out, whoever sees the new generation also sees the new favorites
+    mGeneration++;
 }
 
 const char* Configuration::c_str(void)
@@ -283,7 +571,12 @@ nlohmann::json Configuration::getJson(void)
     return mJson;
 }
 
+u32 Configuration::generation(void)
+{
+    return mGeneration;
+}
+
 bool Configuration::isFTPEnabled(void)
 {
-    return FTPEnabled;
+    return mSnapshot.get().FTPEnabled;
 }
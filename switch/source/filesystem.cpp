@@ -25,12 +25,29 @@
  */
 
 #include "filesystem.hpp"
+#include "logger.hpp"
 
 Result FileSystem::mount(FsFileSystem* fileSystem, u64 titleID, AccountUid userID)
 {
     return fsOpen_SaveData(fileSystem, titleID, userID);
 }
 
+s64 FileSystem::journalSize(u64 titleID, AccountUid userID)
+{
+    FsSaveDataAttribute attr = {};
+    attr.application_id      = titleID;
+    attr.uid                 = userID;
+    attr.save_data_type      = FsSaveDataType_Account;
+
+    FsSaveDataExtraData extraData;
+    Result res = fsReadSaveDataFileSystemExtraDataBySaveDataAttribute(&extraData, sizeof(extraData), FsSaveDataSpaceId_User, &attr);
+    if (R_FAILED(res)) {
+        Logger::getInstance().log(Logger::WARN, "Failed to read the save journal size with result 0x%08lX.", res);
+        return 0;
+    }
+    return extraData.journal_size;
+}
+
 int FileSystem::mount(FsFileSystem fs)
 {
     return fsdevMountDevice("save", fs);
@@ -25,6 +25,8 @@
  */
 
 #include "io.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
 bool io::fileExists(const std::string& path)
 {
@@ -32,67 +34,77 @@ bool io::fileExists(const std::string& path)
     return (stat(path.c_str(), &buffer) == 0);
 }
 
-void io::copyFile(const std::string& srcPath, const std::string& dstPath)
-{
-    g_isTransferringFile = true;
+// posix errors have no Result of their own
+static const Result IO_ERROR = MAKERESULT(Module_Libnx, LibnxError_IoError);
 
+Result io::copyFile(const std::string& srcPath, const std::string& dstPath)
+{
+    TRACE_SCOPE("io::copyFile");
     FILE* src = fopen(srcPath.c_str(), "rb");
     if (src == NULL) {
-        Logger::getInstance().log(Logger::ERROR, "Failed to open source file " + srcPath + " during copy with errno %d. Skipping...", errno);
-        return;
+        Logger::getInstance().log(Logger::ERROR, "Failed to open source file " + srcPath + " during copy with errno %d.", errno);
+        return IO_ERROR;
     }
     FILE* dst = fopen(dstPath.c_str(), "wb");
     if (dst == NULL) {
-        Logger::getInstance().log(Logger::ERROR, "Failed to open destination file " + dstPath + " during copy with errno %d. Skipping...", errno);
+        Logger::getInstance().log(Logger::ERROR, "Failed to open destination file " + dstPath + " during copy with errno %d.", errno);
         fclose(src);
-        return;
+        return IO_ERROR;
     }
 
+    g_isTransferringFile = true;
+
     fseek(src, 0, SEEK_END);
     u64 sz = ftell(src);
     rewind(src);
 
     u8* buf    = new u8[BUFFER_SIZE];
     u64 offset = 0;
+    Result res = 0;
 
     size_t slashpos = srcPath.rfind("/");
     g_currentFile   = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
 
     while (offset < sz) {
         u32 count = fread((char*)buf, 1, BUFFER_SIZE, src);
-        fwrite((char*)buf, 1, count, dst);
+        if (count == 0 || fwrite((char*)buf, 1, count, dst) != count) {
+            Logger::getInstance().log(Logger::ERROR, "Failed to copy " + srcPath + " to " + dstPath + " with errno %d.", errno);
+            res = IO_ERROR;
+            break;
+        }
         offset += count;
+        Stats::io(count);
 
         // avoid freezing the UI
         // this will be made less horrible next time...
         g_screen->draw();
+        g_screen->drawHud();
         SDLH_Render();
     }
 
     delete[] buf;
     fclose(src);
-    fclose(dst);
-
-    // commit each file to the save
-    if (dstPath.rfind("save:/", 0) == 0) {
-        Logger::getInstance().log(Logger::ERROR, "Committing file " + dstPath + " to the save archive.");
-        fsdevCommitDevice("save");
+    if (fclose(dst) != 0 && R_SUCCEEDED(res)) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to close " + dstPath + " with errno %d.", errno);
+        res = IO_ERROR;
     }
+    Stats::fileDone();
 
     g_isTransferringFile = false;
+    return res;
 }
 
 Result io::copyDirectory(const std::string& srcPath, const std::string& dstPath)
 {
+    TRACE_SCOPE("io::copyDirectory");
     Result res = 0;
-    bool quit  = false;
     Directory items(srcPath);
 
     if (!items.good()) {
         return items.error();
     }
 
-    for (size_t i = 0, sz = items.size(); i < sz && !quit; i++) {
+    for (size_t i = 0, sz = items.size(); i < sz && R_SUCCEEDED(res); i++) {
         std::string newsrc = srcPath + items.entry(i);
         std::string newdst = dstPath + items.entry(i);
 
@@ -103,21 +115,21 @@ Result io::copyDirectory(const std::string& srcPath, const std::string& dstPath)
                 newdst += "/";
                 res = io::copyDirectory(newsrc, newdst);
             }
-            else {
-                quit = true;
-            }
         }
         else {
-            io::copyFile(newsrc, newdst);
+            res = io::copyFile(newsrc, newdst);
         }
     }
 
-    return 0;
+    return res;
 }
 
 Result io::createDirectory(const std::string& path)
 {
-    mkdir(path.c_str(), 777);
+    if (mkdir(path.c_str(), 777) != 0 && errno != EEXIST) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to create directory " + path + " with errno %d.", errno);
+        return IO_ERROR;
+    }
     return 0;
 }
 
@@ -151,8 +163,40 @@ Result io::deleteFolderRecursively(const std::string& path)
     return 0;
 }
 
+// next to the backups, so that moving it into place is a rename on the same device
+static const std::string STAGING_PATH = "sdmc:/switch/Checkpoint/staging";
+
+// swaps the staging folder in for dstPath. An existing backup is only deleted once the new one has taken its place, a
+// crash in between leaves it as dstPath.old
+static Result commitStaging(const std::string& dstPath)
+{
+    const std::string oldPath = dstPath + ".old";
+    const bool replacing      = io::directoryExists(dstPath);
+    if (replacing) {
+        io::deleteFolderRecursively(oldPath + "/");
+        if (rename(dstPath.c_str(), oldPath.c_str()) != 0) {
+            Logger::getInstance().log(Logger::ERROR, "Failed to move " + dstPath + " out of the way with errno %d.", errno);
+            return IO_ERROR;
+        }
+    }
+
+    if (rename(STAGING_PATH.c_str(), dstPath.c_str()) != 0) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to move the staged backup to " + dstPath + " with errno %d.", errno);
+        if (replacing) {
+            rename(oldPath.c_str(), dstPath.c_str());
+        }
+        return IO_ERROR;
+    }
+
+    if (replacing) {
+        io::deleteFolderRecursively(oldPath + "/");
+    }
+    return 0;
+}
+
 std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, size_t cellIndex)
 {
+    TRACE_SCOPE("io::backup");
     const bool isNewFolder                    = cellIndex == 0;
     Result res                                = 0;
     std::tuple<bool, Result, std::string> ret = std::make_tuple(false, -1, "");
@@ -220,24 +264,30 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, s
         dstPath = title.path() + "/" + customPath;
     }
 
-    if (!isNewFolder || io::directoryExists(dstPath)) {
-        int rc = io::deleteFolderRecursively((dstPath + "/").c_str());
-        if (rc != 0) {
-            FileSystem::unmount();
-            Logger::getInstance().log(Logger::ERROR, "Failed to recursively delete directory " + dstPath + " with result %d.", rc);
-            return std::make_tuple(false, (Result)rc, "Failed to delete the existing backup\ndirectory recursively.");
-        }
+    // the save is copied into a staging folder first and only replaces the destination once it is complete
+    io::deleteFolderRecursively(STAGING_PATH + "/");
+    res = io::createDirectory(STAGING_PATH);
+    if (R_FAILED(res)) {
+        FileSystem::unmount();
+        return std::make_tuple(false, res, "Failed to create destination directory.");
     }
 
-    io::createDirectory(dstPath);
-    res = io::copyDirectory("save:/", dstPath + "/");
+    res = io::copyDirectory("save:/", STAGING_PATH + "/");
     if (R_FAILED(res)) {
         FileSystem::unmount();
-        io::deleteFolderRecursively((dstPath + "/").c_str());
-        Logger::getInstance().log(Logger::ERROR, "Failed to copy directory " + dstPath + " with result 0x%08lX. Skipping...", res);
+        io::deleteFolderRecursively(STAGING_PATH + "/");
+        Logger::getInstance().log(Logger::ERROR, "Failed to copy the save to " + STAGING_PATH + " with result 0x%08lX.", res);
         return std::make_tuple(false, res, "Failed to backup save.");
     }
 
+    io::createDirectory(title.path());
+    res = commitStaging(dstPath);
+    if (R_FAILED(res)) {
+        FileSystem::unmount();
+        io::deleteFolderRecursively(STAGING_PATH + "/");
+        return std::make_tuple(false, res, "Failed to replace the existing backup.");
+    }
+
     refreshDirectories(title.id());
 
     FileSystem::unmount();
@@ -257,8 +307,63 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, s
     return ret;
 }
 
+// writes to save:/ are held in the save's journal until the device is committed, and a commit of more than the journal
+// holds fails. Restores that fit are committed once at the end, bigger ones are committed whenever the next file would
+// overflow the journal
+struct SaveJournal {
+    s64 size;
+    s64 pending;
+};
+
+static Result commitJournal(SaveJournal& journal)
+{
+    Result res = fsdevCommitDevice("save");
+    if (R_FAILED(res)) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to commit save with result 0x%08lX.", res);
+    }
+    journal.pending = 0;
+    return res;
+}
+
+static Result restoreDirectory(const std::string& srcPath, const std::string& dstPath, SaveJournal& journal)
+{
+    Result res = 0;
+    Directory items(srcPath);
+
+    if (!items.good()) {
+        return items.error();
+    }
+
+    for (size_t i = 0, sz = items.size(); i < sz && R_SUCCEEDED(res); i++) {
+        std::string newsrc = srcPath + items.entry(i);
+        std::string newdst = dstPath + items.entry(i);
+
+        if (items.folder(i)) {
+            res = io::createDirectory(newdst);
+            if (R_SUCCEEDED(res)) {
+                res = restoreDirectory(newsrc + "/", newdst + "/", journal);
+            }
+        }
+        else {
+            struct stat st;
+            s64 fileSize = stat(newsrc.c_str(), &st) == 0 ? st.st_size : 0;
+            if (journal.pending > 0 && journal.pending + fileSize > journal.size) {
+                Logger::getInstance().log(Logger::WARN, "Restore does not fit the save journal, committing before " + newdst + ".");
+                res = commitJournal(journal);
+            }
+            if (R_SUCCEEDED(res)) {
+                res = io::copyFile(newsrc, newdst);
+                journal.pending += fileSize;
+            }
+        }
+    }
+
+    return res;
+}
+
 std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid, size_t cellIndex, const std::string& nameFromCell)
 {
+    TRACE_SCOPE("io::restore");
     Result res                                = 0;
     std::tuple<bool, Result, std::string> ret = std::make_tuple(false, -1, "");
     Title title;
@@ -288,6 +393,16 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid,
     std::string srcPath = title.fullPath(cellIndex) + "/";
     std::string dstPath = "save:/";
 
+    // nothing written to save:/ is kept until the device is committed, so when the backup fits the journal a failure
+    // anywhere before the commit at the end leaves the original save as it was once the device is unmounted.
+    // Without a known journal size every file is committed on its own
+    Directory backupItems(srcPath);
+    if (!backupItems.good()) {
+        FileSystem::unmount();
+        Logger::getInstance().log(Logger::ERROR, "Failed to open the backup " + srcPath + " with result 0x%08lX.", backupItems.error());
+        return std::make_tuple(false, backupItems.error(), "Failed to open the backup.");
+    }
+
     res = io::deleteFolderRecursively(dstPath.c_str());
     if (R_FAILED(res)) {
         FileSystem::unmount();
@@ -295,16 +410,17 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid,
         return std::make_tuple(false, res, "Failed to delete save.");
     }
 
-    res = io::copyDirectory(srcPath, dstPath);
+    SaveJournal journal = {FileSystem::journalSize(title.id(), title.userId()), 0};
+    res                 = restoreDirectory(srcPath, dstPath, journal);
     if (R_FAILED(res)) {
         FileSystem::unmount();
-        Logger::getInstance().log(Logger::ERROR, "Failed to copy directory " + srcPath + " to " + dstPath + " with result 0x%08lX. Skipping...", res);
+        Logger::getInstance().log(Logger::ERROR, "Failed to copy directory " + srcPath + " to " + dstPath + " with result 0x%08lX.", res);
         return std::make_tuple(false, res, "Failed to restore save.");
     }
 
-    res = fsdevCommitDevice("save");
+    res = commitJournal(journal);
     if (R_FAILED(res)) {
-        Logger::getInstance().log(Logger::ERROR, "Failed to commit save with result 0x%08lX.", res);
+        FileSystem::unmount();
         return std::make_tuple(false, res, "Failed to commit to save device.");
     }
     else {
@@ -26,18 +26,20 @@
 
 #include "main.hpp"
 #include "MainScreen.hpp"
-extern "C" {
-#include "ftp.h"
+#include "network.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+
+static void loadCheats(void)
+{
+    CheatManager::getInstance().load();
+    g_screen->markDirty();
+    Stats::jobDone();
 }
 
-static void networkLoop(void)
+static void flushLogs(void)
 {
-    while (appletMainLoop() && !g_shouldExitNetworkLoop) {
-        Configuration::getInstance().pollServer();
-        if (g_ftpAvailable && Configuration::getInstance().isFTPEnabled()) {
-            ftp_loop();
-        }
-    }
+    Logger::getInstance().run();
 }
 
 int main(void)
@@ -50,6 +52,16 @@ int main(void)
 
     g_screen = std::make_unique<MainScreen>();
 
+    Thread loggerThread;
+    threadCreate(&loggerThread, (ThreadFunc)flushLogs, nullptr, nullptr, 16 * 1024, 0x3B, -2);
+    threadStart(&loggerThread);
+
+    // cheats are indexed in the background while titles load
+    Thread cheatsThread;
+    Stats::jobQueued();
+    threadCreate(&cheatsThread, (ThreadFunc)loadCheats, nullptr, nullptr, 64 * 1024, 0x2C, -2);
+    threadStart(&cheatsThread);
+
     loadTitles();
     // get the user IDs
     std::vector<AccountUid> userIds = Account::ids();
@@ -58,23 +70,60 @@ int main(void)
         g_currentUId = userIds.at(0);
 
     Thread networkThread;
-    threadCreate(&networkThread, (ThreadFunc)networkLoop, nullptr, nullptr, 16 * 1000, 0x2C, -2);
+    threadCreate(&networkThread, (ThreadFunc)Network::loop, nullptr, nullptr, 16 * 1000, 0x2C, -2);
     threadStart(&networkThread);
 
+    u32 shownConfig  = Configuration::getInstance().generation();
+    long shownHost   = gethostid();
+    time_t shownTime = time(NULL);
     while (appletMainLoop() && !(hidKeysDown(CONTROLLER_P1_AUTO) & KEY_PLUS)) {
         touchPosition touch;
         hidScanInput();
         hidTouchRead(&touch, 0);
 
+        if (hidKeysDown(CONTROLLER_P1_AUTO) & KEY_LSTICK) {
+            g_screen->toggleHud();
+        }
+
+        if (g_backupsChanged.exchange(false)) {
+            for (const auto& title : getTitleBackupPaths()) {
+                refreshDirectories(title.first);
+            }
+            g_screen->markDirty();
+        }
+        if (pollFullIcons()) {
+            g_screen->markDirty();
+        }
+        // favorites, filters and the ftp switch can change through the config server
+        if (shownConfig != Configuration::getInstance().generation()) {
+            shownConfig = Configuration::getInstance().generation();
+            g_screen->markDirty();
+        }
+        // the server address shown on screen follows the connection, check it once per second
+        if (shownTime != time(NULL)) {
+            shownTime = time(NULL);
+            if (shownHost != gethostid()) {
+                shownHost = gethostid();
+                g_screen->markDirty();
+            }
+        }
+
         g_screen->doDraw();
         g_screen->doUpdate(&touch);
         SDLH_Render();
     }
 
-    g_shouldExitNetworkLoop = true;
+    Network::stop();
     threadWaitForExit(&networkThread);
     threadClose(&networkThread);
+    threadWaitForExit(&cheatsThread);
+    threadClose(&cheatsThread);
+
+    Trace::dump();
 
+    // servicesExit flushes the log, which makes the flusher return
     servicesExit();
+    threadWaitForExit(&loggerThread);
+    threadClose(&loggerThread);
     exit(0);
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "network.hpp"
+#include "configuration.hpp"
+#include "main.hpp"
+#include "util.hpp"
+#include <atomic>
+#include <poll.h>
+#include <vector>
+
+static std::atomic<int> wakeFd(-1);
+static struct sockaddr_in wakeAddr;
+
+// a loopback datagram socket lets other threads interrupt poll(), the sockets here have no pipes
+static void openWakeSocket(void)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return;
+    }
+    socklen_t len = sizeof(wakeAddr);
+    memset(&wakeAddr, 0, sizeof(wakeAddr));
+    wakeAddr.sin_family      = AF_INET;
+    wakeAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    wakeAddr.sin_port        = 0;
+    if (bind(fd, (struct sockaddr*)&wakeAddr, sizeof(wakeAddr)) < 0 || getsockname(fd, (struct sockaddr*)&wakeAddr, &len) < 0) {
+        Logger::getInstance().log(Logger::WARN, "Network wake socket unavailable with errno %d.", errno);
+        close(fd);
+        return;
+    }
+    wakeFd = fd;
+}
+
+void Network::loop(void)
+{
+    openWakeSocket();
+
+    std::vector<struct pollfd> fds;
+    while (appletMainLoop() && !g_shouldExitNetworkLoop) {
+        fds.clear();
+        if (wakeFd >= 0) {
+            fds.push_back({wakeFd, POLLIN, 0});
+        }
+
+        size_t serverFirst = fds.size();
+        int timeout        = Configuration::getInstance().serverPollfds(fds);
+        size_t ftpFirst    = fds.size();
+        if (g_ftpAvailable && Configuration::getInstance().isFTPEnabled()) {
+            int n = ftp_pollfds(NULL, 0);
+            fds.resize(ftpFirst + n);
+            ftp_pollfds(fds.data() + ftpFirst, n);
+        }
+        // without a wake socket stop() is only noticed on the next timeout
+        if (wakeFd < 0 && (timeout < 0 || timeout > 100)) {
+            timeout = 100;
+        }
+
+        int ready = poll(fds.data(), fds.size(), timeout);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                Logger::getInstance().log(Logger::ERROR, "Network poll failed with errno %d.", errno);
+                break;
+            }
+            continue;
+        }
+
+        if (serverFirst > 0 && fds[0].revents != 0) {
+            char drain[16];
+            while (recv(fds[0].fd, drain, sizeof(drain), MSG_DONTWAIT) > 0)
+                ;
+        }
+
+        // mongoose also runs on a timeout, its timers are due then
+        bool server = ready == 0;
+        for (size_t i = serverFirst; i < ftpFirst && !server; i++) {
+            server = fds[i].revents != 0;
+        }
+        if (server) {
+            Configuration::getInstance().pollServer();
+        }
+        for (size_t i = ftpFirst; i < fds.size(); i++) {
+            if (fds[i].revents != 0) {
+                ftp_loop();
+                break;
+            }
+        }
+    }
+
+    int fd = wakeFd.exchange(-1);
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void Network::stop(void)
+{
+    g_shouldExitNetworkLoop = true;
+    int fd                  = wakeFd;
+    if (fd >= 0) {
+        char c = 0;
+        sendto(fd, &c, sizeof(c), 0, (struct sockaddr*)&wakeAddr, sizeof(wakeAddr));
+    }
+}
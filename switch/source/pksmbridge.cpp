@@ -47,6 +47,48 @@ bool validateIpAddress(const std::string& ip)
     return inet_pton(AF_INET, ip.c_str(), &sa.sin_addr) != 0;
 }
 
+static std::string bridgeFilename(u64 id)
+{
+    if (isLGPE(id)) {
+        return "/savedata.bin";
+    }
+    else if (isSWSH(id)) {
+        return "/backup";
+    }
+    return "";
+}
+
+// what PKSM releases without the framed protocol send, the raw save
+static uint64_t bridgeLegacySize(u64 id)
+{
+    if (isLGPE(id)) {
+        return 0x100000;
+    }
+    else if (isSWSH(id)) {
+        return 0x180B19;
+    }
+    return 0;
+}
+
+static bool isConnectionError(int err)
+{
+    return err == ECONNRESET || err == ECONNABORTED || err == EPIPE || err == ETIMEDOUT;
+}
+
+static Transfer::progress_t bridgeProgress(const std::string& action)
+{
+    // only redraw when the percentage changes
+    return [action, last = -1](uint64_t done, uint64_t total) mutable {
+        int percent = total > 0 ? (int)(done * 100 / total) : 100;
+        if (percent != last) {
+            last          = percent;
+            g_currentFile = StringUtils::format("%s %d%%", action.c_str(), percent);
+            g_screen->draw();
+            SDLH_Render();
+        }
+    };
+}
+
 std::tuple<bool, Result, std::string> sendToPKSMBrigde(size_t index, AccountUid uid, size_t cellIndex)
 {
     auto systemKeyboardAvailable = KeyboardManager::get().isSystemKeyboardAvailable();
@@ -54,83 +96,75 @@ std::tuple<bool, Result, std::string> sendToPKSMBrigde(size_t index, AccountUid
         return std::make_tuple(false, systemKeyboardAvailable.second, "System keyboard not accessible.");
     }
 
-    // load data
     Title title;
     getTitle(title, uid, index);
-    std::string filename;
-    if (isLGPE(title.id())) {
-        filename = "/savedata.bin";
-    }
-    else if (isSWSH(title.id())) {
-        filename = "/backup";
-    }
-    else {
+    std::string filename = bridgeFilename(title.id());
+    if (filename.empty()) {
         return std::make_tuple(false, systemKeyboardAvailable.second, "Invalid title.");
     }
 
     std::string srcPath = title.fullPath(cellIndex) + filename;
-    FILE* save          = fopen(srcPath.c_str(), "rb");
-    if (save == NULL) {
+    if (!io::fileExists(srcPath)) {
         return std::make_tuple(false, systemKeyboardAvailable.second, "Failed to open source file.");
     }
 
-    fseek(save, 0, SEEK_END);
-    size_t size = ftell(save);
-    rewind(save);
-    char* data = new char[size];
-    fread(data, 1, size, save);
-    fclose(save);
-
     // get server address
     auto ipaddress = KeyboardManager::get().keyboard("Input PKSM IP address");
     if (!ipaddress.first || !validateIpAddress(ipaddress.second)) {
-        delete[] data;
         return std::make_tuple(false, -1, "Invalid IP address.");
     }
 
     // send via TCP
-    int fd;
     struct sockaddr_in servaddr;
-    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-        delete[] data;
-        return std::make_tuple(false, errno, "Socket creation failed.");
-    }
     memset(&servaddr, 0, sizeof(servaddr));
     servaddr.sin_family      = AF_INET;
     servaddr.sin_port        = htons(PKSM_PORT);
     servaddr.sin_addr.s_addr = inet_addr(ipaddress.second.c_str());
 
-    if (connect(fd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
+    // a dropped connection is retried, the receiver resumes from the data it already stored
+    int res = 0;
+    for (int attempt = 0; attempt < PKSM_ATTEMPTS; attempt++) {
+        int fd;
+        if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+            return std::make_tuple(false, errno, "Socket creation failed.");
+        }
+        Transfer::configureSocket(fd);
+
+        if (connect(fd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
+            int err = errno;
+            close(fd);
+            return std::make_tuple(false, err, "Socket connection failed.");
+        }
+
+        g_isTransferringFile = true;
+        res                  = Transfer::sendFile(fd, srcPath, bridgeProgress("Sending"));
+        g_isTransferringFile = false;
         close(fd);
-        delete[] data;
-        return std::make_tuple(false, errno, "Socket connection failed.");
-    }
 
-    size_t total = 0;
-    size_t chunk = 1024;
-    while (total < size) {
-        size_t tosend = size - total > chunk ? chunk : size - total;
-        int n         = send(fd, data + total, tosend, 0);
-        if (n == -1) {
+        if (!isConnectionError(res)) {
             break;
         }
-        total += n;
-        fprintf(stderr, "Sent %lu bytes, %lu still missing\n", (unsigned long)total, (unsigned long)(size - total));
+        Logger::getInstance().log(Logger::WARN, "pksmbridge connection dropped with errno %d, retrying.", res);
     }
 
-    close(fd);
-    delete[] data;
-
-    if (total == size) {
+    if (res == 0) {
         return std::make_tuple(true, 0, "Data sent correctly.");
     }
     else {
-        return std::make_tuple(false, errno, "Failed to send data.");
+        Logger::getInstance().log(Logger::ERROR, "Failed to send pksmbridge data with errno %d.", res);
+        return std::make_tuple(false, res, "Failed to send data.");
     }
 }
 
 std::tuple<bool, Result, std::string> recvFromPKSMBridge(size_t index, AccountUid uid, size_t cellIndex)
 {
+    Title title;
+    getTitle(title, uid, index);
+    std::string filename = bridgeFilename(title.id());
+    if (filename.empty()) {
+        return std::make_tuple(false, -1, "Invalid title.");
+    }
+
     int fd;
     struct sockaddr_in servaddr;
     if ((fd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP)) < 0) {
@@ -161,60 +195,25 @@ std::tuple<bool, Result, std::string> recvFromPKSMBridge(size_t index, AccountUi
         Logger::getInstance().log(Logger::ERROR, "Socket accept failed: %d.", fdconn);
         return std::make_tuple(false, errno, "Socket accept failed.");
     }
+    Transfer::configureSocket(fdconn);
 
-    size_t size;
-    Title title;
-    getTitle(title, uid, index);
-    std::string filename;
-    if (isLGPE(title.id())) {
-        filename = "/savedata.bin";
-        size     = 0x100000;
-    }
-    else if (isSWSH(title.id())) {
-        filename = "/backup";
-        size     = 0x180B19;
-    }
-    else {
-        filename = "DEFAULT";
-        // WHAT DO WE DO ABOUT SIZE?
-    }
-    std::string srcPath = title.fullPath(cellIndex) + filename;
-    FILE* save          = fopen(srcPath.c_str(), "wb");
-    if (save == NULL) {
-        close(fd);
-        close(fdconn);
-        Logger::getInstance().log(Logger::ERROR, "Failed to open destination file with errno %d.", errno);
-        return std::make_tuple(false, errno, "Failed to open destination file.");
-    }
-
-    char* data = new char[size]();
-
-    size_t total = 0;
-    size_t chunk = 1024;
-    while (total < size) {
-        size_t torecv = size - total > chunk ? chunk : size - total;
-        int n         = recv(fdconn, data + total, torecv, 0);
-        if (n == -1) {
-            break;
-        }
-        total += n;
-        fprintf(stderr, "Recv %lu bytes, %lu still missing\n", (unsigned long)total, (unsigned long)(size - total));
-    }
+    // the size comes from the frame header, data is staged outside the backups and only replaces the destination once
+    // verified. if the connection drops the staged data is kept and the next receive of the same save resumes it
+    std::string dstPath  = title.fullPath(cellIndex) + filename;
+    g_isTransferringFile = true;
+    int res              = Transfer::recvFile(
+        fdconn, dstPath, PKSM_STAGING_PATH, PKSM_MAX_SIZE, bridgeLegacySize(title.id()), bridgeProgress("Receiving"));
+    g_isTransferringFile = false;
 
     close(fd);
     close(fdconn);
 
-    if (total == size) {
-        fwrite(data, 1, size, save);
-        fclose(save);
-        delete[] data;
+    if (res == 0) {
         Logger::getInstance().log(Logger::INFO, "pksmbridge data received correctly.");
         return std::make_tuple(true, 0, "Data received correctly.");
     }
     else {
-        fclose(save);
-        delete[] data;
-        Logger::getInstance().log(Logger::ERROR, "Failed to receive pksmbridge data.");
-        return std::make_tuple(false, errno, "Failed to receive data.");
+        Logger::getInstance().log(Logger::ERROR, "Failed to receive pksmbridge data with errno %d.", res);
+        return std::make_tuple(false, res, "Failed to receive data.");
     }
 }
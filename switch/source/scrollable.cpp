@@ -28,7 +28,7 @@
 
 void Scrollable::text(size_t i, const std::string& v)
 {
-    ((Clickable*)mCells.at(i))->text(v);
+    cellName(i, v);
 }
 
 void Scrollable::setIndex(size_t i)
@@ -44,12 +44,10 @@ void Scrollable::resetIndex(void)
     mHid.page(0);
 }
 
-void Scrollable::push_back(SDL_Color color, SDL_Color colorMessage, const std::string& message, bool selected)
+IClickable<SDL_Color>* Scrollable::newCell(size_t i)
 {
     const float spacing = mh / mVisibleEntries;
-    Clickable* cell     = new Clickable(mx, my + (size() % mVisibleEntries) * spacing, mw, spacing, color, colorMessage, message, false);
-    cell->selected(selected);
-    mCells.push_back(cell);
+    return new Clickable(mx, my + i * spacing, mw, spacing, theme().c2, theme().c6, "", false);
 }
 
 void Scrollable::updateSelection(void)
@@ -70,10 +68,9 @@ void Scrollable::updateSelection(void)
 
 void Scrollable::draw(bool condition)
 {
-    const size_t baseIndex = mVisibleEntries * mPage;
-    const size_t sz        = size() - baseIndex > mVisibleEntries ? mVisibleEntries : size() - baseIndex;
-    for (size_t i = baseIndex; i < baseIndex + sz; i++) {
-        mCells.at(i)->draw(20, g_backupScrollEnabled ? COLOR_BLUE : theme().c0);
+    const size_t sz = bind();
+    for (size_t i = 0; i < sz; i++) {
+        mCells[i]->draw(20, g_backupScrollEnabled ? COLOR_BLUE : theme().c0);
     }
 
     size_t blankRows = mVisibleEntries - sz;
@@ -81,9 +78,9 @@ void Scrollable::draw(bool condition)
     SDLH_DrawRect(mx, my + sz * rowHeight, mw, rowHeight * blankRows, theme().c2);
 
     // draw selector
-    for (size_t i = baseIndex; i < baseIndex + sz; i++) {
-        if (mCells.at(i)->selected()) {
-            mCells.at(i)->drawOutline(condition ? COLOR_BLUE : theme().c5);
+    for (size_t i = 0; i < sz; i++) {
+        if (mCells[i]->selected()) {
+            mCells[i]->drawOutline(condition ? COLOR_BLUE : theme().c5);
             break;
         }
     }
@@ -25,12 +25,269 @@
  */
 
 #include "title.hpp"
+#include "hash.hpp"
+#include "lrucache.hpp"
+#include "titleindex.hpp"
+#include "titlesort.hpp"
+#include "trace.hpp"
+#include <memory>
+#include <unordered_set>
 
 static std::unordered_map<AccountUid, std::vector<Title>> titles;
+// titles stay in load order, every sort mode has its own permutation of them
+static std::unordered_map<AccountUid, std::array<TitleSort::Permutation, TitleSort::ORDER_COUNT>> orders;
+// the configuration generation the orders were built with, favorites come first in all of them
+static u32 ordersConfig = 0;
+static_assert(SORT_ALPHA == TitleSort::ORDER_ALPHA && SORT_LAST_PLAYED == TitleSort::ORDER_LAST_PLAYED &&
+                  SORT_PLAY_TIME == TitleSort::ORDER_PLAY_TIME && SORT_MODES_COUNT == TitleSort::ORDER_COUNT,
+    "sort modes and title orders must match");
+// with a filter set, the titles are seen through views that keep the matching part of the current order
+static std::unordered_map<AccountUid, TitleIndex> indexes;
+static std::unordered_map<AccountUid, std::vector<bool>> matches;
+static std::unordered_map<AccountUid, TitleSort::Permutation> views;
+static std::string filter;
+
+// the grid draws 128x128 thumbnails, the full 256x256 icon is only loaded for the few titles shown in the info panel
+static constexpr int THUMBNAIL_SIZE = 128;
+static constexpr size_t FULL_ICONS  = 4;
 static std::unordered_map<u64, SDL_Texture*> icons;
+static LruCache<u64, SDL_Texture*> fullIcons(FULL_ICONS, [](SDL_Texture*& texture) {
+    if (texture != NULL) {
+        SDL_DestroyTexture(texture);
+    }
+});
+static std::atomic<u32> titlesGeneration(0);
+static std::atomic<u32> directoriesGeneration(0);
+
+// what the configuration server sees of the title list. Its thread must not walk the titles while the main thread
+// works on them, so loadTitles publishes an immutable copy and readers take a reference to it under snapshotMutex
+struct TitleSnapshot {
+    std::unordered_map<std::string, std::string> names;
+    std::unordered_map<u64, std::string> paths;
+};
+
+static Mutex snapshotMutex;
+static std::shared_ptr<const TitleSnapshot> snapshot = std::make_shared<const TitleSnapshot>();
+
+// thumbnails are kept on the sd card as raw RGBA8 pixels, keyed by title id and checked against a hash of the icon they
+// were made from, so titles only decode and downscale their icon the first time they are seen or after an update.
+// file: u32 magic, u32 version, u32 count, u32 side, then count * { u64 title id, u64 icon hash, u8 pixels[side * side * 4] }
+struct Thumbnail {
+    u64 hash;
+    std::vector<u8> pixels;
+};
+
+static const std::string THUMBNAILS_PATH = "sdmc:/switch/Checkpoint/thumbnails.bin";
+static constexpr u32 THUMBNAILS_MAGIC    = 0x4E48544B; // KTHN
+static constexpr u32 THUMBNAILS_VERSION  = 2;
+static std::unordered_map<u64, Thumbnail> thumbnails;
+static std::unordered_set<u64> thumbnailsUsed;
+static bool thumbnailsDirty = false;
+
+static void readThumbnails(void)
+{
+    thumbnails.clear();
+    thumbnailsUsed.clear();
+    thumbnailsDirty = false;
+
+    FILE* f = fopen(THUMBNAILS_PATH.c_str(), "rb");
+    if (f == NULL) {
+        return;
+    }
+
+    u32 header[4];
+    if (fread(header, sizeof(header), 1, f) == 1 && header[0] == THUMBNAILS_MAGIC && header[1] == THUMBNAILS_VERSION &&
+        header[3] == THUMBNAIL_SIZE) {
+        for (u32 i = 0; i < header[2]; i++) {
+            u64 key[2];
+            Thumbnail thumbnail{0, std::vector<u8>(THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4)};
+            if (fread(key, sizeof(key), 1, f) != 1 || fread(thumbnail.pixels.data(), thumbnail.pixels.size(), 1, f) != 1) {
+                Logger::getInstance().log(Logger::WARN, "Thumbnail cache is truncated, %u of %u entries read.", i, header[2]);
+                break;
+            }
+            thumbnail.hash = key[1];
+            thumbnails.emplace(key[0], std::move(thumbnail));
+        }
+    }
+    fclose(f);
+}
+
+static void writeThumbnails(void)
+{
+    // entries of titles that are gone are dropped along the way
+    u32 header[4] = {THUMBNAILS_MAGIC, THUMBNAILS_VERSION, 0, THUMBNAIL_SIZE};
+    for (auto& thumbnail : thumbnails) {
+        header[2] += thumbnailsUsed.count(thumbnail.first);
+    }
+
+    if (thumbnailsDirty || header[2] != thumbnails.size()) {
+        FILE* f = fopen(THUMBNAILS_PATH.c_str(), "wb");
+        if (f != NULL) {
+            bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+            for (auto& thumbnail : thumbnails) {
+                if (ok && thumbnailsUsed.count(thumbnail.first)) {
+                    const u64 key[2] = {thumbnail.first, thumbnail.second.hash};
+                    ok = fwrite(key, sizeof(key), 1, f) == 1 &&
+                         fwrite(thumbnail.second.pixels.data(), thumbnail.second.pixels.size(), 1, f) == 1;
+                }
+            }
+            fclose(f);
+
+            if (!ok) {
+                Logger::getInstance().log(Logger::ERROR, "Failed to write the thumbnail cache with errno %d.", errno);
+                remove(THUMBNAILS_PATH.c_str());
+            }
+        }
+        else {
+            Logger::getInstance().log(Logger::ERROR, "Failed to open the thumbnail cache with errno %d.", errno);
+        }
+    }
+
+    // the pixels live in the textures now
+    thumbnails.clear();
+    thumbnailsUsed.clear();
+}
+
+// full icons are read and decoded on their own thread, only the texture upload happens on the main thread in
+// pollFullIcons. Title::icon() hands out the thumbnail until then
+static Thread iconThread;
+static bool iconThreadStarted = false;
+static std::atomic<bool> iconThreadRunning(false);
+static Semaphore iconRequested;
+static Mutex iconMutex;
+// guarded by iconMutex
+static u64 iconRequest         = 0;
+static u64 iconLoadedId        = 0;
+static SDL_Surface* iconLoaded = NULL;
+static bool iconLoadedReady    = false;
+// main thread only, the id last handed to the loader and not collected yet
+static u64 iconPending = 0;
+
+static SDL_Surface* loadFullIcon(u64 id)
+{
+    TRACE_SCOPE("loadFullIcon");
+    NsApplicationControlData* nsacd = (NsApplicationControlData*)malloc(sizeof(NsApplicationControlData));
+    if (nsacd == NULL) {
+        return NULL;
+    }
+
+    SDL_Surface* surface = NULL;
+    size_t outsize       = 0;
+    Result res           = nsGetApplicationControlData(NsApplicationControlSource_Storage, id, nsacd, sizeof(NsApplicationControlData), &outsize);
+    if (R_SUCCEEDED(res) && outsize > sizeof(nsacd->nacp)) {
+        surface = SDLH_DecodeImage(nsacd->icon, outsize - sizeof(nsacd->nacp));
+    }
+    free(nsacd);
+    return surface;
+}
+
+static void iconLoop(void*)
+{
+    while (true) {
+        semaphoreWait(&iconRequested);
+        if (!iconThreadRunning) {
+            break;
+        }
+
+        mutexLock(&iconMutex);
+        u64 id      = iconRequest;
+        iconRequest = 0;
+        mutexUnlock(&iconMutex);
+        if (id == 0) {
+            continue;
+        }
+
+        SDL_Surface* surface = loadFullIcon(id);
+        mutexLock(&iconMutex);
+        if (iconLoaded != NULL) {
+            SDL_FreeSurface(iconLoaded);
+        }
+        iconLoaded      = surface;
+        iconLoadedId    = id;
+        iconLoadedReady = true;
+        mutexUnlock(&iconMutex);
+    }
+}
+
+static void requestFullIcon(u64 id)
+{
+    if (iconPending == id) {
+        return;
+    }
+    if (!iconThreadStarted) {
+        semaphoreInit(&iconRequested, 0);
+        mutexInit(&iconMutex);
+        iconThreadRunning = true;
+        if (R_FAILED(threadCreate(&iconThread, iconLoop, nullptr, nullptr, 64 * 1024, 0x2C, -2)) || R_FAILED(threadStart(&iconThread))) {
+            Logger::getInstance().log(Logger::ERROR, "Failed to start the icon loader.");
+            iconThreadRunning = false;
+            return;
+        }
+        iconThreadStarted = true;
+    }
+
+    // only the latest selection matters, an older request that has not started yet is replaced
+    mutexLock(&iconMutex);
+    iconRequest = id;
+    mutexUnlock(&iconMutex);
+    iconPending = id;
+    semaphoreSignal(&iconRequested);
+}
+
+bool pollFullIcons(void)
+{
+    if (!iconThreadStarted) {
+        return false;
+    }
+
+    mutexLock(&iconMutex);
+    const bool ready     = iconLoadedReady;
+    const u64 id         = iconLoadedId;
+    SDL_Surface* surface = iconLoaded;
+    iconLoaded           = NULL;
+    iconLoadedReady      = false;
+    mutexUnlock(&iconMutex);
+    if (!ready) {
+        return false;
+    }
+
+    // failures are cached too, the thumbnail stands in for them
+    SDL_Texture* texture = NULL;
+    if (surface != NULL) {
+        texture = SDLH_CreateTextureRGBA((const u8*)surface->pixels, surface->w, surface->h, surface->pitch);
+        SDL_FreeSurface(surface);
+        if (texture != NULL) {
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+        }
+    }
+    fullIcons.insert(id, texture);
+    if (iconPending == id) {
+        iconPending = 0;
+    }
+    return true;
+}
+
+static void stopIconLoader(void)
+{
+    if (iconThreadStarted) {
+        iconThreadRunning = false;
+        semaphoreSignal(&iconRequested);
+        threadWaitForExit(&iconThread);
+        threadClose(&iconThread);
+        iconThreadStarted = false;
+        if (iconLoaded != NULL) {
+            SDL_FreeSurface(iconLoaded);
+            iconLoaded = NULL;
+        }
+        iconLoadedReady = false;
+        iconPending     = 0;
+    }
+}
 
 void freeIcons(void)
 {
+    stopIconLoader();
+    fullIcons.clear();
     for (auto& i : icons) {
         SDL_DestroyTexture(i.second);
     }
@@ -38,10 +295,33 @@ void freeIcons(void)
 
 static void loadIcon(u64 id, NsApplicationControlData* nsacd, size_t iconsize)
 {
-    auto it = icons.find(id);
-    if (it == icons.end()) {
-        SDL_Texture* texture;
-        SDLH_LoadImage(&texture, nsacd->icon, iconsize);
+    thumbnailsUsed.insert(id);
+    if (icons.find(id) != icons.end()) {
+        return;
+    }
+
+    const u64 hash = Hash::fast64(nsacd->icon, iconsize);
+    auto it        = thumbnails.find(id);
+    if (it == thumbnails.end() || it->second.hash != hash) {
+        Thumbnail thumbnail{hash, std::vector<u8>(THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4)};
+        if (!SDLH_DecodeThumbnail(nsacd->icon, iconsize, thumbnail.pixels.data(), THUMBNAIL_SIZE)) {
+            // odd sized icons are kept as they are and scaled while drawing
+            Logger::getInstance().log(Logger::WARN, "Failed to make a thumbnail for title 0x%016llX.", id);
+            thumbnailsUsed.erase(id);
+            SDL_Texture* texture = NULL;
+            SDLH_LoadImage(&texture, nsacd->icon, iconsize);
+            if (texture != NULL) {
+                SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+                icons.insert({id, texture});
+            }
+            return;
+        }
+        it              = thumbnails.insert_or_assign(id, std::move(thumbnail)).first;
+        thumbnailsDirty = true;
+    }
+
+    SDL_Texture* texture = SDLH_CreateTextureRGBA(it->second.pixels.data(), THUMBNAIL_SIZE, THUMBNAIL_SIZE, THUMBNAIL_SIZE * 4);
+    if (texture != NULL) {
         SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
         icons.insert({id, texture});
     }
@@ -49,6 +329,7 @@ static void loadIcon(u64 id, NsApplicationControlData* nsacd, size_t iconsize)
 
 void Title::init(u8 saveDataType, u64 id, AccountUid userID, const std::string& name, const std::string& author)
 {
+    TRACE_SCOPE("Title::init");
     mId           = id;
     mUserId       = userID;
     mSaveDataType = saveDataType;
@@ -90,17 +371,17 @@ void Title::init(u8 saveDataType, u64 id, AccountUid userID, const std::string&
     refreshDirectories();
 }
 
-u8 Title::saveDataType(void)
+u8 Title::saveDataType(void) const
 {
     return mSaveDataType;
 }
 
-u64 Title::id(void)
+u64 Title::id(void) const
 {
     return mId;
 }
 
-u64 Title::saveId(void)
+u64 Title::saveId(void) const
 {
     return mSaveId;
 }
@@ -110,58 +391,65 @@ void Title::saveId(u64 saveId)
     mSaveId = saveId;
 }
 
-AccountUid Title::userId(void)
+AccountUid Title::userId(void) const
 {
     return mUserId;
 }
 
-std::string Title::userName(void)
+std::string Title::userName(void) const
 {
     return mUserName;
 }
 
-std::string Title::author(void)
+std::string Title::author(void) const
 {
     return mAuthor;
 }
 
-std::string Title::name(void)
+std::string Title::name(void) const
 {
     return mName;
 }
 
-std::pair<std::string, std::string> Title::displayName(void)
+std::pair<std::string, std::string> Title::displayName(void) const
 {
     return mDisplayName;
 }
 
-std::string Title::path(void)
+std::string Title::path(void) const
 {
     return mPath;
 }
 
-std::string Title::fullPath(size_t index)
+std::string Title::fullPath(size_t index) const
 {
     return mFullSavePaths.at(index);
 }
 
-std::vector<std::string> Title::saves()
+std::vector<std::string> Title::saves() const
 {
     return mSaves;
 }
 
-SDL_Texture* Title::icon(void)
+SDL_Texture* Title::icon(void) const
 {
+    SDL_Texture** texture = fullIcons.find(mId);
+    if (texture == nullptr) {
+        requestFullIcon(mId);
+    }
+    else if (*texture != NULL) {
+        return *texture;
+    }
     auto it = icons.find(mId);
     return it != icons.end() ? it->second : NULL;
 }
 
-u32 Title::playTimeMinutes(void)
+u32 Title::playTimeMinutes(void) const
 {
     return mPlayTimeMinutes;
 }
 
-std::string Title::playTime(void)
+std::string Title::playTime(void) const
 {
     return StringUtils::format("%d", mPlayTimeMinutes / 60) + ":" + StringUtils::format("%02d", mPlayTimeMinutes % 60) + " hours";
 }
@@ -171,7 +459,7 @@ void Title::playTimeMinutes(u32 playTimeMinutes)
     mPlayTimeMinutes = playTimeMinutes;
 }
 
-u32 Title::lastPlayedTimestamp(void)
+u32 Title::lastPlayedTimestamp(void) const
 {
     return mLastPlayedTimestamp;
 }
@@ -205,8 +493,8 @@ void Title::refreshDirectories(void)
     }
 
     // save backups from configuration
-    std::vector<std::string> additionalFolders = Configuration::getInstance().additionalSaveFolders(mId);
-    for (std::vector<std::string>::const_iterator it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
+    Span<std::string> additionalFolders = Configuration::getInstance().additionalSaveFolders(mId);
+    for (const std::string* it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
         // we have other folders to parse
         Directory list(*it);
         if (list.good()) {
@@ -218,11 +506,38 @@ void Title::refreshDirectories(void)
             }
         }
     }
+    directoriesGeneration++;
+}
+
+static void publishTitles(void)
+{
+    auto next = std::make_shared<TitleSnapshot>();
+    for (const auto& pair : titles) {
+        for (const auto& title : pair.second) {
+            next->names.insert({StringUtils::format("0x%016llX", title.id()), title.name()});
+            next->paths.insert({title.id(), title.path()});
+        }
+    }
+
+    mutexLock(&snapshotMutex);
+    snapshot = std::move(next);
+    mutexUnlock(&snapshotMutex);
+}
+
+static std::shared_ptr<const TitleSnapshot> titleSnapshot(void)
+{
+    mutexLock(&snapshotMutex);
+    std::shared_ptr<const TitleSnapshot> current = snapshot;
+    mutexUnlock(&snapshotMutex);
+    return current;
 }
 
 void loadTitles(void)
 {
+    TRACE_SCOPE("loadTitles");
     titles.clear();
+    orders.clear();
+    indexes.clear();
 
     FsSaveDataInfoReader reader;
     FsSaveDataInfo info;
@@ -241,6 +556,7 @@ void loadTitles(void)
         free(nsacd);
         return;
     }
+    readThumbnails();
 
     while (1) {
         res = fsSaveDataInfoReaderRead(&reader, &info, 1, &total_entries);
@@ -292,54 +608,124 @@ void loadTitles(void)
 
     free(nsacd);
     fsSaveDataInfoReaderClose(&reader);
+    writeThumbnails();
 
     sortTitles();
+    for (auto& vect : titles) {
+        TitleIndex& index = indexes[vect.first];
+        for (auto& title : vect.second) {
+            index.add(title.name(), title.author(), title.id());
+        }
+    }
+    setTitleFilter(filter);
+    publishTitles();
+    titlesGeneration++;
+}
+
+u32 getTitlesGeneration(void)
+{
+    return titlesGeneration;
+}
+
+u32 getDirectoriesGeneration(void)
+{
+    return directoriesGeneration;
 }
 
 void sortTitles(void)
 {
+    orders.clear();
+    ordersConfig = Configuration::getInstance().generation();
     for (auto& vect : titles) {
-        std::sort(vect.second.begin(), vect.second.end(), [](Title& l, Title& r) {
-            if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-                return Configuration::getInstance().favorite(l.id());
-            }
-            switch (g_sortMode) {
-                case SORT_LAST_PLAYED:
-                    return l.lastPlayedTimestamp() > r.lastPlayedTimestamp();
-                case SORT_PLAY_TIME:
-                    return l.playTimeMinutes() > r.playTimeMinutes();
-                case SORT_ALPHA:
-                default:
-                    return l.name() < r.name();
+        std::vector<TitleSort::Item> items;
+        items.reserve(vect.second.size());
+        for (auto& title : vect.second) {
+            items.push_back({title.name(), Configuration::getInstance().favorite(title.id()), title.lastPlayedTimestamp(), title.playTimeMinutes()});
+        }
+        orders.emplace(vect.first, TitleSort::permutations(items));
+    }
+}
+
+static void updateViews(void)
+{
+    views.clear();
+    if (filter.empty()) {
+        return;
+    }
+    for (const auto& pair : orders) {
+        const std::vector<bool>& match = matches[pair.first];
+        TitleSort::Permutation& view   = views[pair.first];
+        for (u32 index : pair.second[g_sortMode]) {
+            if (match[index]) {
+                view.push_back(index);
             }
-        });
+        }
     }
 }
 
 void rotateSortMode(void)
 {
     g_sortMode = static_cast<sort_t>((g_sortMode + 1) % SORT_MODES_COUNT);
-    sortTitles();
+    // the cached orders are only valid for the favorites they were built with
+    if (ordersConfig != Configuration::getInstance().generation()) {
+        sortTitles();
+    }
+    updateViews();
+}
+
+void setTitleFilter(const std::string& query)
+{
+    TRACE_SCOPE("setTitleFilter");
+    filter = query;
+    matches.clear();
+    for (const auto& pair : indexes) {
+        pair.second.search(filter, matches[pair.first]);
+    }
+    updateViews();
+}
+
+std::string getTitleFilter(void)
+{
+    return filter;
+}
+
+static const TitleSort::Permutation* view(AccountUid uid)
+{
+    if (!filter.empty()) {
+        std::unordered_map<AccountUid, TitleSort::Permutation>::const_iterator it = views.find(uid);
+        return it != views.end() ? &it->second : nullptr;
+    }
+    std::unordered_map<AccountUid, std::array<TitleSort::Permutation, TitleSort::ORDER_COUNT>>::const_iterator it = orders.find(uid);
+    return it != orders.end() ? &it->second[g_sortMode] : nullptr;
+}
+
+const Title* titleAt(AccountUid uid, size_t i)
+{
+    const TitleSort::Permutation* indices = view(uid);
+    if (indices == nullptr || i >= indices->size()) {
+        return nullptr;
+    }
+    return &titles.at(uid).at(indices->at(i));
 }
 
 void getTitle(Title& dst, AccountUid uid, size_t i)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    if (it != titles.end() && i < getTitleCount(uid)) {
-        dst = it->second.at(i);
+    const Title* title = titleAt(uid, i);
+    if (title != nullptr) {
+        dst = *title;
     }
 }
 
 size_t getTitleCount(AccountUid uid)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? it->second.size() : 0;
+    const TitleSort::Permutation* indices = view(uid);
+    return indices != nullptr ? indices->size() : 0;
 }
 
 bool favorite(AccountUid uid, int i)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? Configuration::getInstance().favorite(it->second.at(i).id()) : false;
+    const Title* title = titleAt(uid, i);
+    return title != nullptr ? Configuration::getInstance().favorite(title->id()) : false;
 }
 
 void refreshDirectories(u64 id)
@@ -355,17 +741,20 @@ void refreshDirectories(u64 id)
 
 SDL_Texture* smallIcon(AccountUid uid, size_t i)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? it->second.at(i).icon() : NULL;
+    const Title* title = titleAt(uid, i);
+    if (title == nullptr) {
+        return NULL;
+    }
+    auto it = icons.find(title->id());
+    return it != icons.end() ? it->second : NULL;
 }
 
 std::unordered_map<std::string, std::string> getCompleteTitleList(void)
 {
-    std::unordered_map<std::string, std::string> map;
-    for (const auto& pair : titles) {
-        for (auto value : pair.second) {
-            map.insert({StringUtils::format("0x%016llX", value.id()), value.name()});
-        }
-    }
-    return map;
+    return titleSnapshot()->names;
+}
+
+std::unordered_map<u64, std::string> getTitleBackupPaths(void)
+{
+    return titleSnapshot()->paths;
 }
@@ -0,0 +1,126 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "cheatdatabase.hpp"
+#include "compression.hpp"
+#include "test.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+// a database with a single uncompressed title, laid out like tools/cheatdb.py writes them
+namespace {
+    struct Header {
+        char magic[4];
+        uint16_t version;
+        uint16_t codec;
+        uint32_t titles;
+        uint32_t reserved;
+    };
+
+    struct IndexEntry {
+        uint64_t id;
+        uint32_t offset;
+        uint32_t compressedSize;
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    // one build with one cheat of one line, then the string pool: "", "Cheat", "line"
+    const uint32_t BLOCK_TABLES[] = {1, 1, 1, 0, 0, 1, 1, 0, 1, 7};
+    const char BLOCK_POOL[]       = "\0Cheat\0line";
+
+    std::vector<uint8_t> block(void)
+    {
+        std::vector<uint8_t> data(sizeof(BLOCK_TABLES) + sizeof(BLOCK_POOL));
+        memcpy(data.data(), BLOCK_TABLES, sizeof(BLOCK_TABLES));
+        memcpy(data.data() + sizeof(BLOCK_TABLES), BLOCK_POOL, sizeof(BLOCK_POOL));
+        return data;
+    }
+
+    bool load(const std::vector<uint8_t>& file)
+    {
+        char path[] = "/tmp/cheatdatabase_testXXXXXX";
+        int fd      = mkstemp(path);
+        if (fd < 0 || write(fd, file.data(), file.size()) != (ssize_t)file.size()) {
+            return false;
+        }
+        close(fd);
+        CheatDatabase database;
+        bool ok = database.load(path);
+        if (ok) {
+            auto cheats = database.block(0x0100000000010000);
+            ok          = cheats != nullptr && cheats->builds() == 1 && cheats->cheats(0) == 1 && strcmp(cheats->cheatName(0, 0), "Cheat") == 0 &&
+                 cheats->lines(0, 0) == 1 && strcmp(cheats->line(0, 0, 0), "line") == 0;
+        }
+        unlink(path);
+        return ok;
+    }
+
+    // size 0 stands for the real size of the block
+    std::vector<uint8_t> database(uint32_t titles, uint32_t offset, uint32_t size = 0)
+    {
+        const std::vector<uint8_t> cheats = block();
+        Header header                     = {{'C', 'K', 'D', 'B'}, 1, Compression::CODEC_NONE, titles, 0};
+        IndexEntry entry                  = {0x0100000000010000, offset, (uint32_t)cheats.size(), size != 0 ? size : (uint32_t)cheats.size(), 0};
+        std::vector<uint8_t> file(sizeof(header) + sizeof(entry) + cheats.size());
+        memcpy(file.data(), &header, sizeof(header));
+        memcpy(file.data() + sizeof(header), &entry, sizeof(entry));
+        memcpy(file.data() + sizeof(header) + sizeof(entry), cheats.data(), cheats.size());
+        return file;
+    }
+}
+
+int main(void)
+{
+    const uint32_t blockOffset = sizeof(Header) + sizeof(IndexEntry);
+    CHECK(load(database(1, blockOffset)));
+
+    // title counts that don't fit in the file are rejected before the index is allocated. The block leaves room for
+    // three index entries, they would be read as such
+    CHECK(!load(database(4, blockOffset)));
+    CHECK(!load(database(0xFFFFFFFF, blockOffset)));
+    std::vector<uint8_t> truncated = database(1, blockOffset);
+    truncated.resize(sizeof(Header) + 4);
+    CHECK(!load(truncated));
+
+    // blocks must lie inside the file
+    CHECK(!load(database(1, blockOffset + 1)));
+    CHECK(!load(database(1, 0xFFFFFFF0)));
+
+    // decoded sizes are read from the file too, they are checked before anything is allocated for them
+    CHECK(!load(database(1, blockOffset, 0xFFFFFFFF)));
+    CHECK(!load(database(1, blockOffset, sizeof(BLOCK_TABLES) + sizeof(BLOCK_POOL) + 1)));
+
+    // titles without any cheat produce empty tables
+    auto empty = CheatBlock::fromJson(nlohmann::json::object());
+    CHECK(empty != nullptr);
+    auto noLines = CheatBlock::fromJson(nlohmann::json::parse(R"({"Cheat": []})"));
+    CHECK(noLines != nullptr && noLines->good() && noLines->builds() == 1 && noLines->cheats(0) == 1 && noLines->lines(0, 0) == 0);
+
+    return testResult();
+}
@@ -0,0 +1,242 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// decompression benchmark of cheat databases written by tools/cheatdb.py, through the same decoders the consoles use.
+// every title block is decompressed into a freshly allocated buffer, like CheatDatabase::block does, and the heap
+// high-water mark above the starting point is reported along with the timings.
+//   compression_bench database.bin [database.bin...]
+
+#include "compression.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <malloc.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// glibc entry points, wrapped below so that allocations made inside libbz2 and libzstd are counted too
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+    std::atomic<size_t> heapCurrent(0);
+    std::atomic<size_t> heapPeak(0);
+
+    void* allocated(void* ptr)
+    {
+        if (ptr != NULL) {
+            size_t current = heapCurrent.fetch_add(malloc_usable_size(ptr)) + malloc_usable_size(ptr);
+            size_t peak    = heapPeak.load();
+            while (current > peak && !heapPeak.compare_exchange_weak(peak, current)) {
+            }
+        }
+        return ptr;
+    }
+
+    void released(void* ptr)
+    {
+        if (ptr != NULL) {
+            heapCurrent.fetch_sub(malloc_usable_size(ptr));
+        }
+    }
+}
+
+extern "C" {
+void* malloc(size_t size)
+{
+    return allocated(__libc_malloc(size));
+}
+
+void* calloc(size_t count, size_t size)
+{
+    return allocated(__libc_calloc(count, size));
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    released(ptr);
+    void* result = __libc_realloc(ptr, size);
+    // a failed realloc keeps the original block
+    return allocated(result != NULL || size == 0 ? result : ptr);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    return allocated(__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return allocated(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    *ptr = allocated(__libc_memalign(alignment, size));
+    return *ptr != NULL || size == 0 ? 0 : ENOMEM;
+}
+
+void free(void* ptr)
+{
+    released(ptr);
+    __libc_free(ptr);
+}
+}
+
+namespace {
+    struct Header {
+        char magic[4];
+        uint16_t version;
+        uint16_t codec;
+        uint32_t titles;
+        uint32_t reserved;
+    };
+
+    struct IndexEntry {
+        uint64_t id;
+        uint32_t offset;
+        uint32_t compressedSize;
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    struct Block {
+        std::vector<uint8_t> compressed;
+        size_t size;
+    };
+
+    const double MIN_SECONDS = 0.5;
+
+    bool readDatabase(const char* path, uint16_t& codec, std::vector<Block>& blocks)
+    {
+        FILE* f = fopen(path, "rb");
+        if (f == NULL) {
+            fprintf(stderr, "%s: cannot open\n", path);
+            return false;
+        }
+
+        Header header;
+        std::vector<IndexEntry> index;
+        bool ok = fread(&header, sizeof(Header), 1, f) == 1 && memcmp(header.magic, "CKDB", 4) == 0 && header.version == 1;
+        if (ok) {
+            index.resize(header.titles);
+            ok = fread(index.data(), sizeof(IndexEntry), index.size(), f) == index.size();
+        }
+        for (size_t i = 0; ok && i < index.size(); i++) {
+            Block block{std::vector<uint8_t>(index[i].compressedSize), index[i].size};
+            ok = fseek(f, index[i].offset, SEEK_SET) == 0 &&
+                 fread(block.compressed.data(), 1, block.compressed.size(), f) == block.compressed.size();
+            blocks.push_back(std::move(block));
+        }
+        fclose(f);
+
+        if (!ok) {
+            fprintf(stderr, "%s: not a cheat database\n", path);
+            return false;
+        }
+        codec = header.codec;
+        return true;
+    }
+
+    // one pass over every block, returns false when a block does not decode
+    bool decompressAll(uint16_t codec, const std::vector<Block>& blocks, double& slowest)
+    {
+        for (const Block& block : blocks) {
+            auto start = std::chrono::steady_clock::now();
+            std::unique_ptr<uint8_t[]> data(new uint8_t[block.size]);
+            if (!Compression::decompress(codec, data.get(), block.size, block.compressed.data(), block.compressed.size())) {
+                return false;
+            }
+            slowest = std::max(slowest, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s database.bin [database.bin...]\n", argv[0]);
+        return 2;
+    }
+
+    int res = 0;
+    printf("%-24s %-6s %12s %12s %7s %10s %10s %10s %12s\n", "database", "codec", "compressed", "raw", "ratio", "pass ms", "MB/s",
+        "worst us", "peak heap");
+    for (int i = 1; i < argc; i++) {
+        const char* name = strrchr(argv[i], '/') != NULL ? strrchr(argv[i], '/') + 1 : argv[i];
+        uint16_t codec;
+        std::vector<Block> blocks;
+        if (!readDatabase(argv[i], codec, blocks)) {
+            res = 1;
+            continue;
+        }
+        if (!Compression::available(codec)) {
+            printf("%-24s %-6s not built into this benchmark\n", name, Compression::name(codec));
+            continue;
+        }
+
+        size_t compressed = 0, raw = 0;
+        for (const Block& block : blocks) {
+            compressed += block.compressed.size();
+            raw += block.size;
+        }
+
+        // the first pass takes the heap high-water mark and warms up the caches, it is not timed
+        double slowest = 0;
+        heapPeak       = heapCurrent.load();
+        size_t base    = heapCurrent.load();
+        if (!decompressAll(codec, blocks, slowest)) {
+            fprintf(stderr, "%s: a block failed to decompress\n", argv[i]);
+            res = 1;
+            continue;
+        }
+        size_t peak = heapPeak.load() - base;
+        slowest     = 0;
+
+        size_t passes = 0;
+        auto start    = std::chrono::steady_clock::now();
+        double elapsed;
+        do {
+            decompressAll(codec, blocks, slowest);
+            passes++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < MIN_SECONDS);
+
+        const double pass = elapsed / passes;
+        printf("%-24s %-6s %12zu %12zu %7.2f %10.3f %10.1f %10.1f %12zu\n", name, Compression::name(codec), compressed, raw,
+            (double)raw / std::max<size_t>(compressed, 1), pass * 1e3, raw / pass / 1e6, slowest * 1e6, peak);
+    }
+    return res;
+}
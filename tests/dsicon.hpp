@@ -0,0 +1,58 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef DSICON_HPP
+#define DSICON_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the per pixel DS icon decoder 3ds/source/title.cpp used before Image::decodeDS, the test and the benchmark compare
+// against it
+inline void decodeDSReference(uint16_t* output, const uint8_t* data, const uint16_t* palette)
+{
+    for (size_t x = 0; x < 32; x++) {
+        for (size_t y = 0; y < 32; y++) {
+            uint32_t srcOff   = (((y >> 3) * 4 + (x >> 3)) * 8 + (y & 7)) * 4 + ((x & 7) >> 1);
+            uint32_t srcShift = (x & 1) * 4;
+
+            uint16_t pIndex = (data[srcOff] >> srcShift) & 0xF;
+            uint16_t color  = 0xFFFF;
+            if (pIndex != 0) {
+                uint16_t r = palette[pIndex] & 0x1F;
+                uint16_t g = (palette[pIndex] >> 5) & 0x1F;
+                uint16_t b = (palette[pIndex] >> 10) & 0x1F;
+                color      = (r << 11) | (g << 6) | (g >> 4) | (b);
+            }
+
+            uint32_t dst = ((((y >> 3) * (32 >> 3) + (x >> 3)) << 6) +
+                            ((x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3)));
+            output[dst] = color;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// throughput of the ftp server in 3rd-party/ftp over 127.0.0.1, in MB/s. The server runs on its own thread the way
+// the Switch network thread drives it, the client downloads and uploads one file with 64 KiB socket calls.
+// ftp_bench uses sendfile() for downloads like any linux host would, ftp_buffered_bench is built with FTP_NO_SENDFILE
+// and goes through the pooled buffers like the consoles do
+//   ftp_bench [megabytes]
+
+extern "C" {
+#include "ftp.h"
+}
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// the consoles listen on their own address, glibc's host id is not one: answer with loopback instead
+long gethostid(void) noexcept
+{
+    return htonl(INADDR_LOOPBACK);
+}
+
+namespace {
+    constexpr size_t BUFFER_SIZE = 0x10000;
+    constexpr in_port_t PORT     = 50000;
+
+    std::atomic<bool> stop = false;
+    std::string lastReply;
+
+    void serve(void)
+    {
+        struct pollfd fds[16];
+        while (!stop) {
+            int n = ftp_pollfds(fds, 16);
+            poll(fds, n < 16 ? n : 16, 10);
+            ftp_loop();
+        }
+    }
+
+    int connectTo(in_port_t port)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = htons(port);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            perror("connect");
+            exit(1);
+        }
+        return fd;
+    }
+
+    // reads a whole reply, multi-line ones end with the code followed by a space
+    int reply(int fd)
+    {
+        for (;;) {
+            lastReply.clear();
+            char c;
+            while (recv(fd, &c, 1, 0) == 1 && c != '\n') {
+                lastReply += c;
+            }
+            if (lastReply.size() < 4) {
+                fprintf(stderr, "connection lost\n");
+                exit(1);
+            }
+            if (lastReply[3] == ' ') {
+                return atoi(lastReply.c_str());
+            }
+        }
+    }
+
+    int command(int fd, const std::string& line)
+    {
+        std::string request = line + "\r\n";
+        send(fd, request.data(), request.size(), 0);
+        return reply(fd);
+    }
+
+    void expect(int code, int expected, const char* what)
+    {
+        if (code != expected) {
+            fprintf(stderr, "%s: %s\n", what, lastReply.c_str());
+            exit(1);
+        }
+    }
+
+    int openData(int fd)
+    {
+        expect(command(fd, "PASV"), 227, "PASV");
+        unsigned a, b, c, d, p1, p2;
+        // the address follows the code, without the parentheses most servers put around it
+        if (sscanf(lastReply.c_str() + 4, "%u,%u,%u,%u,%u,%u", &a, &b, &c, &d, &p1, &p2) != 6) {
+            expect(0, 227, "PASV");
+        }
+        return connectTo(p1 << 8 | p2);
+    }
+
+    size_t retrieve(int fd, const std::string& path)
+    {
+        int data = openData(fd);
+        expect(command(fd, "RETR " + path), 150, "RETR");
+        std::vector<char> buffer(BUFFER_SIZE);
+        size_t total = 0;
+        ssize_t n;
+        while ((n = recv(data, buffer.data(), buffer.size(), 0)) > 0) {
+            total += n;
+        }
+        close(data);
+        expect(reply(fd), 226, "RETR");
+        return total;
+    }
+
+    void store(int fd, const std::string& path, const std::vector<char>& payload)
+    {
+        int data = openData(fd);
+        expect(command(fd, "STOR " + path), 150, "STOR");
+        for (size_t offset = 0; offset < payload.size();) {
+            ssize_t n = send(data, payload.data() + offset, std::min(BUFFER_SIZE, payload.size() - offset), 0);
+            if (n <= 0) {
+                expect(0, 226, "STOR");
+            }
+            offset += n;
+        }
+        close(data);
+        expect(reply(fd), 226, "STOR");
+    }
+
+    template <typename F>
+    double measure(size_t size, F&& run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        return size / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 1e6;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? atoi(argv[1]) : 256) * (size_t)(1 << 20);
+    if (size == 0) {
+        fprintf(stderr, "usage: %s [megabytes]\n", argv[0]);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    if (ftp_init() != 0) {
+        perror("ftp_init");
+        return 1;
+    }
+    std::thread server(serve);
+
+    char tmpl[]          = "/tmp/checkpoint-ftp-XXXXXX";
+    std::string root     = mkdtemp(tmpl);
+    std::string download = root + "/download.bin";
+    std::string upload   = root + "/upload.bin";
+    std::vector<char> payload(size);
+    for (auto& byte : payload) {
+        byte = rand();
+    }
+    FILE* f = fopen(download.c_str(), "wb");
+    fwrite(payload.data(), 1, payload.size(), f);
+    fclose(f);
+
+    int fd = connectTo(PORT);
+    expect(reply(fd), 220, "connect");
+    expect(command(fd, "USER anonymous"), 230, "USER");
+    expect(command(fd, "TYPE I"), 200, "TYPE");
+
+    // one untimed pass each to warm the page cache and the transfer buffer pool
+    retrieve(fd, download);
+    store(fd, upload, payload);
+
+    size_t received = 0;
+    double retr     = measure(size, [&] { received = retrieve(fd, download); });
+    double stor     = measure(size, [&] { store(fd, upload, payload); });
+    struct stat st;
+    if (received != size || stat(upload.c_str(), &st) != 0 || (size_t)st.st_size != size) {
+        fprintf(stderr, "size mismatch\n");
+        return 1;
+    }
+    printf("%10s %12s %12s\n", "MB", "RETR MB/s", "STOR MB/s");
+    printf("%10zu %12.0f %12.0f\n", size >> 20, retr, stor);
+
+    command(fd, "QUIT");
+    close(fd);
+    stop = true;
+    server.join();
+    ftp_exit();
+    unlink(download.c_str());
+    unlink(upload.c_str());
+    rmdir(root.c_str());
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "hash.hpp"
+#include "test.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static std::string hex(const uint8_t* data, size_t len)
+{
+    std::string out;
+    char digits[3];
+    for (size_t i = 0; i < len; i++) {
+        snprintf(digits, sizeof(digits), "%02x", data[i]);
+        out += digits;
+    }
+    return out;
+}
+
+static void testSha256(void)
+{
+    // FIPS 180-2 examples
+    static const struct {
+        const char* message;
+        const char* digest;
+    } vectors[] = {
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    };
+    uint8_t hash[Hash::SHA256_SIZE];
+    for (const auto& vector : vectors) {
+        Hash::sha256(hash, vector.message, strlen(vector.message));
+        CHECK(hex(hash, sizeof(hash)) == vector.digest);
+    }
+
+    std::vector<uint8_t> million(1000000, 'a');
+    Hash::sha256(hash, million.data(), million.size());
+    CHECK(hex(hash, sizeof(hash)) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+static void testIncremental(void)
+{
+    // splitting the input anywhere, across block boundaries too, must not change the result
+    std::vector<uint8_t> data(4099);
+    for (auto& byte : data) {
+        byte = rand();
+    }
+    uint8_t expected[Hash::SHA256_SIZE], hash[Hash::SHA256_SIZE];
+    Hash::sha256(expected, data.data(), data.size());
+    const uint64_t expected64 = Hash::fast64(data.data(), data.size(), 42);
+
+    for (size_t chunk : {1, 3, 63, 64, 65, 500, 4099}) {
+        Hash::Sha256 sha256;
+        Hash::Fast64 fast64(42);
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            const size_t len = offset + chunk > data.size() ? data.size() - offset : chunk;
+            sha256.update(data.data() + offset, len);
+            fast64.update(data.data() + offset, len);
+        }
+        sha256.finish(hash);
+        CHECK(memcmp(hash, expected, sizeof(hash)) == 0);
+        CHECK(fast64.finish() == expected64);
+    }
+}
+
+static void testFast64(void)
+{
+    // every length up to a few stripes goes through a different tail, each of them has to depend on every byte
+    std::vector<uint8_t> data(300);
+    for (auto& byte : data) {
+        byte = rand();
+    }
+    for (size_t len = 1; len <= data.size(); len++) {
+        const uint64_t hash = Hash::fast64(data.data(), len);
+        CHECK(Hash::fast64(data.data(), len, 1) != hash);
+        for (size_t i = 0; i < len; i++) {
+            data[i] ^= 1;
+            CHECK(Hash::fast64(data.data(), len) != hash);
+            data[i] ^= 1;
+        }
+    }
+}
+
+int main(void)
+{
+    srand(7);
+    testSha256();
+    testIncremental();
+    testFast64();
+    return testResult();
+}
@@ -0,0 +1,83 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// throughput of the hashes in common/hash.cpp over buffers of increasing size, in GB/s. Every size is hashed over
+// and over until about the same amount of data went through, so small sizes show the per-call overhead
+//   hash_bench [megabytes per measurement]
+
+#include "hash.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+    constexpr size_t SIZES[] = {16, 64, 256, 1024, 4096, 65536, 1 << 20, 16 << 20};
+
+    template <typename F>
+    double measure(size_t size, size_t total, F&& run)
+    {
+        size_t iterations = total / size > 0 ? total / size : 1;
+        // one untimed pass to fault the buffer in
+        run();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            run();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return (double)size * iterations / elapsed / 1e9;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t total = (argc > 1 ? atoi(argv[1]) : 256) * (size_t)(1 << 20);
+    if (total == 0) {
+        fprintf(stderr, "usage: %s [megabytes per measurement]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> data(SIZES[sizeof(SIZES) / sizeof(SIZES[0]) - 1]);
+    for (auto& byte : data) {
+        byte = rand();
+    }
+
+    // the results are folded together and printed, so that no call can be dropped
+    uint64_t sink = 0;
+    printf("%10s %12s %12s\n", "bytes", "sha256 GB/s", "fast64 GB/s");
+    for (size_t size : SIZES) {
+        double sha256 = measure(size, total / 8, [&] {
+            uint8_t hash[Hash::SHA256_SIZE];
+            Hash::sha256(hash, data.data(), size);
+            sink += hash[0];
+        });
+        double fast64 = measure(size, total, [&] { sink += Hash::fast64(data.data(), size, sink); });
+        printf("%10zu %12.3f %12.3f\n", size, sha256, fast64);
+    }
+    printf("(%016llx)\n", (unsigned long long)sink);
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "dsicon.hpp"
+#include "image.hpp"
+#include "test.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// the same checks run against the native build of common/image.cpp and against its NEON code path, which is built with
+// the intrinsics emulated on hosts without NEON. Both are compared with the straightforward definitions below
+
+static void testTiling(void)
+{
+    for (size_t width : {8, 32, 48, 64}) {
+        for (size_t height : {8, 16, 48}) {
+            std::vector<uint16_t> linear(width * height), tiled(width * height), back(width * height);
+            for (auto& pixel : linear) {
+                pixel = rand();
+            }
+            Image::tile(tiled.data(), linear.data(), width, height);
+            Image::untile(back.data(), tiled.data(), width, height);
+            CHECK(back == linear);
+
+            // 8x8 tiles row by row, Morton order inside each of them
+            for (size_t y = 0; y < height; y++) {
+                for (size_t x = 0; x < width; x++) {
+                    size_t tile   = (y >> 3) * (width >> 3) + (x >> 3);
+                    size_t morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+                    CHECK(tiled[tile * 64 + morton] == linear[y * width + x]);
+                }
+            }
+
+            std::vector<uint32_t> linear32(width * height), tiled32(width * height), back32(width * height);
+            for (auto& pixel : linear32) {
+                pixel = rand();
+            }
+            Image::tile(tiled32.data(), linear32.data(), width, height);
+            Image::untile(back32.data(), tiled32.data(), width, height);
+            CHECK(back32 == linear32);
+        }
+    }
+}
+
+static void testCopyTiled(void)
+{
+    // a 48x48 SMDH icon into the top left corner of a 64x64 texture, read from an unaligned buffer
+    std::vector<uint16_t> icon(48 * 48), expected(64 * 64, 0), texture(64 * 64, 0);
+    for (auto& pixel : icon) {
+        pixel = rand();
+    }
+    for (size_t row = 0; row < 48 / 8; row++) {
+        memcpy(expected.data() + (64 - 48) * 64 + row * 64 * 8, icon.data() + row * 48 * 8, 48 * 8 * sizeof(uint16_t));
+    }
+
+    std::vector<uint8_t> unaligned(icon.size() * sizeof(uint16_t) + 1);
+    memcpy(unaligned.data() + 1, icon.data(), icon.size() * sizeof(uint16_t));
+    Image::copyTiled(texture.data() + (64 - 48) * 64, 64, unaligned.data() + 1, 48, 48, sizeof(uint16_t));
+    CHECK(texture == expected);
+}
+
+static void testRgb565(void)
+{
+    // odd counts leave a tail for the scalar loop, 65536 covers every color
+    for (size_t count : {0, 1, 7, 8, 9, 65536}) {
+        std::vector<uint16_t> colors(count), back(count);
+        for (size_t i = 0; i < count; i++) {
+            colors[i] = count == 65536 ? i : rand();
+        }
+        std::vector<uint8_t> rgba(count * 4);
+        Image::rgb565ToRgba8(rgba.data(), colors.data(), count);
+        Image::rgba8ToRgb565(back.data(), rgba.data(), count);
+        CHECK(back == colors);
+
+        for (size_t i = 0; i < count; i++) {
+            const int r = colors[i] >> 11, g = (colors[i] >> 5) & 63, b = colors[i] & 31;
+            CHECK(rgba[i * 4 + 0] == ((r << 3) | (r >> 2)));
+            CHECK(rgba[i * 4 + 1] == ((g << 2) | (g >> 4)));
+            CHECK(rgba[i * 4 + 2] == ((b << 3) | (b >> 2)));
+            CHECK(rgba[i * 4 + 3] == 255);
+        }
+    }
+
+    std::vector<uint8_t> rgba(1001 * 4);
+    std::vector<uint16_t> colors(1001);
+    for (auto& channel : rgba) {
+        channel = rand();
+    }
+    Image::rgba8ToRgb565(colors.data(), rgba.data(), colors.size());
+    for (size_t i = 0; i < colors.size(); i++) {
+        CHECK(colors[i] == (((rgba[i * 4] >> 3) << 11) | ((rgba[i * 4 + 1] >> 2) << 5) | (rgba[i * 4 + 2] >> 3)));
+    }
+}
+
+static void testColorKey(void)
+{
+    const size_t count = 1003;
+    std::vector<uint8_t> pixels(count * 4);
+    for (size_t i = 0; i < count; i++) {
+        pixels[i * 4 + 0] = rand() % 2;
+        pixels[i * 4 + 1] = rand() % 2;
+        pixels[i * 4 + 2] = rand() % 2;
+        pixels[i * 4 + 3] = rand();
+    }
+
+    std::vector<uint8_t> expected = pixels;
+    for (size_t i = 0; i < count; i++) {
+        if (expected[i * 4] == 0 && expected[i * 4 + 1] == 0 && expected[i * 4 + 2] == 0) {
+            expected[i * 4 + 3] = 0;
+        }
+    }
+    Image::colorKey(pixels.data(), count, 0, 0, 0);
+    CHECK(pixels == expected);
+}
+
+static void testDownscale(void)
+{
+    // odd sizes drop the partial blocks, padded pitches must be respected on both sides
+    for (size_t factor : {1, 2, 3, 4}) {
+        for (size_t width : {7, 16, 33, 256}) {
+            for (size_t height : {2, 9, 256}) {
+                const size_t srcPitch = width * 4 + 12, dstWidth = width / factor, dstHeight = height / factor, dstPitch = dstWidth * 4 + 4;
+                std::vector<uint8_t> src(srcPitch * height), dst(dstPitch * dstHeight + 1, 0xAB), expected(dst);
+                for (auto& channel : src) {
+                    channel = rand();
+                }
+
+                for (size_t y = 0; y < dstHeight; y++) {
+                    for (size_t x = 0; x < dstWidth; x++) {
+                        for (size_t c = 0; c < 4; c++) {
+                            unsigned sum = 0;
+                            for (size_t j = 0; j < factor; j++) {
+                                for (size_t k = 0; k < factor; k++) {
+                                    sum += src[(y * factor + j) * srcPitch + (x * factor + k) * 4 + c];
+                                }
+                            }
+                            expected[y * dstPitch + x * 4 + c] = (sum + factor * factor / 2) / (factor * factor);
+                        }
+                    }
+                }
+
+                Image::downscale(dst.data(), dstPitch, src.data(), srcPitch, width, height, factor);
+                for (size_t y = 0; y < dstHeight; y++) {
+                    CHECK(memcmp(dst.data() + y * dstPitch, expected.data() + y * dstPitch, dstWidth * 4) == 0);
+                }
+                CHECK(dst.back() == 0xAB);
+            }
+        }
+    }
+}
+
+static void testDecodeDS(void)
+{
+    uint8_t data[512];
+    uint16_t palette[16];
+    std::vector<uint16_t> decoded(32 * 32), expected(32 * 32);
+    for (int banner = 0; banner < 100; banner++) {
+        for (auto& byte : data) {
+            byte = rand();
+        }
+        for (auto& color : palette) {
+            color = rand();
+        }
+        Image::decodeDS(decoded.data(), data, palette);
+        decodeDSReference(expected.data(), data, palette);
+        CHECK(decoded == expected);
+    }
+
+    // index 0 is white whatever the palette says, the left pixel of a pair is in the low nibble
+    memset(data, 0, sizeof(data));
+    data[0]    = 0x10;
+    palette[0] = 0x1234;
+    palette[1] = 0x001F;
+    Image::decodeDS(decoded.data(), data, palette);
+    CHECK(decoded[0] == 0xFFFF);
+    CHECK(decoded[Image::TILE_SWIZZLE[1]] == 0xF800);
+}
+
+int main(void)
+{
+    srand(7);
+    testTiling();
+    testCopyTiled();
+    testRgb565();
+    testColorKey();
+    testDownscale();
+    testDecodeDS();
+    return testResult();
+}
@@ -0,0 +1,129 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// timings of the pixel helpers in common/image.cpp on a 256x256 RGBA8 image, the size of a Switch title icon, and of
+// the DS icon decoder against the per pixel one it replaced.
+// on AArch64 hosts image_scalar_bench is built too, with the NEON paths disabled, so the two can be compared
+//   image_bench [iterations]
+
+#include "dsicon.hpp"
+#include "image.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+    constexpr size_t SIDE = 256;
+
+    template <typename F>
+    void measure(const char* name, int iterations, F&& run)
+    {
+        // one untimed pass to fault the buffers in
+        run(0);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            run(i);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-16s %10.2f %10.1f\n", name, elapsed * 1e6 / iterations, SIDE * SIDE / (elapsed * 1e6 / iterations));
+    }
+
+    template <typename F>
+    void measureIcons(const char* name, int iterations, size_t icons, F&& decode)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            for (size_t icon = 0; icon < icons; icon++) {
+                decode(icon);
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-16s %10.3f\n", name, elapsed * 1e6 / iterations / icons);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> rgba(SIDE * SIDE * 4), small(SIDE / 2 * SIDE / 2 * 4);
+    std::vector<uint16_t> rgb565(SIDE * SIDE), tiled(SIDE * SIDE);
+    for (auto& channel : rgba) {
+        channel = rand();
+    }
+    for (auto& pixel : rgb565) {
+        pixel = rand();
+    }
+
+    // every pass touches its input, so that the calls cannot be hoisted out of the loops
+    printf("%-16s %10s %10s\n", "256x256", "us", "Mpixel/s");
+    measure("downscale/2", iterations, [&](int i) {
+        rgba[i % rgba.size()] ^= 1;
+        Image::downscale(small.data(), SIDE / 2 * 4, rgba.data(), SIDE * 4, SIDE, SIDE, 2);
+    });
+    measure("colorKey", iterations, [&](int i) {
+        rgba[i % rgba.size()] ^= 1;
+        Image::colorKey(rgba.data(), SIDE * SIDE, 0, 0, 0);
+    });
+    measure("rgba8ToRgb565", iterations, [&](int i) {
+        rgba[i % rgba.size()] ^= 1;
+        Image::rgba8ToRgb565(rgb565.data(), rgba.data(), SIDE * SIDE);
+    });
+    measure("rgb565ToRgba8", iterations, [&](int i) {
+        rgb565[i % rgb565.size()] ^= 1;
+        Image::rgb565ToRgba8(rgba.data(), rgb565.data(), SIDE * SIDE);
+    });
+    measure("tile", iterations, [&](int i) {
+        rgb565[i % rgb565.size()] ^= 1;
+        Image::tile(tiled.data(), rgb565.data(), SIDE, SIDE);
+    });
+    measure("untile", iterations, [&](int i) {
+        tiled[i % tiled.size()] ^= 1;
+        Image::untile(rgb565.data(), tiled.data(), SIDE, SIDE);
+    });
+
+    // a 32x32 icon is too quick to time alone, every pass decodes a batch of different ones
+    constexpr size_t ICONS = 64;
+    std::vector<uint8_t> banners(ICONS * 512);
+    std::vector<uint16_t> palettes(ICONS * 16), icon(32 * 32);
+    for (auto& byte : banners) {
+        byte = rand();
+    }
+    for (auto& color : palettes) {
+        color = rand();
+    }
+    printf("\n%-16s %10s\n", "32x32 DS icon", "us/icon");
+    measureIcons("per pixel", iterations, ICONS, [&](size_t i) { decodeDSReference(icon.data(), &banners[i * 512], &palettes[i * 16]); });
+    measureIcons("decodeDS", iterations, ICONS, [&](size_t i) { Image::decodeDS(icon.data(), &banners[i * 512], &palettes[i * 16]); });
+    printf("(%04x)\n", icon[0]);
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// scalar stand-ins for the NEON intrinsics used in common/, so that the NEON code paths can be built and checked on
+// hosts without NEON. Only meant for tests, every lane is computed one at a time
+#ifndef ARM_NEON_EMULATION_H
+#define ARM_NEON_EMULATION_H
+
+#include <stdint.h>
+#include <string.h>
+
+template <typename T, int N>
+struct NeonVector {
+    T v[N];
+};
+
+typedef NeonVector<uint8_t, 8> uint8x8_t;
+typedef NeonVector<uint8_t, 16> uint8x16_t;
+typedef NeonVector<uint16_t, 8> uint16x8_t;
+typedef NeonVector<uint32_t, 4> uint32x4_t;
+
+struct uint8x8x4_t {
+    uint8x8_t val[4];
+};
+
+struct uint32x4x2_t {
+    uint32x4_t val[2];
+};
+
+template <typename To, typename From>
+inline To neonReinterpret(const From& from)
+{
+    static_assert(sizeof(To) == sizeof(From), "reinterpreted vectors must have the same size");
+    To to;
+    memcpy(&to, &from, sizeof(To));
+    return to;
+}
+
+// loads and stores
+inline uint8x16_t vld1q_u8(const uint8_t* p)
+{
+    uint8x16_t r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+
+inline uint16x8_t vld1q_u16(const uint16_t* p)
+{
+    uint16x8_t r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+
+inline void vst1q_u8(uint8_t* p, uint8x16_t a)
+{
+    memcpy(p, a.v, sizeof(a.v));
+}
+
+inline void vst1q_u16(uint16_t* p, uint16x8_t a)
+{
+    memcpy(p, a.v, sizeof(a.v));
+}
+
+inline uint8x8x4_t vld4_u8(const uint8_t* p)
+{
+    uint8x8x4_t r;
+    for (int i = 0; i < 8; i++) {
+        for (int c = 0; c < 4; c++) {
+            r.val[c].v[i] = p[i * 4 + c];
+        }
+    }
+    return r;
+}
+
+inline void vst4_u8(uint8_t* p, uint8x8x4_t a)
+{
+    for (int i = 0; i < 8; i++) {
+        for (int c = 0; c < 4; c++) {
+            p[i * 4 + c] = a.val[c].v[i];
+        }
+    }
+}
+
+inline uint32x4x2_t vld2q_u32(const uint32_t* p)
+{
+    uint32x4x2_t r;
+    for (int i = 0; i < 4; i++) {
+        memcpy(&r.val[0].v[i], p + 2 * i, sizeof(uint32_t));
+        memcpy(&r.val[1].v[i], p + 2 * i + 1, sizeof(uint32_t));
+    }
+    return r;
+}
+
+// lane moves
+inline uint8x8_t vdup_n_u8(uint8_t x)
+{
+    uint8x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = x;
+    }
+    return r;
+}
+
+inline uint32x4_t vdupq_n_u32(uint32_t x)
+{
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = x;
+    }
+    return r;
+}
+
+inline uint8x8_t vget_low_u8(uint8x16_t a)
+{
+    uint8x8_t r;
+    memcpy(r.v, a.v, 8);
+    return r;
+}
+
+inline uint8x8_t vget_high_u8(uint8x16_t a)
+{
+    uint8x8_t r;
+    memcpy(r.v, a.v + 8, 8);
+    return r;
+}
+
+inline uint8x16_t vcombine_u8(uint8x8_t low, uint8x8_t high)
+{
+    uint8x16_t r;
+    memcpy(r.v, low.v, 8);
+    memcpy(r.v + 8, high.v, 8);
+    return r;
+}
+
+inline uint8x8_t vmovn_u16(uint16x8_t a)
+{
+    uint8x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = (uint8_t)a.v[i];
+    }
+    return r;
+}
+
+inline uint32x4_t vreinterpretq_u32_u8(uint8x16_t a)
+{
+    return neonReinterpret<uint32x4_t>(a);
+}
+
+inline uint8x16_t vreinterpretq_u8_u32(uint32x4_t a)
+{
+    return neonReinterpret<uint8x16_t>(a);
+}
+
+// arithmetic
+inline uint16x8_t vaddl_u8(uint8x8_t a, uint8x8_t b)
+{
+    uint16x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = a.v[i] + b.v[i];
+    }
+    return r;
+}
+
+inline uint16x8_t vaddq_u16(uint16x8_t a, uint16x8_t b)
+{
+    uint16x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = a.v[i] + b.v[i];
+    }
+    return r;
+}
+
+inline uint32x4_t vceqq_u32(uint32x4_t a, uint32x4_t b)
+{
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = a.v[i] == b.v[i] ? ~0u : 0;
+    }
+    return r;
+}
+
+inline uint32x4_t vandq_u32(uint32x4_t a, uint32x4_t b)
+{
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = a.v[i] & b.v[i];
+    }
+    return r;
+}
+
+inline uint32x4_t vbicq_u32(uint32x4_t a, uint32x4_t b)
+{
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = a.v[i] & ~b.v[i];
+    }
+    return r;
+}
+
+// shifts, the immediates are template arguments in disguise on real NEON, plain arguments here
+inline uint16x8_t vshll_n_u8(uint8x8_t a, int n)
+{
+    uint16x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = (uint16_t)(a.v[i] << n);
+    }
+    return r;
+}
+
+inline uint16x8_t vshlq_n_u16(uint16x8_t a, int n)
+{
+    uint16x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = (uint16_t)(a.v[i] << n);
+    }
+    return r;
+}
+
+inline uint8x8_t vshrn_n_u16(uint16x8_t a, int n)
+{
+    uint8x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = (uint8_t)(a.v[i] >> n);
+    }
+    return r;
+}
+
+inline uint8x8_t vrshrn_n_u16(uint16x8_t a, int n)
+{
+    uint8x8_t r;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = (uint8_t)((a.v[i] + (1 << (n - 1))) >> n);
+    }
+    return r;
+}
+
+// shift right and insert, keeps the top n bits of a
+inline uint8x8_t vsri_n_u8(uint8x8_t a, uint8x8_t b, int n)
+{
+    uint8x8_t r;
+    const uint8_t mask = 0xFF >> n;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = (uint8_t)((a.v[i] & ~mask) | (b.v[i] >> n));
+    }
+    return r;
+}
+
+inline uint16x8_t vsriq_n_u16(uint16x8_t a, uint16x8_t b, int n)
+{
+    uint16x8_t r;
+    const uint16_t mask = 0xFFFF >> n;
+    for (int i = 0; i < 8; i++) {
+        r.v[i] = (uint16_t)((a.v[i] & ~mask) | (b.v[i] >> n));
+    }
+    return r;
+}
+
+#endif
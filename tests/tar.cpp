@@ -0,0 +1,271 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "tar.hpp"
+#include "test.hpp"
+#include <filesystem>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> payload(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = rand();
+    }
+    return data;
+}
+
+static void writeFile(const fs::path& path, const std::vector<uint8_t>& data)
+{
+    fs::create_directories(path.parent_path());
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static std::vector<uint8_t> readFile(const fs::path& path)
+{
+    std::vector<uint8_t> data(fs::exists(path) ? fs::file_size(path) : 0);
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f != NULL) {
+        data.resize(fread(data.data(), 1, data.size(), f));
+        fclose(f);
+    }
+    return data;
+}
+
+static std::vector<uint8_t> archive(Tar::Writer& writer)
+{
+    std::vector<uint8_t> data;
+    uint8_t buffer[1000];
+    size_t n;
+    while ((n = writer.read(buffer, sizeof(buffer))) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    return data;
+}
+
+// feeds the archive in pieces of random size, the way it arrives over the network
+static bool extract(Tar::Reader& reader, const std::vector<uint8_t>& data)
+{
+    for (size_t pos = 0; pos < data.size();) {
+        size_t n = std::min<size_t>(1 + rand() % 3000, data.size() - pos);
+        if (!reader.write(data.data() + pos, n)) {
+            return false;
+        }
+        pos += n;
+    }
+    return true;
+}
+
+// a ustar header written by hand, for names the writer never produces
+static std::vector<uint8_t> header(const std::string& name, char type, size_t size)
+{
+    std::vector<uint8_t> block(512, 0);
+    memcpy(block.data(), name.data(), std::min<size_t>(name.size(), 100));
+    snprintf((char*)&block[100], 8, "%07o", 0644);
+    snprintf((char*)&block[124], 12, "%011zo", size);
+    block[156] = type;
+    memcpy(&block[257], "ustar", 6);
+    memcpy(&block[263], "00", 2);
+    uint32_t sum = 0;
+    for (size_t i = 0; i < 512; i++) {
+        sum += i >= 148 && i < 156 ? ' ' : block[i];
+    }
+    snprintf((char*)&block[148], 8, "%06o", sum);
+    block[155] = ' ';
+    return block;
+}
+
+static std::vector<uint8_t> singleFile(const std::string& name, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> tar = header(name, '0', data.size());
+    tar.insert(tar.end(), data.begin(), data.end());
+    tar.resize(tar.size() + (512 - data.size() % 512) % 512 + 1024, 0);
+    return tar;
+}
+
+static void testRoundTrip(const fs::path& root)
+{
+    // long names take the ustar prefix, or a gnu long name entry for a single component over 100 bytes
+    const std::string deep = std::string(60, 'd') + "/" + std::string(60, 'e') + "/file";
+    const std::string wide = std::string(120, 'w');
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> files = {
+        {"save.bin", payload(3000)}, {"empty", {}}, {"sub/block", payload(512)}, {deep, payload(700)}, {wide, payload(1)}};
+    for (const auto& file : files) {
+        writeFile(root / "src" / "backup" / file.first, file.second);
+    }
+    fs::create_directories(root / "src" / "backup" / "nothing");
+
+    Tar::Writer writer;
+    writer.add("backup", root / "src" / "backup");
+    const std::vector<uint8_t> tar = archive(writer);
+    CHECK(tar.size() % 512 == 0);
+
+    {
+        Tar::Reader reader(root / "dst", root / "staging", 1);
+        CHECK(extract(reader, tar));
+        CHECK(reader.finish());
+        CHECK(reader.files() == files.size());
+    }
+    for (const auto& file : files) {
+        CHECK(readFile(root / "dst" / "backup" / file.first) == file.second);
+    }
+    CHECK(fs::is_directory(root / "dst" / "backup" / "nothing"));
+    CHECK(!fs::exists(root / "staging"));
+
+    // an upload never merges into a backup of the same name
+    writeFile(root / "src" / "backup" / "new", payload(10));
+    Tar::Writer again;
+    again.add("backup", root / "src" / "backup");
+    {
+        Tar::Reader reader(root / "dst", root / "staging", 1);
+        CHECK(extract(reader, archive(again)));
+        CHECK(!reader.finish());
+        CHECK(reader.error() == EEXIST);
+        CHECK(reader.conflicts() == std::vector<std::string>({"backup"}));
+    }
+    CHECK(!fs::exists(root / "dst" / "backup" / "new"));
+    CHECK(!fs::exists(root / "staging"));
+}
+
+static void testDepth(const fs::path& root)
+{
+    // a whole saves folder: title folders are merged, the backups in them are not
+    writeFile(root / "dst" / "title1" / "old" / "save", payload(10));
+    writeFile(root / "src" / "title1" / "new" / "save", payload(20));
+    writeFile(root / "src" / "title2" / "first" / "save", payload(30));
+
+    Tar::Writer writer;
+    writer.add("title1", root / "src" / "title1");
+    writer.add("title2", root / "src" / "title2");
+    const std::vector<uint8_t> tar = archive(writer);
+    {
+        Tar::Reader reader(root / "dst", root / "staging", 2);
+        CHECK(extract(reader, tar));
+        CHECK(reader.finish());
+    }
+    CHECK(readFile(root / "dst" / "title1" / "old" / "save").size() == 10);
+    CHECK(readFile(root / "dst" / "title1" / "new" / "save") == readFile(root / "src" / "title1" / "new" / "save"));
+    CHECK(readFile(root / "dst" / "title2" / "first" / "save") == readFile(root / "src" / "title2" / "first" / "save"));
+
+    // one conflict keeps the other backups out as well
+    writeFile(root / "src" / "title1" / "old" / "save", payload(40));
+    writeFile(root / "src" / "title3" / "other" / "save", payload(50));
+    Tar::Writer conflicting;
+    conflicting.add("title1", root / "src" / "title1");
+    conflicting.add("title3", root / "src" / "title3");
+    {
+        Tar::Reader reader(root / "dst", root / "staging", 2);
+        CHECK(extract(reader, archive(conflicting)));
+        CHECK(!reader.finish());
+        CHECK(reader.error() == EEXIST);
+        CHECK(reader.conflicts() == std::vector<std::string>({"title1/new", "title1/old"}));
+    }
+    CHECK(readFile(root / "dst" / "title1" / "old" / "save").size() == 10);
+    CHECK(!fs::exists(root / "dst" / "title3"));
+    CHECK(!fs::exists(root / "staging"));
+}
+
+static void testTraversal(const fs::path& root)
+{
+    for (const char* name : {"../evil", "/evil", "backup/../../evil", "backup/../.."}) {
+        {
+            Tar::Reader reader(root / "dst", root / "staging", 1);
+            CHECK(!extract(reader, singleFile(name, payload(100))));
+            CHECK(reader.error() == EACCES);
+            CHECK(!reader.finish());
+        }
+        CHECK(!fs::exists(root / "evil"));
+        CHECK(!fs::exists(root / "dst"));
+        CHECK(!fs::exists(root / "staging"));
+    }
+
+    // empty and . components are dropped
+    {
+        Tar::Reader reader(root / "dst", root / "staging", 1);
+        CHECK(extract(reader, singleFile("./backup//./save", payload(100))));
+        CHECK(reader.finish());
+    }
+    CHECK(fs::exists(root / "dst" / "backup" / "save"));
+}
+
+static void testTruncated(const fs::path& root)
+{
+    const std::vector<uint8_t> data = payload(1500);
+    const std::vector<uint8_t> tar  = singleFile("backup/save", data);
+    // cut inside the header, inside the data, inside the padding, and in the middle of a block of the next header
+    for (size_t size : {(size_t)100, (size_t)512 + 700, (size_t)512 + 1500 + 10, (size_t)512 + 1536 + 200}) {
+        {
+            Tar::Reader reader(root / "dst", root / "staging", 1);
+            CHECK(extract(reader, std::vector<uint8_t>(tar.begin(), tar.begin() + size)));
+            CHECK(!reader.finish());
+        }
+        CHECK(!fs::exists(root / "dst"));
+        CHECK(!fs::exists(root / "staging"));
+    }
+
+    // a damaged header is rejected right away
+    std::vector<uint8_t> damaged = tar;
+    damaged[0] ^= 1;
+    {
+        Tar::Reader reader(root / "dst", root / "staging", 1);
+        CHECK(!extract(reader, damaged));
+        CHECK(reader.error() == EINVAL);
+    }
+    CHECK(!fs::exists(root / "staging"));
+
+    // the complete archive goes through
+    {
+        Tar::Reader reader(root / "dst", root / "staging", 1);
+        CHECK(extract(reader, tar));
+        CHECK(reader.finish());
+    }
+    CHECK(readFile(root / "dst" / "backup" / "save") == data);
+}
+
+int main(void)
+{
+    srand(19);
+    char tmpl[]   = "/tmp/checkpoint-tar-XXXXXX";
+    fs::path root = mkdtemp(tmpl);
+
+    // the parent of the staging folder has to exist, as it does on the console
+    for (const char* test : {"roundtrip", "depth", "traversal", "truncated"}) {
+        fs::create_directories(root / test);
+    }
+    testRoundTrip(root / "roundtrip");
+    testDepth(root / "depth");
+    testTraversal(root / "traversal");
+    testTruncated(root / "truncated");
+
+    fs::remove_all(root);
+    return testResult();
+}
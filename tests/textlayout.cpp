@@ -0,0 +1,172 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "test.hpp"
+#include "textlayout.hpp"
+#include <stdlib.h>
+#include <string>
+
+// every glyph is 10 units wide, everything outside ASCII 20, so that widths are easy to count by hand
+static int g_measured = 0;
+
+static uint16_t measure(uint32_t codepoint)
+{
+    g_measured++;
+    return codepoint < 0x80 ? 10 : 20;
+}
+
+// the inserted line breaks are the only difference between the text and its wrapped version, apart from the spaces
+// they replaced
+static std::string strip(const std::string& text)
+{
+    std::string stripped;
+    for (char c : text) {
+        if (c != ' ' && c != '\n') {
+            stripped += c;
+        }
+    }
+    return stripped;
+}
+
+static void testDecode(void)
+{
+    const std::string text = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    size_t i               = 0;
+    CHECK(TextLayout::decode(text, i) == 'a' && i == 1);
+    CHECK(TextLayout::decode(text, i) == 0xE9 && i == 3);
+    CHECK(TextLayout::decode(text, i) == 0x20AC && i == 6);
+    CHECK(TextLayout::decode(text, i) == 0x1F600 && i == 10);
+
+    // malformed sequences are skipped one byte at a time
+    const std::string bad = "\xFF\xE2\x82";
+    i                     = 0;
+    CHECK(TextLayout::decode(bad, i) == 0xFFFD && i == 1);
+    CHECK(TextLayout::decode(bad, i) == 0xFFFD && i == 2);
+    CHECK(TextLayout::decode(bad, i) == 0xFFFD && i == 3);
+}
+
+static void testWidth(void)
+{
+    TextLayout::GlyphTable glyphs(measure);
+    g_measured = 0;
+    CHECK(TextLayout::width(glyphs, "", 1.0f) == 0.0f);
+    CHECK(TextLayout::width(glyphs, "abc", 1.0f) == 30.0f);
+    CHECK(TextLayout::width(glyphs, "abc", 0.5f) == 15.0f);
+    CHECK(TextLayout::width(glyphs, "ab\nabcd\na", 1.0f) == 40.0f);
+    CHECK(TextLayout::width(glyphs, "h\xC3\xA9\xC3\xA9", 1.0f) == 50.0f);
+    // each codepoint of the basic multilingual plane is only measured once
+    CHECK(g_measured == 6);
+
+    // the ones above it every time
+    CHECK(TextLayout::width(glyphs, "\xF0\x9F\x98\x80\xF0\x9F\x98\x80", 1.0f) == 40.0f);
+    CHECK(g_measured == 8);
+}
+
+static void testWrap(void)
+{
+    TextLayout::GlyphTable glyphs(measure);
+    // lines of 5 ASCII glyphs
+    auto wrap = [&](const std::string& text) { return TextLayout::wrap(glyphs, text, 1.0f, 50.0f); };
+
+    CHECK(wrap("") == "");
+    CHECK(wrap("abcde") == "abcde");
+    CHECK(wrap("aaa bbb ccc") == "aaa\nbbb\nccc");
+    CHECK(wrap("abc\nabcde") == "abc\nabcde");
+
+    // the space after a full line does not overflow it, it becomes the break
+    CHECK(wrap("aaaaa bbbbb") == "aaaaa\nbbbbb");
+    // only the last space before the overflow does, the others stay at the end of the line
+    CHECK(wrap("aaa  bbb") == "aaa \nbbb");
+    CHECK(wrap("aaaa bb") == "aaaa\nbb");
+
+    // words wider than a line are split where they overflow, after a break at a space if there is one on the line
+    CHECK(wrap("abcdefghijkl") == "abcde\nfghij\nkl");
+    CHECK(wrap("ab cdefghij") == "ab\ncdefg\nhij");
+
+    // multi-byte codepoints are never split and count with their own width
+    CHECK(wrap("\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9") == "\xC3\xA9\xC3\xA9\n\xC3\xA9\xC3\xA9");
+    CHECK(wrap("a \xC3\xA9\xC3\xA9\xC3\xA9") == "a\n\xC3\xA9\xC3\xA9\n\xC3\xA9");
+
+    // a glyph wider than the line still gets a line of its own
+    CHECK(TextLayout::wrap(glyphs, "a\xC3\xA9" "b", 1.0f, 15.0f) == "a\n\xC3\xA9\nb");
+
+    // random words: nothing but breaks is added or lost and no line is wider than the limit
+    for (int round = 0; round < 200; round++) {
+        std::string text;
+        for (int i = rand() % 40; i > 0; i--) {
+            switch (rand() % 6) {
+                case 0:
+                    text += ' ';
+                    break;
+                case 1:
+                    text += "\xC3\xA9";
+                    break;
+                default:
+                    text += 'a' + rand() % 26;
+                    break;
+            }
+        }
+        const std::string wrapped = wrap(text);
+        CHECK(strip(wrapped) == strip(text));
+        for (size_t start = 0; start <= wrapped.size();) {
+            size_t end = wrapped.find('\n', start);
+            end        = end == std::string::npos ? wrapped.size() : end;
+            std::string line = wrapped.substr(start, end - start);
+            // trailing spaces do not count, they are what the line was broken at
+            line.erase(line.find_last_not_of(' ') + 1);
+            CHECK(TextLayout::width(glyphs, line, 1.0f) <= 50.0f);
+            start = end + 1;
+        }
+    }
+}
+
+static void testEllipsize(void)
+{
+    TextLayout::GlyphTable glyphs(measure);
+    auto ellipsize = [&](const std::string& text, float maxWidth) { return TextLayout::ellipsize(glyphs, text, 1.0f, maxWidth); };
+
+    CHECK(ellipsize("", 50.0f) == "");
+    CHECK(ellipsize("abc", 50.0f) == "abc");
+    CHECK(ellipsize("abcde", 50.0f) == "abcde");
+    CHECK(ellipsize("abcdef", 50.0f) == "ab...");
+    CHECK(ellipsize("abcdefghij", 60.0f) == "abc...");
+    // the cut is made at a codepoint boundary, leaving room for the ellipsis
+    CHECK(ellipsize("\xC3\xA9\xC3\xA9\xC3\xA9", 50.0f) == "\xC3\xA9...");
+    CHECK(ellipsize("a\xC3\xA9\xC3\xA9\xC3\xA9", 60.0f) == "a\xC3\xA9...");
+    // without room for anything else only the ellipsis is left
+    CHECK(ellipsize("abcdef", 20.0f) == "...");
+    CHECK(TextLayout::ellipsize(glyphs, "abcdef", 1.0f, 40.0f, "\xE2\x80\xA6") == "ab\xE2\x80\xA6");
+}
+
+int main(void)
+{
+    srand(11);
+    testDecode();
+    testWidth();
+    testWrap();
+    testEllipsize();
+    return testResult();
+}
@@ -0,0 +1,98 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// cost of the layout functions in common/textlayout.cpp per input byte, over texts of growing size. A flat column
+// means the cost grows linearly with the text. Prose is random words with some multi-byte codepoints, the long word
+// has no space to break at, ellipsize is given room for the whole text so that it has to go through all of it
+//   textlayout_bench [megabytes per measurement]
+
+#include "textlayout.hpp"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+namespace {
+    constexpr size_t SIZES[] = {256, 1024, 4096, 16384, 65536, 262144, 1 << 20};
+
+    template <typename F>
+    double measure(size_t size, size_t total, F&& run)
+    {
+        size_t iterations = total / size > 0 ? total / size : 1;
+        // one untimed pass to measure the glyphs
+        run();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            run();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return elapsed * 1e9 / iterations / size;
+    }
+
+    std::string prose(size_t size)
+    {
+        std::string text;
+        while (text.size() < size) {
+            for (int i = 1 + rand() % 10; i > 0; i--) {
+                if (rand() % 8 == 0) {
+                    text += "\xC3\xA9";
+                }
+                else {
+                    text += 'a' + rand() % 26;
+                }
+            }
+            text += ' ';
+        }
+        return text;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t total = (argc > 1 ? atoi(argv[1]) : 64) * (size_t)(1 << 20);
+    if (total == 0) {
+        fprintf(stderr, "usage: %s [megabytes per measurement]\n", argv[0]);
+        return 1;
+    }
+
+    TextLayout::GlyphTable glyphs([](uint32_t codepoint) -> uint16_t { return codepoint < 0x80 ? 10 : 20; });
+    // the results are folded together and printed, so that no call can be dropped
+    size_t sink = 0;
+    printf("%10s %12s %12s %12s %12s\n", "bytes", "width ns/B", "wrap ns/B", "long ns/B", "ellip. ns/B");
+    for (size_t size : SIZES) {
+        const std::string text = prose(size);
+        const std::string word(size, 'a');
+        double width     = measure(size, total, [&] { sink += TextLayout::width(glyphs, text, 1.0f); });
+        double wrap      = measure(size, total, [&] { sink += TextLayout::wrap(glyphs, text, 1.0f, 400.0f).size(); });
+        double longWord  = measure(size, total, [&] { sink += TextLayout::wrap(glyphs, word, 1.0f, 400.0f).size(); });
+        double ellipsize = measure(size, total, [&] { sink += TextLayout::ellipsize(glyphs, text, 1.0f, INFINITY).size(); });
+        printf("%10zu %12.2f %12.2f %12.2f %12.2f\n", size, width, wrap, longWord, ellipsize);
+    }
+    printf("(%zu)\n", sink);
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "test.hpp"
+#include "titleindex.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct Entry {
+    std::string name;
+    std::string author;
+    uint64_t id;
+};
+
+// what the index has to answer, found by scanning every field of every title
+static std::vector<bool> bruteForce(const std::vector<Entry>& entries, const std::string& query)
+{
+    const std::string folded = TitleIndex::fold(query);
+    std::vector<bool> matches;
+    for (const auto& entry : entries) {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)entry.id);
+        matches.push_back(TitleIndex::fold(entry.name).find(folded) != std::string::npos ||
+                          TitleIndex::fold(entry.author).find(folded) != std::string::npos || std::string(hex).find(folded) != std::string::npos);
+    }
+    return matches;
+}
+
+static std::vector<bool> search(const TitleIndex& index, const std::string& query)
+{
+    std::vector<bool> matches;
+    index.search(query, matches);
+    return matches;
+}
+
+static void testFold(void)
+{
+    CHECK(TitleIndex::fold("") == "");
+    CHECK(TitleIndex::fold("Mario Kart 8") == "mario kart 8");
+    CHECK(TitleIndex::fold("Pok\xC3\xA9mon") == "pokemon");
+    CHECK(TitleIndex::fold("\xC3\x89" "COLE \xC3\x80 \xC3\x87\xC3\x80") == "ecole a ca");
+    CHECK(TitleIndex::fold("Stra\xC3\x9F" "e \xC5\x81\xC3\xB3" "d\xC5\xBA") == "strase lodz");
+    // fullwidth forms and the ideographic space, as typed on Japanese keyboards
+    CHECK(TitleIndex::fold("\xEF\xBC\xA1\xEF\xBD\x82\xEF\xBC\x93\xE3\x80\x80x") == "ab3 x");
+    // anything else is kept as is, the multiplication sign included
+    CHECK(TitleIndex::fold("\xC3\x97") == "\xC3\x97");
+    CHECK(TitleIndex::fold("\xE3\x83\x9D\xE3\x82\xB1\xE3\x83\xA2\xE3\x83\xB3") == "\xE3\x83\x9D\xE3\x82\xB1\xE3\x83\xA2\xE3\x83\xB3");
+}
+
+static void testSearch(void)
+{
+    std::vector<Entry> entries = {{"Pok\xC3\xA9mon Ultra Sun", "Nintendo", 0x00040000001B5000}, {"\xC3\x89" "cole", "Abc", 0x0004000000055D00},
+        {"abc", "def", 0x0100000000010000}};
+    TitleIndex index;
+    for (const auto& entry : entries) {
+        index.add(entry.name, entry.author, entry.id);
+    }
+    CHECK(index.size() == 3);
+
+    CHECK(search(index, "") == std::vector<bool>({true, true, true}));
+    CHECK(search(index, "POKE") == std::vector<bool>({true, false, false}));
+    CHECK(search(index, "pok\xC3\xA9") == std::vector<bool>({true, false, false}));
+    CHECK(search(index, "ECOLE") == std::vector<bool>({false, true, false}));
+    CHECK(search(index, "abc") == std::vector<bool>({false, true, true}));
+    CHECK(search(index, "55d") == std::vector<bool>({false, true, false}));
+    CHECK(search(index, "nd") == std::vector<bool>({true, false, false}));
+    // fields are searched one by one, a query spanning two of them matches neither
+    CHECK(search(index, "cde") == std::vector<bool>({false, false, false}));
+    CHECK(search(index, "zzz") == std::vector<bool>({false, false, false}));
+
+    index.clear();
+    CHECK(index.size() == 0);
+    CHECK(search(index, "abc").empty());
+}
+
+static void testRandom(void)
+{
+    // a few letters, some of them accented or upper case, so that short queries match often
+    const char* letters[] = {"a", "b", "c", "A", "B", " ", "\xC3\xA1", "\xC3\x81", "\xEF\xBD\x82"};
+    auto random           = [&](int length) {
+        std::string text;
+        for (int i = 0; i < length; i++) {
+            text += letters[rand() % 9];
+        }
+        return text;
+    };
+
+    std::vector<Entry> entries(300);
+    TitleIndex index;
+    for (auto& entry : entries) {
+        entry.name   = random(rand() % 16);
+        entry.author = random(rand() % 6);
+        entry.id     = (uint64_t)rand() << 32 | rand();
+        index.add(entry.name, entry.author, entry.id);
+    }
+
+    for (int round = 0; round < 500; round++) {
+        std::string query;
+        if (round % 2 == 0) {
+            // a piece of a title, so that most of these have matches
+            const Entry& entry = entries[rand() % entries.size()];
+            size_t start       = entry.name.empty() ? 0 : rand() % entry.name.size();
+            query              = entry.name.substr(start, rand() % 8);
+        }
+        else {
+            query = random(1 + rand() % 5);
+        }
+        CHECK(search(index, query) == bruteForce(entries, query));
+    }
+}
+
+int main(void)
+{
+    srand(17);
+    testFold();
+    testSearch();
+    testRandom();
+    return testResult();
+}
@@ -0,0 +1,118 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// cost of a keystroke in the title search: every prefix of a few queries is looked up in turn, the way the list is
+// refiltered while a query is typed. The scan column folds and searches every title instead, as a plain filter would.
+// A keystroke has to cost well below a millisecond to leave the rest of a 60 fps frame to the list itself
+//   titleindex_bench [repetitions]
+
+#include "titleindex.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+namespace {
+    const char* WORDS[] = {"Pok\xC3\xA9mon", "Mario", "Zelda", "Legend", "of", "the", "Dungeon", "Mystery", "Kart", "Party", "Super", "Bros.",
+        "Fire", "Emblem", "Animal", "Crossing", "Metroid", "Kirby", "Star", "Fox", "Xenoblade", "Chronicles", "Smash", "Ultra", "Sun", "Moon",
+        "\xC3\x89" "dition", "Deluxe", "World", "Odyssey"};
+    const char* QUERIES[] = {"pokemon mystery dungeon", "ZELDA", "kart 8", "0100000000010000", "\xC3\xA9" "dition"};
+
+    std::string words(int count)
+    {
+        std::string text;
+        for (int i = 0; i < count; i++) {
+            text += (i > 0 ? " " : "") + std::string(WORDS[rand() % (sizeof(WORDS) / sizeof(WORDS[0]))]);
+        }
+        return text;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int repetitions = argc > 1 ? atoi(argv[1]) : 20;
+    if (repetitions <= 0) {
+        fprintf(stderr, "usage: %s [repetitions]\n", argv[0]);
+        return 1;
+    }
+
+    // the results are folded together and printed, so that no search can be dropped
+    size_t sink = 0;
+    printf("%8s %14s %14s %14s\n", "titles", "mean us/key", "max us/key", "scan us/key");
+    for (size_t titles : {100, 500, 2000, 10000}) {
+        std::vector<std::string> names, authors;
+        std::vector<uint64_t> ids;
+        TitleIndex index;
+        for (size_t i = 0; i < titles; i++) {
+            names.push_back(words(1 + rand() % 5));
+            authors.push_back(words(1));
+            ids.push_back(0x0100000000000000ULL | (uint64_t)i << 16);
+            index.add(names.back(), authors.back(), ids.back());
+        }
+
+        // every keystroke counts with its fastest repetition, so that being preempted does not show up as a slow search
+        std::vector<bool> matches;
+        std::vector<double> best, scan;
+        for (int repetition = 0; repetition < repetitions; repetition++) {
+            size_t key = 0;
+            for (const char* query : QUERIES) {
+                for (size_t length = 1; query[length - 1] != '\0'; length++, key++) {
+                    const std::string typed(query, length);
+                    auto start = std::chrono::steady_clock::now();
+                    index.search(typed, matches);
+                    double searched = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6;
+                    sink += std::count(matches.begin(), matches.end(), true);
+
+                    start                    = std::chrono::steady_clock::now();
+                    const std::string folded = TitleIndex::fold(typed);
+                    for (size_t i = 0; i < titles; i++) {
+                        sink += TitleIndex::fold(names[i]).find(folded) != std::string::npos ||
+                                TitleIndex::fold(authors[i]).find(folded) != std::string::npos;
+                    }
+                    double scanned = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6;
+
+                    if (repetition == 0) {
+                        best.push_back(searched);
+                        scan.push_back(scanned);
+                    }
+                    best[key] = std::min(best[key], searched);
+                    scan[key] = std::min(scan[key], scanned);
+                }
+            }
+        }
+        double total = 0, slowest = 0, scanned = 0;
+        for (size_t key = 0; key < best.size(); key++) {
+            total += best[key];
+            slowest = std::max(slowest, best[key]);
+            scanned += scan[key];
+        }
+        printf("%8zu %14.2f %14.2f %14.2f\n", titles, total / best.size(), slowest, scanned / scan.size());
+    }
+    printf("(%zu)\n", sink);
+
+    return 0;
+}
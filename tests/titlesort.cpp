@@ -0,0 +1,141 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "test.hpp"
+#include "titlesort.hpp"
+#include <algorithm>
+#include <stdlib.h>
+
+using TitleSort::Item;
+using TitleSort::Permutation;
+
+static std::string folded(const std::string& name)
+{
+    std::string dst = name;
+    for (auto& c : dst) {
+        c = c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    }
+    return dst;
+}
+
+// the orders spelled out with plain comparisons, ties between identical names keep the input order
+static Permutation referenceAlphabetical(const std::vector<Item>& items)
+{
+    Permutation permutation(items.size());
+    for (size_t i = 0; i < permutation.size(); i++) {
+        permutation[i] = i;
+    }
+    std::stable_sort(permutation.begin(), permutation.end(), [&](uint32_t l, uint32_t r) {
+        if (items[l].favorite != items[r].favorite) {
+            return items[l].favorite;
+        }
+        if (folded(items[l].name) != folded(items[r].name)) {
+            return folded(items[l].name) < folded(items[r].name);
+        }
+        return items[l].name < items[r].name;
+    });
+    return permutation;
+}
+
+static Permutation referenceDescending(const std::vector<Item>& items, uint32_t Item::*value)
+{
+    Permutation permutation = referenceAlphabetical(items);
+    std::stable_sort(permutation.begin(), permutation.end(), [&](uint32_t l, uint32_t r) {
+        if (items[l].favorite != items[r].favorite) {
+            return items[l].favorite;
+        }
+        return items[l].*value > items[r].*value;
+    });
+    return permutation;
+}
+
+static std::vector<std::string> names(const std::vector<Item>& items, const Permutation& permutation)
+{
+    std::vector<std::string> names;
+    for (uint32_t i : permutation) {
+        names.push_back(items[i].name);
+    }
+    return names;
+}
+
+static void testFavorites(void)
+{
+    std::vector<Item> items = {{"Zelda", true, 1, 1}, {"animal crossing", false, 5, 9}, {"Mario", true, 3, 2}, {"Bayonetta", false, 9, 3}};
+    auto orders             = TitleSort::permutations(items);
+    CHECK(names(items, orders[TitleSort::ORDER_ALPHA]) == std::vector<std::string>({"Mario", "Zelda", "animal crossing", "Bayonetta"}));
+    CHECK(names(items, orders[TitleSort::ORDER_LAST_PLAYED]) == std::vector<std::string>({"Mario", "Zelda", "Bayonetta", "animal crossing"}));
+    CHECK(names(items, orders[TitleSort::ORDER_PLAY_TIME]) == std::vector<std::string>({"Mario", "Zelda", "animal crossing", "Bayonetta"}));
+}
+
+static void testSharedPrefixes(void)
+{
+    // the keys only hold the first 7 bytes, longer prefixes are settled by comparing the names
+    std::vector<Item> items = {{"Pokemon Sun", false, 0, 0}, {"Pokemon Moon", false, 0, 0}, {"pokemon moon", false, 0, 0},
+        {"Pokemon", false, 0, 0}, {"Pokemon Moon Demo", false, 0, 0}, {"Poke", false, 0, 0}, {"POKEMON SUN", false, 0, 0}};
+    CHECK(names(items, TitleSort::alphabetical(items)) == std::vector<std::string>({"Poke", "Pokemon", "Pokemon Moon", "pokemon moon",
+                                                              "Pokemon Moon Demo", "POKEMON SUN", "Pokemon Sun"}));
+}
+
+static void testTies(void)
+{
+    // equal values fall back to the alphabetical order, identical names to the order they came in
+    std::vector<Item> items = {{"c", false, 7, 1}, {"b", false, 7, 1}, {"a", false, 2, 1}, {"b", false, 7, 1}, {"B", false, 7, 1}};
+    auto orders             = TitleSort::permutations(items);
+    CHECK(orders[TitleSort::ORDER_ALPHA] == Permutation({2, 4, 1, 3, 0}));
+    CHECK(orders[TitleSort::ORDER_LAST_PLAYED] == Permutation({4, 1, 3, 0, 2}));
+    CHECK(orders[TitleSort::ORDER_PLAY_TIME] == Permutation({2, 4, 1, 3, 0}));
+}
+
+static void testRandom(void)
+{
+    // few letters, short names and small values, so that prefixes, ties and duplicates are common
+    const char letters[] = "aAbB ";
+    for (int round = 0; round < 200; round++) {
+        std::vector<Item> items(rand() % 50);
+        for (auto& item : items) {
+            for (int i = rand() % 12; i > 0; i--) {
+                item.name += letters[rand() % 5];
+            }
+            item.favorite   = rand() % 4 == 0;
+            item.lastPlayed = rand() % 4;
+            item.playTime   = rand() % 3 == 0 ? UINT32_MAX : rand();
+        }
+        auto orders = TitleSort::permutations(items);
+        CHECK(orders[TitleSort::ORDER_ALPHA] == referenceAlphabetical(items));
+        CHECK(orders[TitleSort::ORDER_LAST_PLAYED] == referenceDescending(items, &Item::lastPlayed));
+        CHECK(orders[TitleSort::ORDER_PLAY_TIME] == referenceDescending(items, &Item::playTime));
+    }
+}
+
+int main(void)
+{
+    srand(13);
+    testFavorites();
+    testSharedPrefixes();
+    testTies();
+    testRandom();
+    return testResult();
+}
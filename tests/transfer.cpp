@@ -0,0 +1,289 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "hash.hpp"
+#include "test.hpp"
+#include "transfer.hpp"
+#include <filesystem>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const size_t CHUNK = 0x10000;
+
+static std::vector<uint8_t> payload(size_t size, uint32_t seed)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        seed    = seed * 1103515245 + 12345;
+        data[i] = seed >> 16;
+    }
+    return data;
+}
+
+static void writeFile(const fs::path& path, const std::vector<uint8_t>& data)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static std::vector<uint8_t> readFile(const fs::path& path)
+{
+    std::vector<uint8_t> data(fs::exists(path) ? fs::file_size(path) : 0);
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f != NULL) {
+        data.resize(fread(data.data(), 1, data.size(), f));
+        fclose(f);
+    }
+    return data;
+}
+
+static size_t countParts(const fs::path& dir)
+{
+    size_t count = 0;
+    if (fs::exists(dir)) {
+        for (auto& entry : fs::directory_iterator(dir)) {
+            count += entry.path().extension() == ".part";
+        }
+    }
+    return count;
+}
+
+static Transfer::Header header(const std::vector<uint8_t>& data)
+{
+    Hash::Fast64 hash;
+    hash.update(data.data(), data.size());
+    Transfer::Header header;
+    memcpy(header.magic, "PKSMBRDG", sizeof(header.magic));
+    header.version  = 3;
+    header.flags    = 0;
+    header.size     = data.size();
+    header.checksum = hash.finish();
+    return header;
+}
+
+// plays the sender side by hand: announces data, then only sends the first `sent` bytes and hangs up
+static void partialSend(int fd, const Transfer::Header& header, const std::vector<uint8_t>& data, size_t sent)
+{
+    Transfer::Hello hello;
+    Transfer::Ack ack;
+    recv(fd, &hello, sizeof(hello), MSG_WAITALL);
+    send(fd, &header, sizeof(header), 0);
+    recv(fd, &ack, sizeof(ack), MSG_WAITALL);
+    send(fd, data.data() + ack.offset, sent - ack.offset, 0);
+    shutdown(fd, SHUT_WR);
+    // wait for the receiver to notice before tearing the connection down
+    while (recv(fd, &ack, sizeof(ack), 0) > 0) {
+    }
+    close(fd);
+}
+
+struct Outcome {
+    int sent;
+    int received;
+    uint64_t firstProgress;
+};
+
+static Outcome transfer(const fs::path& src, const fs::path& dst, const fs::path& staging, uint64_t maxSize = 1 << 24)
+{
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    Outcome result = {-1, -1, UINT64_MAX};
+    std::thread receiver([&] {
+        result.received = Transfer::recvFile(sv[1], dst, staging, maxSize, 0, nullptr);
+        close(sv[1]);
+    });
+    result.sent = Transfer::sendFile(sv[0], src, [&](uint64_t done, uint64_t) {
+        if (result.firstProgress == UINT64_MAX) {
+            result.firstProgress = done;
+        }
+    });
+    close(sv[0]);
+    receiver.join();
+    return result;
+}
+
+static void testLoopback(const fs::path& root)
+{
+    fs::path backup  = root / "backup";
+    fs::path staging = root / "staging";
+    fs::create_directories(backup);
+    auto data = payload(5 * CHUNK + 123, 1);
+    writeFile(root / "src", data);
+
+    Outcome r = transfer(root / "src", backup / "save", staging);
+    CHECK(r.sent == 0);
+    CHECK(r.received == 0);
+    CHECK(r.firstProgress == 0);
+    CHECK(readFile(backup / "save") == data);
+    CHECK(countParts(staging) == 0);
+    CHECK(countParts(backup) == 0);
+
+    // an empty payload is still a valid transfer
+    writeFile(root / "empty", {});
+    r = transfer(root / "empty", backup / "empty", staging);
+    CHECK(r.sent == 0 && r.received == 0);
+    CHECK(fs::exists(backup / "empty") && fs::file_size(backup / "empty") == 0);
+
+    r = transfer(root / "src", backup / "big", staging, CHUNK);
+    CHECK(r.sent == EFBIG);
+    CHECK(r.received == EFBIG);
+    CHECK(!fs::exists(backup / "big"));
+}
+
+static void testResume(const fs::path& root)
+{
+    fs::path backup  = root / "backup";
+    fs::path staging = root / "staging";
+    fs::create_directories(backup);
+    fs::create_directories(staging);
+    auto data = payload(8 * CHUNK + 77, 2);
+    writeFile(root / "src", data);
+
+    // a part left over from another payload is stale
+    writeFile(staging / "0000000000000001.part", payload(100, 3));
+
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    std::thread sender(partialSend, sv[0], header(data), std::cref(data), 3 * CHUNK);
+    int res = Transfer::recvFile(sv[1], backup / "save", staging, 1 << 24, 0, nullptr);
+    close(sv[1]);
+    sender.join();
+
+    // the interrupted data waits in the staging folder, never next to the backup
+    CHECK(res == ECONNRESET);
+    CHECK(!fs::exists(backup / "save"));
+    CHECK(countParts(backup) == 0);
+    CHECK(countParts(staging) == 1);
+    CHECK(!fs::exists(staging / "0000000000000001.part"));
+
+    Outcome r = transfer(root / "src", backup / "save", staging);
+    CHECK(r.sent == 0);
+    CHECK(r.received == 0);
+    CHECK(r.firstProgress == 3 * CHUNK);
+    CHECK(readFile(backup / "save") == data);
+    CHECK(countParts(staging) == 0);
+}
+
+static void testCorrupted(const fs::path& root)
+{
+    fs::path backup  = root / "backup";
+    fs::path staging = root / "staging";
+    fs::create_directories(backup);
+    auto data = payload(2 * CHUNK, 4);
+
+    // the payload does not match the checksum it was announced with
+    Transfer::Header bad = header(data);
+    bad.checksum ^= 1;
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    std::thread sender(partialSend, sv[0], bad, std::cref(data), data.size());
+    int res = Transfer::recvFile(sv[1], backup / "save", staging, 1 << 24, 0, nullptr);
+    close(sv[1]);
+    sender.join();
+
+    CHECK(res == EBADMSG);
+    CHECK(!fs::exists(backup / "save"));
+    CHECK(countParts(staging) == 0);
+}
+
+// peers predating the framing send the bare payload and never read the hello
+static void testLegacyReceive(const fs::path& root)
+{
+    fs::path backup  = root / "backup";
+    fs::path staging = root / "staging";
+    fs::create_directories(backup);
+    auto data = payload(3 * CHUNK + 5, 5);
+
+    for (size_t legacySize : {data.size(), data.size() + 1, (size_t)0}) {
+        int sv[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        std::thread sender([&] {
+            send(sv[0], data.data(), data.size(), 0);
+            close(sv[0]);
+        });
+        int res = Transfer::recvFile(sv[1], backup / "save", staging, 1 << 24, legacySize, nullptr);
+        close(sv[1]);
+        sender.join();
+
+        if (legacySize == data.size()) {
+            CHECK(res == 0);
+            CHECK(readFile(backup / "save") == data);
+            fs::remove(backup / "save");
+        }
+        else {
+            // a short payload or a peer that is not expected to send raw data stores nothing
+            CHECK(res == (legacySize == 0 ? EPROTO : ECONNRESET));
+            CHECK(!fs::exists(backup / "save"));
+        }
+        CHECK(countParts(staging) == 0);
+    }
+}
+
+// and expect it raw: without a hello the sender falls back after a timeout
+static void testLegacySend(const fs::path& root)
+{
+    auto data = payload(2 * CHUNK + 9, 6);
+    writeFile(root / "src", data);
+
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    std::vector<uint8_t> received(data.size());
+    ssize_t n = 0;
+    std::thread receiver([&] {
+        n = recv(sv[1], received.data(), received.size(), MSG_WAITALL);
+        close(sv[1]);
+    });
+    int res = Transfer::sendFile(sv[0], root / "src", nullptr);
+    close(sv[0]);
+    receiver.join();
+
+    CHECK(res == 0);
+    CHECK(n == (ssize_t)data.size());
+    CHECK(received == data);
+}
+
+int main(void)
+{
+    char tmpl[]   = "/tmp/checkpoint-transfer-XXXXXX";
+    fs::path root = mkdtemp(tmpl);
+
+    testLoopback(root / "loopback");
+    testResume(root / "resume");
+    testCorrupted(root / "corrupted");
+    fs::create_directories(root / "legacy");
+    testLegacyReceive(root / "legacy");
+    testLegacySend(root / "legacy");
+
+    fs::remove_all(root);
+    return testResult();
+}
@@ -0,0 +1,124 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// throughput of Transfer::sendFile and Transfer::recvFile over a 127.0.0.1 TCP connection, in MB/s. Both ends are
+// set up like the PKSM bridge sets them up, once with the buffers from Transfer::configureSocket and once with the
+// system defaults for comparison
+//   transfer_bench [megabytes]
+
+#include "transfer.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <filesystem>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // one transfer of src to dst through a fresh connection, returns MB/s or 0 on failure
+    double run(const fs::path& src, const fs::path& dst, const fs::path& staging, size_t size, bool configure)
+    {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addrlen    = sizeof(addr);
+        if (listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 1) != 0 ||
+            getsockname(listener, (struct sockaddr*)&addr, &addrlen) != 0) {
+            perror("listen");
+            exit(1);
+        }
+
+        auto start   = std::chrono::steady_clock::now();
+        int received = -1;
+        std::thread receiver([&] {
+            int fd = accept(listener, NULL, NULL);
+            if (configure) {
+                Transfer::configureSocket(fd);
+            }
+            received = Transfer::recvFile(fd, dst, staging, size, 0, nullptr);
+            close(fd);
+        });
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (configure) {
+            Transfer::configureSocket(fd);
+        }
+        int sent = connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 ? Transfer::sendFile(fd, src, nullptr) : errno;
+        close(fd);
+        receiver.join();
+        close(listener);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (sent != 0 || received != 0) {
+            fprintf(stderr, "transfer failed: %s / %s\n", strerror(sent), strerror(received));
+            return 0;
+        }
+        fs::remove(dst);
+        return size / elapsed / 1e6;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? atoi(argv[1]) : 256) * (size_t)(1 << 20);
+    if (size == 0) {
+        fprintf(stderr, "usage: %s [megabytes]\n", argv[0]);
+        return 1;
+    }
+
+    char tmpl[]   = "/tmp/checkpoint-transfer-XXXXXX";
+    fs::path root = mkdtemp(tmpl);
+    fs::create_directories(root / "staging");
+    std::vector<char> data(size);
+    for (auto& byte : data) {
+        byte = rand();
+    }
+    FILE* f = fopen((root / "src").c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+
+    // the best of a few runs, the first one also warms the page cache
+    printf("%10s %16s %16s\n", "MB", "configured MB/s", "default MB/s");
+    double configured = 0, defaults = 0;
+    for (int i = 0; i < 3; i++) {
+        configured = std::max(configured, run(root / "src", root / "dst", root / "staging", size, true));
+        defaults   = std::max(defaults, run(root / "src", root / "dst", root / "staging", size, false));
+    }
+    printf("%10zu %16.0f %16.0f\n", size >> 20, configured, defaults);
+
+    fs::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+#
+#   This file is part of Checkpoint
+#   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+#
+#   This program is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+#   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+#       * Requiring preservation of specified reasonable legal notices or
+#         author attributions in that material or in the Appropriate Legal
+#         Notices displayed by works containing it.
+#       * Prohibiting misrepresentation of the origin of that material,
+#         or requiring that modified versions of such material be marked in
+#         reasonable ways as different from the original version.
+#
+
+# Converts a sharkive json database into the binary cheat database read by
+# common/cheatdatabase.cpp.
+#
+# header:  char magic[4] "CKDB", u16 version, u16 codec, u32 titles, u32 reserved
+# index:   titles * { u64 title id, u32 offset, u32 compressed size, u32 size, u32 reserved }, sorted by title id
+# blocks:  one compressed block per title
+#
+# decompressed block:
+#   u32 builds, u32 cheats, u32 lines
+#   builds * { u32 name, u32 first cheat, u32 cheat count }
+#   cheats * { u32 name, u32 first line, u32 line count }
+#   lines  * { u32 string }
+#   string pool, nul terminated utf-8 strings addressed by offset
+#
+# 3ds titles have no build ids, their cheats are stored in a single unnamed build.
+
+import argparse
+import bz2
+import json
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+MAGIC = b"CKDB"
+VERSION = 1
+
+# keep in sync with Compression::codec_t in common/compression.hpp
+CODEC_NONE = 0
+CODEC_BZIP2 = 1
+CODEC_LZ4 = 2
+CODEC_ZSTD = 3
+
+
+def lz4_compress(data):
+    # prefer the lz4 module when it is installed, it is much faster and compresses better
+    try:
+        import lz4.block
+
+        return lz4.block.compress(bytes(data), mode="high_compression", compression=12, store_size=False)
+    except ImportError:
+        pass
+
+    # greedy raw lz4 block encoder
+    data = bytes(data)
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+
+    def emit(literals, offset=0, length=0):
+        token_lit = min(len(literals), 15)
+        token_match = min(length - 4, 15) if offset else 0
+        out.append((token_lit << 4) | token_match)
+        if token_lit == 15:
+            rest = len(literals) - 15
+            while rest >= 255:
+                out.append(255)
+                rest -= 255
+            out.append(rest)
+        out.extend(literals)
+        if offset:
+            out.extend(struct.pack("<H", offset))
+            if token_match == 15:
+                rest = length - 4 - 15
+                while rest >= 255:
+                    out.append(255)
+                    rest -= 255
+                out.append(rest)
+
+    # the last match has to start 12 bytes before the end and the last 5 bytes are always literals
+    while i + 12 <= n:
+        key = data[i : i + 4]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is not None and i - candidate <= 0xFFFF:
+            length = 4
+            limit = n - 5 - i
+            while length < limit and data[candidate + length] == data[i + length]:
+                length += 1
+            emit(data[anchor:i], i - candidate, length)
+            i += length
+            anchor = i
+        else:
+            i += 1
+    emit(data[anchor:])
+    return bytes(out)
+
+
+def zstd_compress(data):
+    import zstandard
+
+    return zstandard.ZstdCompressor(level=19).compress(bytes(data))
+
+
+CODECS = {
+    "none": (CODEC_NONE, lambda data: bytes(data)),
+    "bzip2": (CODEC_BZIP2, lambda data: bz2.compress(data, 9)),
+    "lz4": (CODEC_LZ4, lz4_compress),
+    "zstd": (CODEC_ZSTD, zstd_compress),
+}
+
+
+class StringPool:
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, string):
+        offset = self.offsets.get(string)
+        if offset is None:
+            offset = len(self.data)
+            self.offsets[string] = offset
+            self.data += string.encode("utf-8") + b"\0"
+        return offset
+
+
+def encode_title(title):
+    # normalize both layouts to a list of (build id, {cheat name: lines}), sorted like the json objects used to be
+    if all(isinstance(value, list) for value in title.values()):
+        builds = [("", title)]
+    else:
+        builds = sorted(((buildid, cheats) for buildid, cheats in title.items() if isinstance(cheats, dict)), key=lambda build: build[0])
+
+    pool = StringPool()
+    build_table = bytearray()
+    cheat_table = bytearray()
+    line_table = bytearray()
+    cheat_count = 0
+    line_count = 0
+
+    for buildid, cheats in builds:
+        build_table += struct.pack("<III", pool.add(buildid), cheat_count, len(cheats))
+        for name, lines in sorted(cheats.items()):
+            cheat_table += struct.pack("<III", pool.add(name), line_count, len(lines))
+            for line in lines:
+                line_table += struct.pack("<I", pool.add(line))
+            line_count += len(lines)
+        cheat_count += len(cheats)
+
+    return struct.pack("<III", len(builds), cheat_count, line_count) + build_table + cheat_table + line_table + pool.data
+
+
+def compare(ids, blocks, bench):
+    # sizes of every codec usable on this host. timings and memory come from tests/compression_bench, which runs the
+    # decoders of common/compression.cpp on the databases written here
+    raw = sum(len(block) for block in blocks)
+    with tempfile.TemporaryDirectory() as directory:
+        paths = []
+        for name, (codec, compress) in sorted(CODECS.items(), key=lambda codec: codec[1][0]):
+            try:
+                compressed = [compress(block) for block in blocks]
+            except ImportError as e:
+                print("cheatdb: %-6s unavailable (%s)" % (name, e))
+                continue
+            size = sum(len(block) for block in compressed)
+            print("cheatdb: %-6s %10d bytes  ratio %5.2f" % (name, size, raw / max(size, 1)))
+            paths.append(os.path.join(directory, "%s.bin" % name))
+            write_database(paths[-1], codec, ids, blocks, compressed)
+
+        if bench is None:
+            print("cheatdb: pass --bench with the path of compression_bench (cmake -S tests) for decompression timings")
+        else:
+            subprocess.run([bench] + paths, check=False)
+
+
+# the consoles refuse blocks that decode to more than this, see MAX_BLOCK_SIZE in common/cheatdatabase.cpp
+MAX_BLOCK_SIZE = 0x1000000
+
+
+def write_database(path, codec, ids, encoded, compressed):
+    for titleid, block in zip(ids, encoded):
+        if len(block) > MAX_BLOCK_SIZE:
+            raise ValueError("cheats of title %016X decode to %d bytes, more than the consoles accept" % (titleid, len(block)))
+    header_size = 16
+    index_size = 24 * len(ids)
+    index = bytearray()
+    offset = header_size + index_size
+    for titleid, block, packed in zip(ids, encoded, compressed):
+        index += struct.pack("<QIIII", titleid, offset, len(packed), len(block), 0)
+        offset += len(packed)
+
+    with open(path, "wb") as f:
+        f.write(MAGIC + struct.pack("<HHII", VERSION, codec, len(ids), 0))
+        f.write(index)
+        for packed in compressed:
+            f.write(packed)
+    return offset
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the Checkpoint binary cheat database.")
+    parser.add_argument("input", help="sharkive json database")
+    parser.add_argument("output", help="binary database to write")
+    parser.add_argument("--codec", choices=sorted(CODECS.keys()), default="lz4", help="per-title block compression")
+    parser.add_argument("--compare", action="store_true", help="report the size of every codec")
+    parser.add_argument("--bench", help="compression_bench binary that times the console decoders for --compare")
+    args = parser.parse_args()
+
+    with open(args.input, "r", encoding="utf-8") as f:
+        database = json.load(f)
+
+    codec, compress = CODECS[args.codec]
+
+    titles = []
+    for key, title in database.items():
+        try:
+            titleid = int(key, 16)
+        except ValueError:
+            print("cheatdb: skipping invalid title id %s" % key, file=sys.stderr)
+            continue
+        titles.append((titleid, title))
+    titles.sort(key=lambda entry: entry[0])
+
+    ids = [titleid for titleid, _ in titles]
+    encoded = [encode_title(title) for _, title in titles]
+    size = write_database(args.output, codec, ids, encoded, [compress(block) for block in encoded])
+
+    raw_size = sum(len(block) for block in encoded)
+    print("cheatdb: %d titles, %d bytes (%d uncompressed, %s)" % (len(titles), size, raw_size, args.codec))
+
+    if args.compare:
+        compare(ids, encoded, args.bench)
+
+
+if __name__ == "__main__":
+    main()